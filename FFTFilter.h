@@ -0,0 +1,297 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef FFTFILTER_H
+#define FFTFILTER_H 1
+
+// FFTFilter.h : FIR filtering by the overlap-save method (fast convolution using the FFT).
+// For long filters, this is much cheaper than direct-form convolution (see FIRFilter.h)
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define FFTFILTER_BREAKEVEN_TAPS 128 // (measured with --benchmark) filter length above which FFTFilter outperforms FIRFilter (at 1:1 ratio)
+
+namespace ReSampler {
+
+	// FFTFilter : alternative to the block interface of FIRFilter (ie put(values, n) / getAt(age, subfilter)),
+	// in which the outputs for all the samples of a block are calculated together, in the frequency domain.
+	// As with FIRFilter, the taps may be decomposed into numSubfilters polyphase components.
+	// Only the components whose index is a multiple of subfilterStep are calculated
+	// (when L and M share a common factor, the other components are never asked for).
+	// Calculations are done in double precision, regardless of FloatType.
+
+	template <typename FloatType>
+	class FFTFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		FFTFilter() : length(0), numSubfilters(1), subfilterStep(1), numComputedSubfilters(0),
+			fftSize(0), blockSize(0), lastBlockSize(0), x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{}
+
+		FFTFilter(const FloatType* taps, int numTaps, int numSubfilters = 1, int subfilterStep = 1) :
+			length((numTaps + numSubfilters - 1) / numSubfilters), numSubfilters(numSubfilters), subfilterStep(subfilterStep),
+			numComputedSubfilters((numSubfilters + subfilterStep - 1) / subfilterStep),
+			fftSize(calcFFTSize(length)), blockSize(fftSize - length + 1), lastBlockSize(0),
+			x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{
+			allocateBuffers();
+
+			forwardPlan.reset(fftw_plan_dft_r2c_1d(fftSize, x, X, FFTW_ESTIMATE), fftw_destroy_plan);
+			inversePlan.reset(fftw_plan_dft_c2r_1d(fftSize, Y, y, FFTW_ESTIMATE), fftw_destroy_plan);
+
+			// calculate the frequency response of each (computed) subfilter, with the 1/fftSize scaling of the inverse FFT folded in.
+			// Note: the taps are paired with the signal history in exactly the same way as FIRFilter (including the rotation by one)
+			const int numBins = fftSize / 2 + 1;
+			const double scale = 1.0 / fftSize;
+			auto responses = std::make_shared<std::vector<double>>(static_cast<size_t>(2 * numBins * numComputedSubfilters));
+			for (int c = 0; c < numComputedSubfilters; c++) {
+				int s = c * subfilterStep;
+				std::fill(x, x + fftSize, 0.0);
+				for (int i = 0; i < length; ++i) {
+					int t = s + i * numSubfilters; // corresponding position in zero-stuffed history
+					x[i] = (t < numTaps) ? scale * taps[(t + 1) % numTaps] : 0.0;
+				}
+				fftw_execute_dft_r2c(forwardPlan.get(), x, X);
+				memcpy(responses->data() + 2 * numBins * c, X, numBins * sizeof(fftw_complex));
+			}
+			H = std::move(responses);
+
+			output.resize(static_cast<size_t>(blockSize * numComputedSubfilters));
+			reset();
+		}
+
+		// deconstructor:
+		~FFTFilter() {
+			freeBuffers();
+		}
+
+		// copy constructor: (the plans and the frequency responses are shared, but not the buffers)
+		FFTFilter(const FFTFilter& other) :
+			length(other.length), numSubfilters(other.numSubfilters), subfilterStep(other.subfilterStep),
+			numComputedSubfilters(other.numComputedSubfilters), fftSize(other.fftSize), blockSize(other.blockSize),
+			lastBlockSize(other.lastBlockSize), forwardPlan(other.forwardPlan), inversePlan(other.inversePlan),
+			H(other.H), output(other.output), x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{
+			allocateBuffers();
+			copyBuffers(other);
+		}
+
+		// move constructor:
+		FFTFilter(FFTFilter&& other) noexcept :
+			length(other.length), numSubfilters(other.numSubfilters), subfilterStep(other.subfilterStep),
+			numComputedSubfilters(other.numComputedSubfilters), fftSize(other.fftSize), blockSize(other.blockSize),
+			lastBlockSize(other.lastBlockSize), forwardPlan(std::move(other.forwardPlan)), inversePlan(std::move(other.inversePlan)),
+			H(std::move(other.H)), output(std::move(other.output)), x(other.x), y(other.y), X(other.X), Y(other.Y)
+		{
+			other.x = nullptr;
+			other.y = nullptr;
+			other.X = nullptr;
+			other.Y = nullptr;
+		}
+
+		// copy assignment:
+		FFTFilter& operator= (const FFTFilter& other)
+		{
+			if (this != &other) {
+				freeBuffers();
+				copyParameters(other);
+				forwardPlan = other.forwardPlan;
+				inversePlan = other.inversePlan;
+				H = other.H;
+				output = other.output;
+				allocateBuffers();
+				copyBuffers(other);
+			}
+			return *this;
+		}
+
+		// move assignment:
+		FFTFilter& operator= (FFTFilter&& other) noexcept
+		{
+			if (this != &other) {
+				freeBuffers();
+				copyParameters(other);
+				forwardPlan = std::move(other.forwardPlan);
+				inversePlan = std::move(other.inversePlan);
+				H = std::move(other.H);
+				output = std::move(other.output);
+				x = other.x;
+				y = other.y;
+				X = other.X;
+				Y = other.Y;
+				other.x = nullptr;
+				other.y = nullptr;
+				other.X = nullptr;
+				other.Y = nullptr;
+			}
+			return *this;
+		}
+
+		void reset() {
+			lastBlockSize = 0;
+			if (x != nullptr) {
+				std::fill(x, x + fftSize, 0.0);
+			}
+			std::fill(output.begin(), output.end(), 0.0);
+		}
+
+		// put() : puts values[0] ... values[n - 1] (n must not exceed getBlockSize()), and calculates
+		// the outputs (of each computed subfilter) for every sample in the block
+		void put(const FloatType* values, int n) {
+			assert(n <= blockSize);
+			const int historyLength = length - 1;
+
+			// x = [ historyLength previous samples | n new samples | (stale) ]
+			// (in overlap-save, the stale part only affects outputs which are discarded)
+			double* p = x + historyLength;
+			for (int i = 0; i < n; i++) {
+				p[i] = values[i];
+			}
+
+			fftw_execute_dft_r2c(forwardPlan.get(), x, X);
+
+			const int numBins = fftSize / 2 + 1;
+			for (int c = 0; c < numComputedSubfilters; c++) {
+				const double* h = H->data() + 2 * numBins * c;
+				for (int k = 0; k < numBins; k++) {
+					double re = X[k][0] * h[2 * k] - X[k][1] * h[2 * k + 1];
+					double im = X[k][0] * h[2 * k + 1] + X[k][1] * h[2 * k];
+					Y[k][0] = re;
+					Y[k][1] = im;
+				}
+				fftw_execute_dft_c2r(inversePlan.get(), Y, y);
+				FloatType* out = output.data() + blockSize * c;
+				for (int i = 0; i < n; i++) {
+					out[i] = static_cast<FloatType>(y[historyLength + i]);
+				}
+			}
+
+			// keep the most recent (length - 1) samples as the history for the next block
+			memmove(x, x + n, historyLength * sizeof(double));
+			lastBlockSize = n;
+		}
+
+		int getBlockSize() const {
+			return blockSize;
+		}
+
+		// getAt() : returns the output of the subfilter for the sample which was put age samples ago.
+		// (Only valid for samples in the block most recently put, and subfilters which are a multiple of subfilterStep)
+		FloatType getAt(int age, int subfilter = 0) const {
+			assert(age < lastBlockSize && subfilter % subfilterStep == 0);
+			return output[blockSize * (subfilter / subfilterStep) + lastBlockSize - 1 - age];
+		}
+
+		// getAt4() : same as FIRFilter::getAt4() (for FFTFilter, the outputs are already calculated)
+		void getAt4(const int* ages, int subfilter, FloatType* out, int outStride) const {
+			for (int j = 0; j < 4; j++) {
+				out[j * outStride] = getAt(ages[j], subfilter);
+			}
+		}
+
+		// getKernelBytes() : memory used by the frequency responses (which are shared by all copies of the filter)
+		size_t getKernelBytes() const {
+			return H ? H->size() * sizeof(double) : 0;
+		}
+
+		// getStateBytes() : memory used by the buffers (of this copy of the filter)
+		size_t getStateBytes() const {
+			return static_cast<size_t>(2 * fftSize) * sizeof(double) + static_cast<size_t>(2 * (fftSize / 2 + 1)) * sizeof(fftw_complex)
+					+ output.size() * sizeof(FloatType);
+		}
+
+		// estimateCost() : estimated amount of work per input sample (proportional to N.log2(N) per block)
+		// for a filter with the given subfilter length and number of computed subfilters,
+		// when it is given blocks of (at most) maxBlockSize samples (0: as many as it can take)
+		static double estimateCost(int length, int numComputedSubfilters, int maxBlockSize = 0) {
+			int fftSize = calcFFTSize(length);
+			int blockSize = fftSize - length + 1;
+			if (maxBlockSize > 0) {
+				blockSize = std::min(blockSize, maxBlockSize);
+			}
+			return (1 + numComputedSubfilters) * fftSize * std::log2(fftSize) / blockSize;
+		}
+
+	private:
+		int length;					// length of each subfilter
+		int numSubfilters;
+		int subfilterStep;
+		int numComputedSubfilters;
+		int fftSize;
+		int blockSize;				// maximum number of samples per block
+		int lastBlockSize;			// number of samples in the block most recently put
+		std::shared_ptr<fftw_plan_s> forwardPlan;
+		std::shared_ptr<fftw_plan_s> inversePlan;
+		std::shared_ptr<const std::vector<double>> H;	// frequency response of each computed subfilter (interleaved re, im), shared by copies
+		std::vector<FloatType> output;
+		double* x;					// time-domain input (history + current block)
+		double* y;					// time-domain output
+		fftw_complex* X;
+		fftw_complex* Y;
+
+		// calcFFTSize() : smallest power of 2 which is at least 8 times the filter length
+		static int calcFFTSize(int length) {
+			int size = 64;
+			while (size < 8 * length) {
+				size <<= 1;
+			}
+			return size;
+		}
+
+		void copyParameters(const FFTFilter& other) {
+			length = other.length;
+			numSubfilters = other.numSubfilters;
+			subfilterStep = other.subfilterStep;
+			numComputedSubfilters = other.numComputedSubfilters;
+			fftSize = other.fftSize;
+			blockSize = other.blockSize;
+			lastBlockSize = other.lastBlockSize;
+		}
+
+		void allocateBuffers() {
+			if (fftSize == 0) {
+				return;
+			}
+			x = fftw_alloc_real(static_cast<size_t>(fftSize));
+			y = fftw_alloc_real(static_cast<size_t>(fftSize));
+			X = fftw_alloc_complex(static_cast<size_t>(fftSize / 2 + 1));
+			Y = fftw_alloc_complex(static_cast<size_t>(fftSize / 2 + 1));
+		}
+
+		void copyBuffers(const FFTFilter& other) {
+			if (fftSize == 0) {
+				return;
+			}
+			memcpy(x, other.x, fftSize * sizeof(double));
+		}
+
+		void freeBuffers() {
+			fftw_free(x);
+			fftw_free(y);
+			fftw_free(X);
+			fftw_free(Y);
+			x = nullptr;
+			y = nullptr;
+			X = nullptr;
+			Y = nullptr;
+		}
+	};
+
+} // namespace ReSampler
+
+#endif // FFTFILTER_H
@@ -14,6 +14,8 @@
 
 #include "alignedmalloc.h"
 #include "factorial.h"
+#include "mirroredbuffer.h"
+#include "simd.h"
 
 #include <typeinfo>
 #include <algorithm>
@@ -23,6 +25,8 @@
 #include <cstring>
 #include <cstdint>
 #include <cassert>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #if defined(__ANDROID__)
@@ -33,23 +37,13 @@
 
 #include <fftw3.h>
 
-#define WRAP_WITH_MEMCPY
 #define FILTERSIZE_LIMIT 131071
 #define FILTERSIZE_BASE 103
+#define FIR_BLOCKSIZE 4096 // minimum number of samples which can be put() as a single block
+#define FIR_MIRRORED_HISTORY_MIN_TAPS 32768 // filter length from which a mirrored (ring) buffer is used for the signal history, when enabled (see mirroredbuffer.h)
+#define FIR_SINGLE_KERNEL_MIN_BYTES (1 << 20) // (measured with --benchmark) size of the shifted kernel copies above which a single copy is kept instead
 
-#ifdef USE_AVX
-#define ALIGNMENT_SIZE 32
-#include <immintrin.h>
-
-#else
-
-#define ALIGNMENT_SIZE 16
-
-#if (defined(_M_X64) || defined(__x86_64__) || defined(USE_SSE2)) // All x64 CPUs have SSE2 instructions, but some older 32-bit CPUs do not. 
-	#include <xmmintrin.h>
-	#define USE_SIMD 1 // Vectorise main loop in FIRFilter::get() by using SSE2 SIMD instrinsics
-	#define USE_SIMD_FOR_DOUBLES
-#endif
+#define ALIGNMENT_SIZE 64 // (large enough for the widest vectors used at any SIMD level: see simd.h)
 
 #if defined (__MINGW64__) || defined (__MINGW32__) || defined (__GNUC__)
 #ifdef USE_QUADMATH
@@ -59,41 +53,93 @@
 #endif
 #endif
 #endif
-#endif
 
 namespace ReSampler {
 
+	// FIRKernelLayout : how FIRFilter stores its kernel
+	enum FIRKernelLayout {
+		KernelLayoutAuto,			// chosen according to the size of the kernel (see FIR_SINGLE_KERNEL_MIN_BYTES)
+		KernelLayoutShiftedCopies,	// one copy of the kernel for each alignment shift, so that both kernel and signal are loaded aligned
+		KernelLayoutSingleCopy		// a single (aligned) copy of the kernel, with unaligned loads of the signal
+	};
+
 	template <typename FloatType>
 	class FIRFilter {
 
 	public:
 
 		// constructor:
-		FIRFilter(const FloatType* taps, int length) :
-			length(length), signal(nullptr), currentIndex(length-1), lastPut(0)
+		// When numSubfilters > 1, the taps are decomposed into numSubfilters polyphase components
+		// (each of length ceil(numTaps / numSubfilters)), which all share the one signal history.
+		// get(n) then returns the output of the nth component, which is identical to the output
+		// that a zero-stuffed (interpolating) filter would produce n samples after the most recent put().
+		// The dot-product kernel (and the matching data layout) is chosen according to the SIMD level in effect at the time of construction.
+		// If symmetric is true, the caller guarantees that the taps are symmetric (ie linear-phase), and (provided there is only one subfilter)
+		// only the first half of the kernel is stored, and each output takes half the multiplies (see getAt()).
+		// The kernel is immutable once constructed, and is shared (rather than copied) by copies of the filter;
+		// each copy has its own signal history.
+		// layout determines whether a copy of the kernel is kept for each alignment shift (see FIRKernelLayout).
+		// A single-precision filter constructed while wide accumulation is selected (see setWideAccumulation()) accumulates in double precision.
+		FIRFilter(const FloatType* taps, int numTaps, int numSubfilters = 1, bool symmetric = false, FIRKernelLayout layout = KernelLayoutAuto) :
+			length((numTaps + numSubfilters - 1) / numSubfilters), numSubfilters(numSubfilters),
+			blockSize(std::max(length, FIR_BLOCKSIZE)), simdLevel(getSimdLevel()), symmetric(symmetric),
+			singleKernelCopy((layout == KernelLayoutAuto) ? preferSingleKernelCopy(numTaps, simdLevel) : (layout == KernelLayoutSingleCopy)),
+			wideAccumulation(getWideAccumulation() && std::is_same<FloatType, float>::value),
+			dotProduct(getDotProductFunction<FloatType>(simdLevel)), dotProductUnaligned(getDotProductUnalignedFunction<FloatType>(simdLevel)),
+			dotProduct4(getDotProduct4Function<FloatType>(simdLevel)),
+			dotProductSymmetric(getDotProductSymmetricFunction<FloatType>(simdLevel)),
+			dotProductSymmetric4(getDotProductSymmetric4Function<FloatType>(simdLevel)),
+			signal(nullptr), currentIndex(blockSize - 1), lastPutAge(0)
 
 		{
-			calcPaddedLength();
-
-			for(int i = 0; i < numVecElements; i++) {
-				kernelphases[i] = nullptr;
+			if (wideAccumulation) {
+				selectWideAccumulationKernels();
 			}
+			calcPaddedLength();
 
-			allocateBuffers();
-			assertAlignment();
-			clearBuffers();
+			allocateBuffers(length >= FIR_MIRRORED_HISTORY_MIN_TAPS, 0);
+			std::shared_ptr<KernelStorage> storage = std::make_shared<KernelStorage>(numKernelCopies(), kernelSize());
+			FloatType* const* newPhases = storage->phases;
+
+			// initialize filter kernel(s).
+			// Note: kernel[i] is paired with the ith most recent sample.
+			// The taps are rotated by one (ie taps[1] is paired with the most recent sample, and taps[0] with the oldest),
+			// which is the alignment this filter has always had.
+
+			if (this->symmetric) {
+				// Because of the rotation, it is kernel[0] ... kernel[length - 3] (ie taps[1] ... taps[numTaps - 2]) which is symmetric.
+				// Store the first half of it (with the centre tap halved, as it gets paired with itself),
+				// and keep the last two taps of the kernel (taps[numTaps - 1] and taps[0]) separately.
+				const int coreLength = length - 2;
+				FloatType* halfKernel = newPhases[0];
+				for (int i = 0; i < (coreLength + 1) / 2; ++i) {
+					halfKernel[i] = taps[i + 1];
+				}
+				if (coreLength & 1) {
+					halfKernel[coreLength / 2] *= 0.5;
+				}
+				tailTaps[0] = taps[numTaps - 1];
+				tailTaps[1] = taps[0];
+			} else {
+				for (int s = 0; s < numSubfilters; s++) {
+					FloatType* kernel = newPhases[0] + s * paddedLength;
+					for (int i = 0; i < length; ++i) {
+						int t = s + i * numSubfilters; // corresponding position in zero-stuffed history
+						kernel[i] = (t < numTaps) ? taps[(t + 1) % numTaps] : 0.0;
+					}
+				}
 
-			// initialize filter kernel and signal buffers
-			for (int i = 0; i < length; ++i) {
-				kernelphases[0][i] = taps[i];
-				signal[i] = 0.0;
-				signal[i + length] = 0.0;
+				// Populate additional kernel Phases: (if any)
+				for(int n = 1; n < numKernelCopies(); n++) {
+					for (int s = 0; s < numSubfilters; s++) {
+						memcpy(1 + newPhases[n] + s * paddedLength, newPhases[n - 1] + s * paddedLength, (length + n - 1) * sizeof(FloatType));
+					}
+				}
 			}
 
-			// Populate additional kernel Phases:
-			for(int n = 1; n < numVecElements; n++) {
-				memcpy(1 + kernelphases[n], kernelphases[n - 1], (length - 1) * sizeof(FloatType));
-			}
+			kernelStorage = std::move(storage);
+			setKernelPhases();
+			assertAlignment();
 		}
 
 		// deconstructor:
@@ -101,26 +147,35 @@ namespace ReSampler {
 			freeBuffers();
 		}
 
-		// copy constructor:
-		FIRFilter(const FIRFilter& other) : length(other.length), currentIndex(other.currentIndex), lastPut(other.lastPut)
+		// copy constructor: (the kernel is shared, but not the signal history)
+		FIRFilter(const FIRFilter& other) : length(other.length), numSubfilters(other.numSubfilters), blockSize(other.blockSize),
+			simdLevel(other.simdLevel), symmetric(other.symmetric), singleKernelCopy(other.singleKernelCopy), wideAccumulation(other.wideAccumulation),
+			dotProduct(other.dotProduct), dotProductUnaligned(other.dotProductUnaligned), dotProduct4(other.dotProduct4),
+			dotProductSymmetric(other.dotProductSymmetric), dotProductSymmetric4(other.dotProductSymmetric4),
+			currentIndex(other.currentIndex), lastPutAge(other.lastPutAge), kernelStorage(other.kernelStorage)
 		{
+			tailTaps[0] = other.tailTaps[0];
+			tailTaps[1] = other.tailTaps[1];
 			calcPaddedLength();
-			allocateBuffers();
+			allocateBuffers(other.ringSize != 0, other.bufferLength);
+			setKernelPhases();
 			assertAlignment();
 			copyBuffers(other);
 		}
 
 		// move constructor:
 		FIRFilter(FIRFilter&& other) noexcept :
-			length(other.length), signal(other.signal), currentIndex(other.currentIndex), lastPut(other.lastPut)
+			length(other.length), numSubfilters(other.numSubfilters), blockSize(other.blockSize),
+			simdLevel(other.simdLevel), symmetric(other.symmetric), singleKernelCopy(other.singleKernelCopy), wideAccumulation(other.wideAccumulation),
+			dotProduct(other.dotProduct), dotProductUnaligned(other.dotProductUnaligned), dotProduct4(other.dotProduct4),
+			dotProductSymmetric(other.dotProductSymmetric), dotProductSymmetric4(other.dotProductSymmetric4),
+			signal(other.signal), ringSize(other.ringSize), bufferLength(other.bufferLength),
+			currentIndex(other.currentIndex), lastPutAge(other.lastPutAge), kernelStorage(std::move(other.kernelStorage))
 		{
+			tailTaps[0] = other.tailTaps[0];
+			tailTaps[1] = other.tailTaps[1];
 			calcPaddedLength();
-
-			for(int i = 0; i < numVecElements; i++) {
-				kernelphases[i] = other.kernelphases[i];
-				other.kernelphases[i] = nullptr;
-			}
-
+			setKernelPhases();
 			other.signal = nullptr;
 			assertAlignment();
 		}
@@ -129,11 +184,26 @@ namespace ReSampler {
 		FIRFilter& operator= (const FIRFilter& other)
 		{
 			length = other.length;
+			numSubfilters = other.numSubfilters;
+			blockSize = other.blockSize;
+			freeBuffers(); // (note: must be done before the layout changes)
+			simdLevel = other.simdLevel;
+			symmetric = other.symmetric;
+			singleKernelCopy = other.singleKernelCopy;
+			wideAccumulation = other.wideAccumulation;
+			dotProduct = other.dotProduct;
+			dotProductUnaligned = other.dotProductUnaligned;
+			dotProduct4 = other.dotProduct4;
+			dotProductSymmetric = other.dotProductSymmetric;
+			dotProductSymmetric4 = other.dotProductSymmetric4;
+			tailTaps[0] = other.tailTaps[0];
+			tailTaps[1] = other.tailTaps[1];
 			calcPaddedLength();
 			currentIndex = other.currentIndex;
-			lastPut = other.lastPut;
-			freeBuffers();
-			allocateBuffers();
+			lastPutAge = other.lastPutAge;
+			kernelStorage = other.kernelStorage;
+			allocateBuffers(other.ringSize != 0, other.bufferLength);
+			setKernelPhases();
 			assertAlignment();
 			copyBuffers(other);
 			return *this;
@@ -145,17 +215,29 @@ namespace ReSampler {
 			if(this != &other) // prevent self-assignment
 			{
 				length = other.length;
+				numSubfilters = other.numSubfilters;
+				blockSize = other.blockSize;
+				freeBuffers(); // (note: must be done before the layout changes)
+				simdLevel = other.simdLevel;
+				symmetric = other.symmetric;
+				singleKernelCopy = other.singleKernelCopy;
+				wideAccumulation = other.wideAccumulation;
+				dotProduct = other.dotProduct;
+				dotProductUnaligned = other.dotProductUnaligned;
+				dotProduct4 = other.dotProduct4;
+				dotProductSymmetric = other.dotProductSymmetric;
+				dotProductSymmetric4 = other.dotProductSymmetric4;
+				tailTaps[0] = other.tailTaps[0];
+				tailTaps[1] = other.tailTaps[1];
 				calcPaddedLength();
 				currentIndex = other.currentIndex;
-				lastPut = other.lastPut;
-
-				freeBuffers();
+				lastPutAge = other.lastPutAge;
 
 				signal = other.signal;
-				for(int i = 0; i < numVecElements; i++) {
-					kernelphases[i] = other.kernelphases[i];
-					other.kernelphases[i] = nullptr;
-				}
+				ringSize = other.ringSize;
+				bufferLength = other.bufferLength;
+				kernelStorage = std::move(other.kernelStorage);
+				setKernelPhases();
 				other.signal = nullptr;
 				assertAlignment();
 			}
@@ -164,10 +246,13 @@ namespace ReSampler {
 
 		bool operator== (const FIRFilter& other) const
 		{
-			if (length != other.length)
+			if (length != other.length || numSubfilters != other.numSubfilters || symmetric != other.symmetric)
 				return false;
 
-			for (int i = 0; i < paddedLength; i++) {
+			if (kernelStorage == other.kernelStorage)
+				return true;
+
+			for (int i = 0; i < kernelSize(); i++) {
 				if (kernelphases[0][i] != other.kernelphases[0][i])
 					return false;
 			}
@@ -177,220 +262,348 @@ namespace ReSampler {
 
 		void reset() {
 			// reset indexes:
-			currentIndex = length - 1;
-			lastPut = 0;
+			currentIndex = blockSize - 1;
+			lastPutAge = 0;
 
 			// clear signal buffer
-			for (int i = 0; i < paddedLength; ++i) {
-				signal[i] = 0.0;
-				signal[i + length] = 0.0;
-			}
+			memset(signal, 0, storedLength() * sizeof(FloatType));
 		}
 
 		void put(FloatType value) { // Put signal in reverse order.
-			signal[currentIndex] = value;
+			makeRoom(1);
+			signal[currentIndex--] = value;
+			lastPutAge = 0;
+		}
 
-	#ifndef WRAP_WITH_MEMCPY
-			signal[currentIndex + length] = value;
-	#endif
+		// putZero() : puts a (stuffed) zero.
+		// When there are subfilters, the zero isn't stored: it just advances the phase used by lazyGet()
+		void putZero() {
+			if (numSubfilters == 1) {
+				makeRoom(1);
+				signal[currentIndex--] = 0.0;
+			}
+			++lastPutAge;
+		}
 
-			lastPut = currentIndex;
-			if (currentIndex == 0) {
-				currentIndex = length - 1; // Wrap
+		// put() : block version.
+		// Puts values[0] ... values[n - 1] (n must not exceed getBlockSize()).
+		// Once put, the history of the whole block is contiguous, so the output corresponding to each sample in the block
+		// can be obtained with getAt(n - 1 - i, subfilter)
+		void put(const FloatType* values, int n) {
+			assert(n <= blockSize);
+			makeRoom(n);
+			FloatType* p = signal + currentIndex;
+			for (int i = 0; i < n; i++) {
+				*p-- = values[i];
+			}
+			currentIndex -= n;
+			lastPutAge = 0;
+		}
 
-	#ifdef WRAP_WITH_MEMCPY
-				memcpy(signal + length, signal, length * sizeof(FloatType)); // copy history to upper half of buffer
-	#endif
+		int getBlockSize() const {
+			return blockSize;
+		}
 
-			}
-			else
-				--currentIndex;
+		bool isSymmetric() const {
+			return symmetric;
 		}
 
-		void putZero() {
-			signal[currentIndex] = 0.0;
+		// hasWideAccumulation() : true if the (single-precision) filter accumulates in double precision (see setWideAccumulation())
+		bool hasWideAccumulation() const {
+			return wideAccumulation;
+		}
 
-	#ifndef WRAP_WITH_MEMCPY
-			signal[currentIndex + length] = 0.0;
-	#endif
+		// hasMirroredHistory() : true if the signal history is a mirrored (ring) buffer (see mirroredbuffer.h)
+		bool hasMirroredHistory() const {
+			return ringSize != 0;
+		}
 
-			if (currentIndex == 0) {
-				currentIndex = length - 1; // Wrap
+		// hasSingleKernelCopy() : true if only one copy of the kernel is stored (see FIRKernelLayout)
+		bool hasSingleKernelCopy() const {
+			return numKernelCopies() == 1;
+		}
 
-	#ifdef WRAP_WITH_MEMCPY
-				memcpy(signal + length, signal, length * sizeof(FloatType)); // copy history to upper half of buffer
-	#endif
+		// getKernelBytes() : memory used by the kernel (which is shared by all copies of the filter)
+		size_t getKernelBytes() const {
+			return static_cast<size_t>(numKernelCopies()) * kernelSize() * sizeof(FloatType);
+		}
 
-			}
-			else
-				--currentIndex;
+		// getStateBytes() : memory used by the signal history (of this copy of the filter)
+		size_t getStateBytes() const {
+			return storedLength() * sizeof(FloatType);
+		}
+
+		FloatType get(int subfilter = 0) {
+			return getAt(0, subfilter);
 		}
 
-		FloatType get() {
+		// getAt() : returns the output of the filter (or subfilter) as it was when the sample which was put age samples ago
+		// was the most recent sample. (Only valid for samples in the block most recently put, or later.)
+		FloatType getAt(int age, int subfilter = 0) {
+
+			int start = currentIndex + 1 + age; // position of most recent sample
 
 	#ifdef FIR_QUAD_PRECISION
 
 			// scalar processing of quad-precision types
 			__float128 output = 0.0Q;
-			int index = currentIndex;
+			int index = start;
+			const FloatType* kernel = kernelphases[0] + subfilter * paddedLength;
+			if (symmetric) {
+				const FloatType* history = signal + start;
+				const int coreLength = length - 2;
+				for (int i = 0; i < halfLength; ++i) {
+					output += ((__float128)history[i] + (__float128)history[coreLength - 1 - i]) * (__float128)kernel[i];
+				}
+				output += (__float128)history[coreLength] * (__float128)tailTaps[0] + (__float128)history[coreLength + 1] * (__float128)tailTaps[1];
+				return static_cast<FloatType>(output);
+			}
 			for (int i = 0; i < length; ++i) {
-				output += (__float128)signal[index] * (__float128)kernelphases[0][i];
+				output += (__float128)signal[index] * (__float128)kernel[i];
 				index++;
 			}
 
-	#elif defined(USE_AVX)
-
-			// AVX processing of float types
-
-			FloatType output = 0.0;
-			int index = currentIndex & -8; // make multiple-of-eight
-			int phase = currentIndex & 7;
-			FloatType* kernel = kernelphases[phase];
-
-			alignas(ALIGNMENT_SIZE) __m256 s;	// AVX Vector Registers for calculation
-			alignas(ALIGNMENT_SIZE) __m256 k;
-			alignas(ALIGNMENT_SIZE) __m256 product;
-			alignas(ALIGNMENT_SIZE) __m256 accumulator = _mm256_setzero_ps();
-
-			for (int i = 0; i < paddedLength; i += 8) {
-				s = _mm256_load_ps(signal + index + i);
-				k = _mm256_load_ps(kernel + i);
+			return static_cast<FloatType>(output);
 
-	#ifdef USE_FMA
-							accumulator = _mm256_fmadd_ps(s, k, accumulator);
 	#else
-				product = _mm256_mul_ps(s, k);
-				accumulator = _mm256_add_ps(product, accumulator);
-	#endif
 
+			// vectorised (or scalar) dot product, using the kernel for the SIMD level chosen at construction.
+			if (symmetric) {
+				// each pair of samples which share a tap is added before multiplying (the signal is read unaligned)
+				const FloatType* history = signal + start;
+				const int coreLength = length - 2;
+				return dotProductSymmetric(history, kernelphases[0], halfLength, coreLength)
+						+ history[coreLength] * tailTaps[0] + history[coreLength + 1] * tailTaps[1];
 			}
 
-			output += sum8floats(accumulator);
+			if (singleKernelCopy) {
+				return dotProductUnaligned(signal + start, kernelphases[0] + subfilter * paddedLength, paddedLength);
+			}
 
-	#elif defined(USE_SIMD)
+			// The signal is read from the aligned position at or before start, using the copy of the kernel
+			// which has been shifted by the same amount.
+			int index = start & -numVecElements;
+			int phase = start & (numVecElements - 1);
+			return dotProduct(signal + index, kernelphases[phase] + subfilter * paddedLength, paddedLength);
 
-			// vector processing of float types (doubles require separate specialisation)
+	#endif
 
-			FloatType output = 0.0;
-			int index = currentIndex & -4; // make multiple-of-four
-			int phase = currentIndex & 3;
-			FloatType* kernel = kernelphases[phase];
-
-			alignas(ALIGNMENT_SIZE) __m128 s;	// SIMD Vector Registers for calculation
-			alignas(ALIGNMENT_SIZE) __m128 k;
-			alignas(ALIGNMENT_SIZE) __m128 product;
-			alignas(ALIGNMENT_SIZE) __m128 accumulator = _mm_setzero_ps();
-
-			for (int i = 0; i < paddedLength; i += 4) {
-				s = _mm_load_ps(signal + index + i);
-				k = _mm_load_ps(kernel + i);
-				product = _mm_mul_ps(s, k);
-				accumulator = _mm_add_ps(product, accumulator);
-			}
+		}
 
-			// http://stackoverflow.com/questions/6996764/fastest-way-to-do-horizontal-float-vector-sum-on-x86
-			__m128 a   = _mm_shuffle_ps(
-				accumulator,
-				accumulator,                 // accumulator = [D     C     | B     A    ]
-				_MM_SHUFFLE(2, 3, 0, 1));                  // [C     D     | A     B    ]
-			__m128 b   = _mm_add_ps(accumulator, a);       // [D+C   C+D   | B+A   A+B  ]
-			a          = _mm_movehl_ps(a, b);              // [C     D     | D+C   C+D  ]
-			b          = _mm_add_ss(a, b);                 // [C     D     | D+C A+B+C+D]
-			output    += _mm_cvtss_f32(b);                 // A+B+C+D
+		// getAt4() : calculates the outputs of the given subfilter for four different ages at once, and writes them to
+		// out[0], out[outStride], out[2 * outStride] and out[3 * outStride].
+		// Each load of the kernel is shared by the four outputs (the signal windows are read with unaligned loads).
+		void getAt4(const int* ages, int subfilter, FloatType* out, int outStride) {
 
+	#ifdef FIR_QUAD_PRECISION
+			for (int j = 0; j < 4; j++) {
+				out[j * outStride] = getAt(ages[j], subfilter);
+			}
 	#else
-			// scalar processing of float or double types
-			FloatType output = 0.0;
-			int index = currentIndex;
-			for (int i = 0; i < length; ++i) {
-				output += signal[index] * kernelphases[0][i];
-				index++;
+			const FloatType* signals[4];
+			for (int j = 0; j < 4; j++) {
+				signals[j] = signal + currentIndex + 1 + ages[j];
+			}
+			FloatType results[4];
+			if (symmetric) {
+				const int coreLength = length - 2;
+				dotProductSymmetric4(kernelphases[0], signals, halfLength, coreLength, results);
+				for (int j = 0; j < 4; j++) {
+					out[j * outStride] = results[j] + signals[j][coreLength] * tailTaps[0] + signals[j][coreLength + 1] * tailTaps[1];
+				}
+				return;
+			}
+			dotProduct4(kernelphases[0] + subfilter * paddedLength, signals, paddedLength, results);
+			for (int j = 0; j < 4; j++) {
+				out[j * outStride] = results[j];
 			}
-
 	#endif
 
-			return static_cast<FloatType>(output);
-
 		}
 
-		FloatType lazyGet(int L) {	// Skips stuffed-zeros introduced by interpolation, by only calculating every Lth sample from lastPut
-			FloatType output = 0.0;
-			int offset = lastPut - currentIndex;
-			if (offset < 0) { // Wrap condition
-				offset += length;
+		// lazyGet() : skips stuffed-zeros introduced by interpolation, by only calculating every Lth sample from lastPut.
+		// If the filter was decomposed into L subfilters, the taps which meet the non-zero samples are already contiguous
+		// (in the subfilter for the current phase), so this is just an ordinary (vectorised) get().
+		FloatType lazyGet(int L) {
+			if (numSubfilters == L) {
+				return get(lastPutAge);
 			}
 
-			for (int i = offset; i < length; i+=L) {
-				output += signal[i + currentIndex] * kernelphases[0][i];
+			assert(!symmetric && numSubfilters == 1);
+			FloatType output = 0.0;
+			const FloatType* history = signal + currentIndex + 1;
+			for (int i = lastPutAge; i < length; i+=L) {
+				output += history[i] * kernelphases[0][i];
 			}
 			return output;
 		}
 
 	private:
-		int length;
+		int length; // length of signal history (and of each subfilter)
+		int numSubfilters;
+		int blockSize;
 		int paddedLength{};
-
-		FloatType* signal; // Double-length signal buffer, to facilitate fast emulation of a circular buffe
-		int currentIndex;
-		int lastPut;
+		SimdLevel simdLevel;
+		bool symmetric; // true if only the first half of the (symmetric) kernel is stored
+		bool singleKernelCopy; // true if there is only one copy of the kernel (rather than one for each alignment shift)
+		bool wideAccumulation; // true if the dot products are accumulated in double precision (single precision only)
+		int halfLength{}; // (symmetric mode) number of taps stored, padded to a multiple of the vector size
+		FloatType tailTaps[2]{}; // (symmetric mode) the two taps following the symmetric part of the kernel
+		DotProductFunction<FloatType> dotProduct;
+		DotProductFunction<FloatType> dotProductUnaligned;
+		DotProduct4Function<FloatType> dotProduct4;
+		DotProductSymmetricFunction<FloatType> dotProductSymmetric;
+		DotProductSymmetric4Function<FloatType> dotProductSymmetric4;
+
+		FloatType* signal; // signal buffer (blockSize + paddedLength), filled in reverse order, to facilitate fast emulation of a circular buffer
+		int ringSize{}; // (mirrored buffer) size of the ring, ie signal[i + ringSize] is the same memory as signal[i]. (0 for an ordinary buffer)
+		int bufferLength{}; // number of elements of signal which can be addressed
+		int currentIndex; // position of next sample to be put
+		int lastPutAge; // number of zeros put since last (non-zero) put
 		int numVecElements{};
 		uintptr_t alignMask{};
 
-		// Polyphase Filter Kernel table:
+		// KernelStorage : owns the copies of the kernel (which are never modified after construction)
+		struct KernelStorage {
+			FloatType* phases[ALIGNMENT_SIZE / sizeof(float)]{};
+			int numCopies;
 
-	#if defined(USE_AVX)
-		FloatType* kernelphases[8]; // note:  will only use half of these if FloatType = double
-	#elif defined(USE_SIMD)
-		FloatType* kernelphases[4]; // note: will only use half of these if FloatType = double
-	#else
-		FloatType* kernelphases[1];
-	#endif
+			KernelStorage(int numCopies, int size) : numCopies(numCopies) {
+				for(int i = 0; i < numCopies; i++) {
+					phases[i] = static_cast<FloatType*>(aligned_malloc(size * sizeof(FloatType), ALIGNMENT_SIZE));
+					memset(phases[i], 0, size * sizeof(FloatType));
+				}
+			}
+
+			~KernelStorage() {
+				for(int i = 0; i < numCopies; i++) {
+					aligned_free(phases[i]);
+				}
+			}
+
+			KernelStorage(const KernelStorage&) = delete;
+			KernelStorage& operator= (const KernelStorage&) = delete;
+		};
+
+		std::shared_ptr<const KernelStorage> kernelStorage; // (shared by all copies of this filter)
+
+		// Polyphase Filter Kernel table: (one copy of the kernel for each alignment shift)
+		const FloatType* kernelphases[ALIGNMENT_SIZE / sizeof(float)]{}; // note: only numVecElements of these are used
 
 		void calcPaddedLength()
 		{
 
-	#if defined(USE_AVX) || defined(USE_SIMD)
-			numVecElements = ALIGNMENT_SIZE / sizeof(FloatType);
-	#else
+	#ifdef FIR_QUAD_PRECISION
 			numVecElements = 1; // Scalar mode
+	#else
+			numVecElements = std::max(1, simdVectorSize(simdLevel) / static_cast<int>(sizeof(FloatType)));
 	#endif
 
 			alignMask = static_cast<uintptr_t>(-numVecElements);
-			paddedLength = (length & alignMask) + numVecElements;
+			paddedLength = singleKernelCopy ?
+						(length + numVecElements - 1) & alignMask : // (rounded up to whole vectors)
+						(length + 2 * numVecElements - 2) & alignMask; // room for kernel shifted by up to (numVecElements - 1)
+
+			// symmetric mode needs a single subfilter, and a symmetric part at least as long as the padded half
+			// (the mirrored loads must not reach back past the start of the history)
+			if (symmetric) {
+				const int coreLength = length - 2;
+				halfLength = static_cast<int>(((coreLength + 1) / 2 + numVecElements - 1) & alignMask);
+				symmetric = (numSubfilters == 1) && (coreLength > 0) && (halfLength <= coreLength);
+			}
+		}
+
+		// numKernelCopies() : number of shifted copies of the kernel which are stored
+		int numKernelCopies() const
+		{
+			return (symmetric || singleKernelCopy) ? 1 : numVecElements;
 		}
 
-		void allocateBuffers()
+		// preferSingleKernelCopy() : policy for KernelLayoutAuto: keep a single copy of the kernel
+		// if the shifted copies would take more than FIR_SINGLE_KERNEL_MIN_BYTES
+		static bool preferSingleKernelCopy(int numTaps, SimdLevel level)
 		{
-			signal = static_cast<FloatType*>(aligned_malloc((paddedLength + length) * sizeof(FloatType), ALIGNMENT_SIZE));
-			for(int i = 0; i < numVecElements; i++) {
-				kernelphases[i] = static_cast<FloatType*>(aligned_malloc(paddedLength * sizeof(FloatType), ALIGNMENT_SIZE));
+			const size_t numVecElements = std::max(1, simdVectorSize(level) / static_cast<int>(sizeof(FloatType)));
+			return numVecElements * numTaps * sizeof(FloatType) > FIR_SINGLE_KERNEL_MIN_BYTES;
+		}
+
+		// kernelSize() : number of elements in each copy of the kernel
+		int kernelSize() const
+		{
+			return symmetric ? halfLength : paddedLength * numSubfilters;
+		}
+
+		// makeRoom() : ensures there is room for n more samples below currentIndex.
+		// If not, the history is moved back to the top of the buffer.
+		// (This happens once every (blockSize - n + 1) samples or so, regardless of how the samples are put)
+		// With a mirrored buffer, the history is already there (in the upper mirror image), so nothing needs to be moved.
+		void makeRoom(int n)
+		{
+			if (currentIndex + 1 < n) {
+				if (ringSize != 0) {
+					currentIndex += ringSize;
+				} else {
+					memmove(signal + blockSize, signal + currentIndex + 1, length * sizeof(FloatType));
+					currentIndex = blockSize - 1;
+				}
 			}
 		}
 
-		void clearBuffers()
+		// storedLength() : number of elements of the signal buffer which are actually stored
+		size_t storedLength() const
+		{
+			return static_cast<size_t>((ringSize != 0) ? ringSize : bufferLength);
+		}
+
+		// allocateBuffers() : allocates (and clears) the signal buffer. (The kernel is allocated separately, by KernelStorage)
+		// If mirrored is true, a mirrored buffer is tried first, with a ring of at least (blockSize + paddedLength) elements,
+		// so that the most recent block and its history is always contiguous. Otherwise (or if that fails), an ordinary buffer
+		// is allocated, of at least minLength elements (enough to hold a copy of the buffer of a filter which had a mirrored buffer).
+		void allocateBuffers(bool mirrored, int minLength)
 		{
-			memset(signal, 0.0, (paddedLength + length) * sizeof(FloatType));
-			for(int i = 0; i < numVecElements; i++) {
-				memset(kernelphases[i], 0.0, paddedLength * sizeof(FloatType));
+			ringSize = 0;
+			signal = nullptr;
+			if (mirrored) {
+				size_t ringBytes = mirrored_size((blockSize + paddedLength) * sizeof(FloatType));
+				signal = static_cast<FloatType*>(mirrored_malloc(ringBytes));
+				if (signal != nullptr) {
+					ringSize = static_cast<int>(ringBytes / sizeof(FloatType));
+					bufferLength = 2 * ringSize;
+				}
+			}
+			if (signal == nullptr) {
+				bufferLength = std::max(minLength, blockSize + paddedLength);
+				signal = static_cast<FloatType*>(aligned_malloc(bufferLength * sizeof(FloatType), ALIGNMENT_SIZE));
 			}
+			memset(signal, 0, storedLength() * sizeof(FloatType));
 		}
 
-		void copyBuffers(const FIRFilter& other)
+		// setKernelPhases() : points the kernel table at the copies owned by kernelStorage
+		void setKernelPhases()
 		{
-			memcpy(signal, other.signal, (paddedLength + length) * sizeof(FloatType));
-			for(int i = 0; i < numVecElements; i++) {
-				memcpy(kernelphases[i], other.kernelphases[i], paddedLength * sizeof(FloatType));
+			for(int i = 0; i < numKernelCopies(); i++) {
+				kernelphases[i] = kernelStorage ? kernelStorage->phases[i] : nullptr;
 			}
 		}
 
+		void copyBuffers(const FIRFilter& other)
+		{
+			memcpy(signal, other.signal, storedLength() * sizeof(FloatType));
+		}
+
 		void freeBuffers()
 		{
-			aligned_free(signal);
-			for(int i = 0; i < numVecElements; i++) {
-				aligned_free(kernelphases[i]);
+			if (ringSize != 0) {
+				mirrored_free(signal, ringSize * sizeof(FloatType));
+			} else {
+				aligned_free(signal);
 			}
+			signal = nullptr;
 		}
 
+		// selectWideAccumulationKernels() : replaces the dot-product kernels with the wide-accumulation kernels (see specialization for float)
+		void selectWideAccumulationKernels() {}
+
 		// assertAlignment() : asserts that all private data buffers are aligned on expected boundaries
 		void assertAlignment()
 		{
@@ -400,110 +613,24 @@ namespace ReSampler {
 	#else
 			const std::uintptr_t alignment = ALIGNMENT_SIZE;
 			assert(reinterpret_cast<std::uintptr_t>(signal) % alignment == 0);
-			for(int i = 0; i < numVecElements; i++) {
+			for(int i = 0; i < numKernelCopies(); i++) {
 				assert(reinterpret_cast<std::uintptr_t>(kernelphases[i]) % alignment == 0);
 			}
 	#endif
 		}
 
-	#if defined(USE_AVX)
-		// Horizontal add function (sums 8 floats into single float) http://stackoverflow.com/questions/23189488/horizontal-sum-of-32-bit-floats-in-256-bit-avx-vector
-	static inline float sum8floats(__m256 x) {
-		const __m128 x128 = _mm_add_ps(
-			_mm256_extractf128_ps(x, 1),
-			_mm256_castps256_ps128(x));																// ( x3+x7, x2+x6, x1+x5, x0+x4 )
-		const __m128 x64 = _mm_add_ps(x128, _mm_movehl_ps(x128, x128));								// ( -, -, x1+x3+x5+x7, x0+x2+x4+x6 )
-		const __m128 x32 = _mm_add_ss(x64, _mm_shuffle_ps(x64, x64, 0x55));							// ( -, -, -, x0+x1+x2+x3+x4+x5+x6+x7 )
-		return _mm_cvtss_f32(x32);
-	}
-
-	// Horizontal add function (sums 4 doubles into single double)
-	static inline double sum4doubles(__m256d x) {
-		const __m128d x128 = _mm_add_pd(
-			_mm256_extractf128_pd(x, 1),
-			_mm256_castpd256_pd128(x));
-		const __m128d x64 = _mm_add_pd(_mm_permute_pd(x128, 1), x128);
-		return _mm_cvtsd_f64(x64);
-	}
-
-	#endif // defined(USE_AVX)
 
 	};
 
-	// Specializations for doubles:
-
-	#if defined(USE_AVX)
-
-	template <>
-	double FIRFilter<double>::get() {
-
-		// AVX implementation: Processes four doubles at a time.
-
-		double output = 0.0;
-		int index = currentIndex & -4; // make multiple-of-four
-		int phase = currentIndex & 3;
-		double* kernel = kernelphases[phase];
-
-		alignas(ALIGNMENT_SIZE) __m256d s;	// AVX Vector Registers for calculation
-		alignas(ALIGNMENT_SIZE) __m256d k;
-		alignas(ALIGNMENT_SIZE) __m256d product;
-		alignas(ALIGNMENT_SIZE) __m256d accumulator = _mm256_setzero_pd();
-
-		for (int i = 0; i < paddedLength; i += 4) {
-			s = _mm256_load_pd(signal + index);
-			k = _mm256_load_pd(kernel + i);
-
-	#ifdef USE_FMA
-					accumulator = _mm256_fmadd_pd(s, k, accumulator);
-	#else
-			product = _mm256_mul_pd(s, k);
-			accumulator = _mm256_add_pd(product, accumulator);
-	#endif
-
-			index += 4;
-		}
-
-		output += sum4doubles(accumulator);
-		return output;
+	template<>
+	inline void FIRFilter<float>::selectWideAccumulationKernels() {
+		dotProduct = getWideDotProductFunction(simdLevel);
+		dotProductUnaligned = dotProduct;
+		dotProduct4 = getWideDotProduct4Function(simdLevel);
+		dotProductSymmetric = getWideDotProductSymmetricFunction(simdLevel);
+		dotProductSymmetric4 = getWideDotProductSymmetric4Function(simdLevel);
 	}
 
-	#elif defined(USE_SIMD) && defined(USE_SIMD_FOR_DOUBLES) && !defined(FIR_QUAD_PRECISION)
-
-	template <>
-	inline double FIRFilter<double>::get() {
-
-		// SSE Implementation: Processes two doubles at a time.
-
-		double output = 0.0;
-		double* kernel;
-		int index = currentIndex & -2; // make multiple-of-two
-		int phase = currentIndex & 1;
-		kernel = kernelphases[phase];
-
-		alignas(ALIGNMENT_SIZE) __m128d s;	// SIMD Vector Registers for calculation
-		alignas(ALIGNMENT_SIZE) __m128d k;
-		alignas(ALIGNMENT_SIZE) __m128d product;
-		alignas(ALIGNMENT_SIZE) __m128d accumulator = _mm_setzero_pd();
-
-		for (int i = 0; i < paddedLength; i += 2) {
-			s = _mm_load_pd(signal + index + i);
-			k = _mm_load_pd(kernel + i);
-			product = _mm_mul_pd(s, k);
-			accumulator = _mm_add_pd(product, accumulator);
-		}
-
-		// horizontal add of two doubles
-		__m128 undef  = _mm_undefined_ps();
-		__m128 shuftmp= _mm_movehl_ps(undef, _mm_castpd_ps(accumulator));
-		__m128d shuf  = _mm_castps_pd(shuftmp);
-		output +=  _mm_cvtsd_f64(_mm_add_sd(accumulator, shuf));
-
-		return output;
-	}
-
-	#endif // double specialisation
-
-
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// -- Functions beyond this point are for manipulating filter taps, and not for actually performing filtering -- //
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -551,6 +678,49 @@ namespace ReSampler {
 		return true;
 	}
 
+	// makeHalfBandLPF() : generate half-band low pass filter coefficients (cutoff at a quarter of the sample rate), using sinc function.
+	// Length must be of the form 4k + 3, so that the end taps are non-zero. Every other tap (apart from the centre tap) is exactly zero.
+	template<typename FloatType> bool makeHalfBandLPF(FloatType* filter, int Length)
+	{
+		if (Length % 4 != 3)
+			return false;
+
+		int centre = Length / 2;
+		for (int n = 0; n < Length; ++n) {
+			int k = std::abs(n - centre); // (sinc is symmetric)
+			if (k == 0) {
+				filter[n] = 0.5;
+			}
+			else if (k & 1) {
+				filter[n] = (((k / 2) & 1) ? -1.0 : 1.0) / (M_PI * k); // sin(k * pi / 2) / (k * pi)
+			}
+			else {
+				filter[n] = 0.0;
+			}
+		}
+
+		return true;
+	}
+
+	// isHalfBand() : whether the filter taps (of length 4k + 3) have the half-band structure: the centre tap is 0.5,
+	// and every tap which is an even (non-zero) distance from the centre is exactly zero
+	template<typename FloatType> bool isHalfBand(const FloatType* filter, int Length)
+	{
+		if (Length % 4 != 3)
+			return false;
+
+		int centre = Length / 2;
+		if (filter[centre] != static_cast<FloatType>(0.5))
+			return false;
+
+		for (int n = 1; n < Length; n += 2) { // (centre is odd, so these are the even distances from it)
+			if (filter[n] != 0.0 && n != centre) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	// This function converts a requested sidelobe height (in dB) to a value for the Beta parameter used in a Kaiser window:
 	template<typename FloatType> FloatType calcKaiserBeta(FloatType dB)
 	{
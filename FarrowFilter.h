@@ -0,0 +1,244 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef FARROWFILTER_H
+#define FARROWFILTER_H 1
+
+// FarrowFilter.h : arbitrary-ratio resampling, for conversion ratios L / M in which L or M is too large for an ordinary polyphase filter.
+// The prototype filter is stored as a fixed number of phases (numPhases per input sample), and the filter for any position in between
+// two phases is found by cubic (Lagrange) interpolation between the four nearest phases. The interpolation is done in the Farrow
+// structure: the table holds the four polynomial coefficients of each tap of each phase, so each output takes four dot products
+// (per channel) against the same signal history, which are then combined by Horner's method in the fractional position mu.
+// The cost per output, and the size of the table, depend only on the filter specification, not on L or M.
+// In variable-ratio mode (see setRatio()), the position of each output is tracked as a fraction of an input sample instead,
+// so that the ratio can be changed smoothly from one call of convert() to the next (eg for clock-drift correction).
+
+#include "alignedmalloc.h"
+#include "FIRFilter.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define FARROW_NUM_PHASES 512 // number of phases of the prototype filter, per input sample
+#define FARROW_MIN_FACTOR 1024 // minimum value of L or M (in the simplified conversion ratio) for which the FarrowFilter is used
+#define FARROW_BLOCKSIZE 4096 // number of input frames processed at a time
+
+namespace ReSampler {
+
+	// FarrowFilter : converts interleaved frames of numChannels samples by the ratio L / M (output rate / input rate),
+	// or (in variable-ratio mode) by L / M times a ratio factor which may vary over time.
+	// The first output coincides with the first input sample (and then every M / L input samples).
+	// The prototype filter should have a gain of numPhases (ie unity gain for each phase), so the outputs have unity gain.
+	// Copies of a FarrowFilter share the table (which is never modified after construction), but have their own histories.
+
+	template <typename FloatType>
+	class FarrowFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		FarrowFilter() : L(1), M(1), numChannels(1), numPhases(0), length(0), paddedLength(0), phase(0),
+			variableRatio(false), position(0.0), step(1.0), targetStep(1.0), dotProduct(&dotProductUnalignedScalar<FloatType>)
+		{}
+
+		// taps: prototype filter of numTaps taps, at numPhases times the input sample rate
+		FarrowFilter(const FloatType* taps, int numTaps, int numPhases, int L, int M, int numChannels = 1) :
+			L(L), M(M), numChannels(numChannels), numPhases(numPhases), length((numTaps + numPhases - 1) / numPhases), phase(0),
+			variableRatio(false), position(0.0), step(static_cast<double>(M) / L), targetStep(step), dotProduct(getDotProductUnalignedFunction<FloatType>(getSimdLevel()))
+		{
+			const int numVecElements = ALIGNMENT_SIZE / static_cast<int>(sizeof(FloatType));
+			paddedLength = (length + numVecElements - 1) / numVecElements * numVecElements;
+
+			// tap(t) : tap t of the prototype filter (zero beyond either end)
+			auto tap = [taps, numTaps](int t) -> double {
+				return (t < 0 || t >= numTaps) ? 0.0 : static_cast<double>(taps[t]);
+			};
+
+			// For each phase p, the four coefficients c0 ... c3 of each tap are arranged in four consecutive rows of paddedLength.
+			// Each row is reversed (and padded at the front), so that it lines up with the signal history in forward order:
+			// element i of a row is the tap which meets the sample paddedLength - 1 - i samples before the most recent one.
+			std::shared_ptr<Table> t = std::make_shared<Table>(static_cast<size_t>(numPhases) * 4 * paddedLength);
+			for (int p = 0; p < numPhases; p++) {
+				FloatType* rows = t->data + static_cast<size_t>(p) * 4 * paddedLength;
+				for (int i = paddedLength - length; i < paddedLength; i++) {
+					const int centre = (paddedLength - 1 - i) * numPhases + p; // position of the tap in the prototype filter
+					const double y0 = tap(centre - 1);
+					const double y1 = tap(centre);
+					const double y2 = tap(centre + 1);
+					const double y3 = tap(centre + 2);
+
+					// cubic through (-1, y0), (0, y1), (1, y2), (2, y3), evaluated at mu = 0 ... 1:
+					rows[i] = static_cast<FloatType>(y1);
+					rows[paddedLength + i] = static_cast<FloatType>(-y0 / 3.0 - y1 / 2.0 + y2 - y3 / 6.0);
+					rows[2 * paddedLength + i] = static_cast<FloatType>(y0 / 2.0 - y1 + y2 / 2.0);
+					rows[3 * paddedLength + i] = static_cast<FloatType>((y3 - y0) / 6.0 + (y1 - y2) / 2.0);
+				}
+			}
+			table = t;
+
+			// signal history of each channel (paddedLength - 1 samples), followed by room for one block:
+			histories.assign(static_cast<size_t>(numChannels), std::vector<FloatType>(static_cast<size_t>(paddedLength - 1 + FARROW_BLOCKSIZE), 0.0));
+		}
+
+		void reset() {
+			for (auto& h : histories) {
+				std::fill(h.begin(), h.end(), 0.0);
+			}
+			phase = 0;
+			position = 0.0;
+		}
+
+		// setRatio() : switches to variable-ratio mode, with the conversion ratio L / M * factor.
+		// With ramp == true, the ratio changes linearly (per input sample) from its current value to the new one over the next call of convert();
+		// otherwise, the new ratio takes effect immediately.
+		void setRatio(double factor, bool ramp = true) {
+			assert(factor > 0.0);
+			variableRatio = true;
+			targetStep = static_cast<double>(M) / L / factor;
+			if (!ramp) {
+				step = targetStep;
+			}
+		}
+
+		// convert() : converts numFrames frames of input, and returns the number of output frames written.
+		// (At most numFrames * L / M + 1 frames are written, or numFrames * L / M * factor + 1 in variable-ratio mode,
+		// where factor is the larger of the ratio factors before and after the call)
+		int convert(const FloatType* input, int numFrames, FloatType* output) {
+			if (length == 0) {
+				return 0;
+			}
+
+			int o = 0;
+			for (int i = 0; i < numFrames; ) {
+				const int count = std::min(numFrames - i, FARROW_BLOCKSIZE);
+				for (int ch = 0; ch < numChannels; ch++) {
+					FloatType* s = histories[ch].data() + paddedLength - 1;
+					for (int j = 0; j < count; j++) {
+						s[j] = input[(i + j) * numChannels + ch];
+					}
+				}
+
+				if (variableRatio) {
+					// position (in input samples) of the next output, relative to the most recent input sample,
+					// advancing by a step which is interpolated between step and targetStep over the whole call:
+					const double stepIncrement = (targetStep - step) / numFrames;
+					for (int j = 0; j < count; j++) {
+						const double s = step + stepIncrement * (i + j + 1);
+						while (position < 1.0) {
+							calculate(j, position * numPhases, output + o * numChannels);
+							o++;
+							position += s;
+						}
+						position -= 1.0;
+					}
+				}
+				else {
+					// phase (in units of 1 / L of an input sample) is the position of the next output, relative to the most recent input sample:
+					for (int j = 0; j < count; j++) {
+						while (phase < L) {
+							calculate(j, static_cast<double>(phase) * numPhases / L, output + o * numChannels);
+							o++;
+							phase += M;
+						}
+						phase -= L;
+					}
+				}
+
+				// keep the histories:
+				for (auto& h : histories) {
+					std::memmove(h.data(), h.data() + count, (paddedLength - 1) * sizeof(FloatType));
+				}
+				i += count;
+			}
+			step = targetStep;
+			return o;
+		}
+
+		// getKernelBytes() : memory used by the table (which is shared by copies of the filter)
+		size_t getKernelBytes() const {
+			return table ? table->size * sizeof(FloatType) : 0;
+		}
+
+		// getStateBytes() : memory used by the signal histories
+		size_t getStateBytes() const {
+			size_t bytes = 0;
+			for (const auto& h : histories) {
+				bytes += h.size() * sizeof(FloatType);
+			}
+			return bytes;
+		}
+
+		int getNumPhases() const {
+			return numPhases;
+		}
+
+		// getTapsPerPhase() : number of taps in each phase (ie the number of input samples which each output depends on)
+		int getTapsPerPhase() const {
+			return length;
+		}
+
+	private:
+		// calculate() : calculates one output frame, at position x (in units of 1 / numPhases of an input sample) after sample j of the current block
+		void calculate(int j, double x, FloatType* outputFrame) const {
+			const int p = static_cast<int>(x);
+			const auto mu = static_cast<FloatType>(x - p);
+			const FloatType* c0 = table->data + static_cast<size_t>(p) * 4 * paddedLength;
+			const FloatType* c1 = c0 + paddedLength;
+			const FloatType* c2 = c1 + paddedLength;
+			const FloatType* c3 = c2 + paddedLength;
+			for (int ch = 0; ch < numChannels; ch++) {
+				const FloatType* s = histories[ch].data() + j;
+				outputFrame[ch] =
+						((dotProduct(s, c3, paddedLength) * mu + dotProduct(s, c2, paddedLength)) * mu +
+						dotProduct(s, c1, paddedLength)) * mu + dotProduct(s, c0, paddedLength);
+			}
+		}
+
+		int L;
+		int M;
+		int numChannels;
+		int numPhases;
+		int length;			// number of taps in each phase
+		int paddedLength;	// length, rounded up to a multiple of the widest vector
+		int phase;			// position of the next output after the most recent input sample (in units of 1 / L of an input sample)
+		bool variableRatio;	// true once setRatio() has been called
+		double position;	// (variable-ratio mode) position of the next output after the most recent input sample (in input samples)
+		double step;		// (variable-ratio mode) input samples per output, at the start of the next call of convert()
+		double targetStep;	// (variable-ratio mode) input samples per output, at the end of the next call of convert()
+		DotProductFunction<FloatType> dotProduct;
+
+		// Table : owns the (aligned) Farrow coefficients
+		struct Table {
+			FloatType* data;
+			size_t size;
+
+			explicit Table(size_t size) : size(size) {
+				data = static_cast<FloatType*>(aligned_malloc(size * sizeof(FloatType), ALIGNMENT_SIZE));
+				memset(data, 0, size * sizeof(FloatType));
+			}
+
+			~Table() {
+				aligned_free(data);
+			}
+
+			Table(const Table&) = delete;
+			Table& operator= (const Table&) = delete;
+		};
+
+		std::shared_ptr<const Table> table;			// (shared by all copies of this filter)
+		std::vector<std::vector<FloatType>> histories;	// signal history of each channel, followed by one block
+	};
+
+} // namespace ReSampler
+
+#endif // FARROWFILTER_H
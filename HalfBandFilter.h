@@ -0,0 +1,175 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef HALFBANDFILTER_H
+#define HALFBANDFILTER_H 1
+
+// HalfBandFilter.h : filtering engine for 2:1 decimation and 1:2 interpolation with a half-band filter (see makeHalfBandLPF()).
+// Of the 4k + 3 taps of a half-band filter, only the centre tap (0.5) and the 2k + 2 taps an odd distance from it are non-zero,
+// so each output is either a (symmetric) dot product of 2k + 2 taps against every second input, or just the centre tap times one input.
+// This takes about a quarter of the multiplies of an ordinary FIR filter of the same length.
+
+// The dot products are calculated a block at a time, with consecutive outputs in the lanes of the vectors (see symmetricLanesScalar()),
+// which avoids the horizontal additions of a per-output dot product.
+
+#include "FIRFilter.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#define HALFBAND_BLOCKSIZE 4096 // number of input samples processed at a time
+
+namespace ReSampler {
+
+	// HalfBandFilter : converts a whole buffer at a time, with decimate() or interpolate().
+	// Unlike FIRFilter, the taps are not rotated: the group delay is exactly (numTaps - 1) / 2 samples (at the higher rate).
+
+	template <typename FloatType>
+	class HalfBandFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		HalfBandFilter() : interpolating(false), centreTap(0.0), subLength(0), historyLength(0), centreHistoryLength(0),
+			symmetricLanes(nullptr)
+		{}
+
+		// taps: half-band filter taps (4k + 3 of them), interpolating: true for 1:2 interpolation, false for 2:1 decimation
+		HalfBandFilter(const FloatType* taps, int numTaps, bool interpolating) :
+			interpolating(interpolating), centreTap(taps[numTaps / 2]), subLength((numTaps + 1) / 2),
+			historyLength(subLength - 1), centreHistoryLength(subLength / 2),
+			symmetricLanes(getSymmetricLaneFunction<FloatType>(getSimdLevel()))
+		{
+			assert(isHalfBand(taps, numTaps));
+
+			// the non-zero taps other than the centre tap (ie taps[0], taps[2] ... taps[numTaps - 1]) form a symmetric sub-filter
+			// of an even number of taps; only the first half of it is kept:
+			for (int k = 0; k < subLength / 2; k++) {
+				halfKernel.push_back(taps[2 * k]);
+			}
+
+			// the history of the input (interpolating), or of the samples which coincide with an output (decimating),
+			// followed by room for the new samples of one block:
+			signal.assign(static_cast<size_t>(historyLength + HALFBAND_BLOCKSIZE), 0.0);
+			if (!interpolating) {
+				// history of the samples in between the outputs (which meet only the centre tap):
+				centreSignal.assign(static_cast<size_t>(centreHistoryLength + HALFBAND_BLOCKSIZE / 2 + 1), 0.0);
+			}
+			else {
+				scratch.resize(HALFBAND_BLOCKSIZE);
+			}
+		}
+
+		void reset() {
+			std::fill(signal.begin(), signal.end(), 0.0);
+			std::fill(centreSignal.begin(), centreSignal.end(), 0.0);
+		}
+
+		int getBlockSize() const {
+			return HALFBAND_BLOCKSIZE;
+		}
+
+		// decimate() : 2:1 decimation of input[0] ... input[n - 1], where phase is 0 if input[0] coincides with an output (or 1 if not).
+		// (The phase must carry on from the previous call.) Returns the number of outputs written.
+		int decimate(const FloatType* input, int n, int phase, FloatType* output) {
+			assert(!interpolating);
+			int o = 0;
+			for (int i = 0; i < n; ) {
+				int count = std::min(n - i, HALFBAND_BLOCKSIZE);
+				int numOutputs = (count + 1 - phase) / 2;
+				int numCentre = (count + phase) / 2;
+
+				// de-interleave: the even-numbered taps meet the samples which coincide with the outputs, and the centre tap
+				// meets the sample of the other parity which came 2k + 1 samples earlier.
+				const FloatType* p = input + i;
+				FloatType* d = signal.data() + historyLength;
+				FloatType* c = centreSignal.data() + centreHistoryLength;
+				for (int j = 0; j < numOutputs; j++) {
+					d[j] = p[phase + 2 * j];
+				}
+				for (int j = 0; j < numCentre; j++) {
+					c[j] = p[1 - phase + 2 * j];
+				}
+
+				// (the centre sample of output j is c[j + phase - centreHistoryLength])
+				const FloatType* centre = centreSignal.data() + phase;
+				symmetricLanes(signal.data(), halfKernel.data(), subLength / 2, subLength, numOutputs, output + o);
+				for (int j = 0; j < numOutputs; j++) {
+					output[o + j] += centreTap * centre[j];
+				}
+
+				// keep the histories:
+				std::memmove(signal.data(), signal.data() + numOutputs, historyLength * sizeof(FloatType));
+				std::memmove(centreSignal.data(), centreSignal.data() + numCentre, centreHistoryLength * sizeof(FloatType));
+
+				o += numOutputs;
+				phase = (phase + count) & 1;
+				i += count;
+			}
+			return o;
+		}
+
+		// interpolate() : 1:2 interpolation of input[0] ... input[n - 1]. Writes 2n outputs.
+		// (With the input zero-stuffed, the outputs coinciding with an input sample meet the even-numbered taps,
+		// and the outputs in between meet only the centre tap.)
+		int interpolate(const FloatType* input, int n, FloatType* output) {
+			assert(interpolating);
+			for (int i = 0; i < n; ) {
+				int count = std::min(n - i, HALFBAND_BLOCKSIZE);
+				std::memcpy(signal.data() + historyLength, input + i, count * sizeof(FloatType));
+				symmetricLanes(signal.data(), halfKernel.data(), subLength / 2, subLength, count, scratch.data());
+
+				// the centre tap meets the sample k samples earlier (where subLength = 2k + 2):
+				const FloatType* centre = signal.data() + historyLength - centreHistoryLength + 1;
+				FloatType* out = output + 2 * i;
+				for (int j = 0; j < count; j++) {
+					out[2 * j] = scratch[j];
+					out[2 * j + 1] = centreTap * centre[j];
+				}
+
+				std::memmove(signal.data(), signal.data() + count, historyLength * sizeof(FloatType));
+				i += count;
+			}
+			return 2 * n;
+		}
+
+		// getKernelBytes() : memory used by the kernel
+		size_t getKernelBytes() const {
+			return halfKernel.size() * sizeof(FloatType);
+		}
+
+		// getStateBytes() : memory used by the signal histories
+		size_t getStateBytes() const {
+			return (signal.size() + centreSignal.size() + scratch.size()) * sizeof(FloatType);
+		}
+
+		// getNumTaps() : number of non-zero taps (ie multiplies per pair of outputs, not counting the symmetric saving)
+		int getNumTaps() const {
+			return (subLength == 0) ? 0 : subLength + 1;
+		}
+
+	private:
+		bool interpolating;
+		FloatType centreTap;
+		int subLength;				// length of the sub-filter of even-numbered taps (2k + 2)
+		int historyLength;			// number of samples of history kept in signal
+		int centreHistoryLength;	// (decimating) number of samples of history kept in centreSignal
+		SymmetricLaneFunction<FloatType> symmetricLanes;
+		std::vector<FloatType> halfKernel;		// first half of the (symmetric) sub-filter
+		std::vector<FloatType> signal;			// history of the input, or (decimating) of the samples coinciding with an output, followed by one block
+		std::vector<FloatType> centreSignal;	// (decimating) history of the samples in between the outputs, followed by one block
+		std::vector<FloatType> scratch;			// (interpolating) outputs of the sub-filter for one block
+	};
+
+} // namespace ReSampler
+
+#endif // HALFBANDFILTER_H
@@ -0,0 +1,260 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef IIRHALFBANDFILTER_H
+#define IIRHALFBANDFILTER_H 1
+
+// IIRHalfBandFilter.h : 2:1 decimation and 1:2 interpolation with a polyphase IIR half-band filter
+// (the elliptic-equivalent design of Valenzuela & Constantinides, in the form popularised by the HIIR library).
+// The filter is H(z) = 0.5 * (A0(z^2) + z^-1 * A1(z^2)), where A0 and A1 are cascades of first-order all-pass sections
+// (a + z^-1) / (1 + a * z^-1), running at the lower rate. When decimating, each pair of inputs is split between the two paths;
+// when interpolating, each input goes through both paths, which produce the two outputs. Either way, each output takes one
+// multiply per all-pass coefficient (plus one), and a handful of coefficients gives well over 100 dB of stopband attenuation.
+
+// Phase response: unlike the (linear-phase) FIR filters, the group delay is not constant. It is smallest (a few samples) at DC,
+// and rises steadily through the passband, steeply towards the band edge. It is (about) the group delay of a minimum-phase filter of
+// the same magnitude response, so there is no pre-ringing, and the latency is tiny, but the phase is not preserved.
+// The magnitude response is symmetric about a quarter of the higher sample rate (the passband ripple is negligible - about the square
+// of the stopband ripple), and the transition band is centred on it: the stopband starts at the mirror image of the passband edge.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#define IIRHALFBAND_MAX_COEFFICIENTS 32 // (a larger number would be needed only for attenuations and transition widths beyond any sensible use)
+
+namespace ReSampler {
+
+	namespace IIRHalfBandDesign {
+
+		// transitionParameters() : the elliptic modulus k, and the nome q, of a half-band filter of the given transition width
+		// (as a fraction of the higher sample rate)
+		inline void transitionParameters(double transitionWidth, double& k, double& q) {
+			k = std::tan((1.0 - transitionWidth * 2.0) * M_PI / 4.0);
+			k *= k;
+			const double kksqrt = std::pow(1.0 - k * k, 0.25);
+			const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+			const double e4 = e * e * e * e;
+			q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+		}
+
+		// order() : (odd) order of the elliptic filter needed for the given stopband attenuation (dB)
+		inline int order(double attenuation, double q) {
+			const double attn = std::pow(10.0, -attenuation / 10.0);
+			const double a = attn / (1.0 - attn);
+			auto n = static_cast<int>(std::ceil(std::log(a * a / 16.0) / std::log(q)));
+			n |= 1;
+			return std::max(3, n);
+		}
+
+		// attenuation() : stopband attenuation (dB) of the elliptic filter of the given order
+		inline double attenuation(double q, int order) {
+			const double a = 4.0 * std::exp(order * 0.5 * std::log(q));
+			return -10.0 * std::log10(a / (1.0 + a));
+		}
+
+		// coefficient() : all-pass coefficient c (1 ... (order - 1) / 2), from the theta functions of q
+		inline double coefficient(int c, double k, double q, int order) {
+			double num = 0.0;
+			double term;
+			int i = 0;
+			do {
+				term = std::pow(q, i * (i + 1)) * std::sin((i * 2 + 1) * c * M_PI / order) * ((i & 1) ? -1.0 : 1.0);
+				num += term;
+				++i;
+			} while (std::abs(term) > 1e-100);
+			num *= std::pow(q, 0.25);
+
+			double den = 0.5;
+			i = 1;
+			do {
+				term = std::pow(q, i * i) * std::cos(i * 2 * c * M_PI / order) * ((i & 1) ? -1.0 : 1.0);
+				den += term;
+				++i;
+			} while (std::abs(term) > 1e-100);
+
+			const double ww = num / den;
+			const double wwsq = ww * ww;
+			const double x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+			return (1.0 - x) / (1.0 + x);
+		}
+
+	} // namespace IIRHalfBandDesign
+
+	// makeIIRHalfBandCoefficients() : all-pass coefficients (in ascending order) of a polyphase IIR half-band filter with (at least)
+	// the given stopband attenuation (dB), where transitionWidth is the width of the transition band, as a fraction of the higher sample rate
+	// (ie the passband edge is at 0.25 - transitionWidth / 2). The number of coefficients is limited to IIRHALFBAND_MAX_COEFFICIENTS.
+	inline std::vector<double> makeIIRHalfBandCoefficients(double attenuation, double transitionWidth) {
+		assert(transitionWidth > 0.0 && transitionWidth < 0.5);
+		double k, q;
+		IIRHalfBandDesign::transitionParameters(transitionWidth, k, q);
+		const int order = std::min(IIRHalfBandDesign::order(attenuation, q), 2 * IIRHALFBAND_MAX_COEFFICIENTS + 1);
+		std::vector<double> coefficients;
+		for (int c = 1; c <= (order - 1) / 2; c++) {
+			coefficients.push_back(IIRHalfBandDesign::coefficient(c, k, q, order));
+		}
+		return coefficients;
+	}
+
+	// getIIRHalfBandAttenuation() : stopband attenuation (dB) of an IIR half-band filter with the given number of coefficients and transition width
+	inline double getIIRHalfBandAttenuation(int numCoefficients, double transitionWidth) {
+		double k, q;
+		IIRHalfBandDesign::transitionParameters(transitionWidth, k, q);
+		return IIRHalfBandDesign::attenuation(q, 2 * numCoefficients + 1);
+	}
+
+	// IIRHalfBandFilter : converts interleaved frames of numChannels samples, a whole buffer at a time, with decimate() or interpolate().
+	// The even-numbered coefficients form path 0, and the odd-numbered ones path 1.
+	// Copies of an IIRHalfBandFilter have their own state.
+
+	template <typename FloatType>
+	class IIRHalfBandFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		IIRHalfBandFilter() : interpolating(false), numChannels(1), numCoefficients(0), havePending(false)
+		{}
+
+		// coefficients: all-pass coefficients (see makeIIRHalfBandCoefficients()), interpolating: true for 1:2 interpolation, false for 2:1 decimation
+		IIRHalfBandFilter(const std::vector<double>& coefficients, bool interpolating, int numChannels = 1) :
+			interpolating(interpolating), numChannels(numChannels), numCoefficients(static_cast<int>(coefficients.size())),
+			coefficients(coefficients.begin(), coefficients.end()), havePending(false)
+		{
+			state.assign(static_cast<size_t>(numCoefficients + 2) * numChannels, 0.0);
+			pending.assign(static_cast<size_t>(numChannels), 0.0);
+		}
+
+		void reset() {
+			std::fill(state.begin(), state.end(), 0.0);
+			std::fill(pending.begin(), pending.end(), 0.0);
+			havePending = false;
+		}
+
+		// decimate() : 2:1 decimation of n input frames. Each output is made from a pair of inputs (the odd one out is kept for the next call).
+		// Returns the number of output frames written.
+		int decimate(const FloatType* input, int n, FloatType* output) {
+			assert(!interpolating);
+			int i = 0;
+			int o = 0;
+			if (havePending && n > 0) { // complete the pair started in the previous call
+				decimatePair(pending.data(), input, output);
+				havePending = false;
+				i = 1;
+				o = 1;
+			}
+			for (; i + 1 < n; i += 2) {
+				const FloatType* in = input + static_cast<size_t>(i) * numChannels;
+				decimatePair(in, in + numChannels, output + static_cast<size_t>(o) * numChannels);
+				o++;
+			}
+			if (i < n) {
+				const FloatType* in = input + static_cast<size_t>(i) * numChannels;
+				std::copy(in, in + numChannels, pending.begin());
+				havePending = true;
+			}
+			return o;
+		}
+
+		// interpolate() : 1:2 interpolation of n input frames. Writes 2n output frames, with a gain of 0.5
+		// (like the polyphase FIR filters, the caller applies the gain of the interpolation factor).
+		int interpolate(const FloatType* input, int n, FloatType* output) {
+			assert(interpolating);
+			for (int i = 0; i < n; i++) {
+				const FloatType* in = input + static_cast<size_t>(i) * numChannels;
+				FloatType* out = output + static_cast<size_t>(2 * i) * numChannels;
+				for (int ch = 0; ch < numChannels; ch++) {
+					FloatType path0 = static_cast<FloatType>(0.5) * in[ch];
+					FloatType path1 = path0;
+					allPass(ch, path0, path1);
+					out[ch] = path0;
+					out[numChannels + ch] = path1;
+				}
+			}
+			return 2 * n;
+		}
+
+		// getGroupDelay() : group delay at DC, in samples of the higher rate. (Each all-pass section has a delay of (1 - a) / (1 + a) samples
+		// of the lower rate at DC; path 1 has a further delay of one sample of the higher rate, and the filter has the average of the two.)
+		double getGroupDelay() const {
+			double delay = 0.5;
+			for (FloatType a : coefficients) {
+				delay += (1.0 - a) / (1.0 + a);
+			}
+			return delay;
+		}
+
+		// getKernelBytes() : memory used by the coefficients
+		size_t getKernelBytes() const {
+			return coefficients.size() * sizeof(FloatType);
+		}
+
+		// getStateBytes() : memory used by the all-pass states
+		size_t getStateBytes() const {
+			return (state.size() + pending.size()) * sizeof(FloatType);
+		}
+
+		int getNumCoefficients() const {
+			return numCoefficients;
+		}
+
+	private:
+		bool interpolating;
+		int numChannels;
+		int numCoefficients;
+		std::vector<FloatType> coefficients;
+		std::vector<FloatType> state;	// for each channel: the previous inputs of paths 0 and 1, followed by the previous output of each all-pass section
+		std::vector<FloatType> pending;	// (decimating) the first input frame of an incomplete pair
+		bool havePending;
+
+		// decimatePair() : makes one output frame from a pair of input frames
+		void decimatePair(const FloatType* older, const FloatType* newer, FloatType* out) {
+			for (int ch = 0; ch < numChannels; ch++) {
+				FloatType path0 = newer[ch];
+				FloatType path1 = older[ch];
+				allPass(ch, path0, path1);
+				out[ch] = static_cast<FloatType>(0.5) * (path0 + path1);
+			}
+		}
+
+		// allPass() : passes path0 and path1 through the all-pass sections of paths 0 and 1 (for the given channel).
+		// The previous input of each section is the previous output of the one before it (in the same path), so only the outputs are kept:
+		// section k takes its previous input from s[k], and its previous output from s[k + 2].
+		// (This halves the stores per sample, which limit the speed of the loop.)
+		void allPass(int ch, FloatType& path0, FloatType& path1) {
+			const int n = numCoefficients;
+			const FloatType* a = coefficients.data();
+			FloatType* s = state.data() + static_cast<size_t>(ch) * (n + 2);
+			int k = 0;
+			for (; k + 1 < n; k += 2) {
+				const FloatType t0 = (path0 - s[k + 2]) * a[k] + s[k];
+				const FloatType t1 = (path1 - s[k + 3]) * a[k + 1] + s[k + 1];
+				s[k] = path0;
+				s[k + 1] = path1;
+				path0 = t0;
+				path1 = t1;
+			}
+			if (k < n) { // (path 0 has one more section)
+				const FloatType t0 = (path0 - s[k + 2]) * a[k] + s[k];
+				s[k] = path0;
+				path0 = t0;
+				s[k + 1] = path1;
+				s[k + 2] = path0;
+			}
+			else {
+				s[k] = path0;
+				s[k + 1] = path1;
+			}
+		}
+	};
+
+} // namespace ReSampler
+
+#endif // IIRHALFBANDFILTER_H
@@ -0,0 +1,234 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef MULTICHANNELFIRFILTER_H
+#define MULTICHANNELFIRFILTER_H 1
+
+// MultichannelFIRFilter.h : FIR filtering of interleaved multichannel audio, with the channels in SIMD lanes.
+// Each tap is broadcast once, and multiplied by a whole frame (all channels) at a time, so the
+// (identical) filter kernel is only stored and read once, regardless of the number of channels.
+
+#include "alignedmalloc.h"
+#include "FIRFilter.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#define MULTICHANNEL_MIN_CHANNELS 4 // (measured end-to-end, including de-interleaving) minimum number of channels for which the channel-lane filter is used
+
+namespace ReSampler {
+
+	// MultichannelFIRFilter : has the same block interface as FIRFilter (ie put(values, n) / getAt(age, subfilter)),
+	// except that values are interleaved frames of numChannels samples, and getAt() writes a whole frame of outputs.
+	// As with FIRFilter, the taps may be decomposed into numSubfilters polyphase components (with the same tap alignment).
+
+	template <typename FloatType>
+	class MultichannelFIRFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		MultichannelFIRFilter() : numChannels(1), length(0), numSubfilters(1), blockSize(0), stride(1),
+			channelLanes(&channelLanesScalar<FloatType>), signal(nullptr), currentIndex(0)
+		{}
+
+		MultichannelFIRFilter(const FloatType* taps, int numTaps, int numSubfilters, int numChannels) :
+			numChannels(numChannels), length((numTaps + numSubfilters - 1) / numSubfilters), numSubfilters(numSubfilters),
+			blockSize(std::max(length, FIR_BLOCKSIZE)), currentIndex(blockSize - 1)
+		{
+			SimdLevel level = chooseSimdLevel(numChannels);
+			int numVecElements = std::max(1, simdVectorSize(level) / static_cast<int>(sizeof(FloatType)));
+			stride = (numChannels + numVecElements - 1) / numVecElements * numVecElements;
+			channelLanes = getChannelLaneFunction<FloatType>(level);
+
+			// initialize filter kernel(s): (one copy, shared by all channels)
+			kernel.resize(static_cast<size_t>(length * numSubfilters), 0.0);
+			for (int s = 0; s < numSubfilters; s++) {
+				for (int i = 0; i < length; ++i) {
+					int t = s + i * numSubfilters; // corresponding position in zero-stuffed history
+					kernel[s * length + i] = (t < numTaps) ? taps[(t + 1) % numTaps] : 0.0;
+				}
+			}
+
+			frameOutput.resize(static_cast<size_t>(stride));
+			allocateBuffers();
+			reset();
+		}
+
+		// deconstructor:
+		~MultichannelFIRFilter() {
+			aligned_free(signal);
+		}
+
+		// copy constructor:
+		MultichannelFIRFilter(const MultichannelFIRFilter& other) :
+			numChannels(other.numChannels), length(other.length), numSubfilters(other.numSubfilters), blockSize(other.blockSize),
+			stride(other.stride), channelLanes(other.channelLanes), kernel(other.kernel), frameOutput(other.frameOutput),
+			signal(nullptr), currentIndex(other.currentIndex)
+		{
+			allocateBuffers();
+			copyBuffers(other);
+		}
+
+		// move constructor:
+		MultichannelFIRFilter(MultichannelFIRFilter&& other) noexcept :
+			numChannels(other.numChannels), length(other.length), numSubfilters(other.numSubfilters), blockSize(other.blockSize),
+			stride(other.stride), channelLanes(other.channelLanes), kernel(std::move(other.kernel)), frameOutput(std::move(other.frameOutput)),
+			signal(other.signal), currentIndex(other.currentIndex)
+		{
+			other.signal = nullptr;
+		}
+
+		// copy assignment:
+		MultichannelFIRFilter& operator= (const MultichannelFIRFilter& other)
+		{
+			if (this != &other) {
+				aligned_free(signal);
+				copyParameters(other);
+				kernel = other.kernel;
+				frameOutput = other.frameOutput;
+				allocateBuffers();
+				copyBuffers(other);
+			}
+			return *this;
+		}
+
+		// move assignment:
+		MultichannelFIRFilter& operator= (MultichannelFIRFilter&& other) noexcept
+		{
+			if (this != &other) {
+				aligned_free(signal);
+				copyParameters(other);
+				kernel = std::move(other.kernel);
+				frameOutput = std::move(other.frameOutput);
+				signal = other.signal;
+				other.signal = nullptr;
+			}
+			return *this;
+		}
+
+		void reset() {
+			currentIndex = blockSize - 1;
+			if (signal != nullptr) {
+				memset(signal, 0, bufferSize() * sizeof(FloatType));
+			}
+		}
+
+		// put() : puts frames[0] ... frames[n - 1] (n must not exceed getBlockSize()), where each frame is numChannels interleaved samples
+		void put(const FloatType* frames, int n) {
+			assert(n <= blockSize);
+			makeRoom(n);
+			for (int i = 0; i < n; i++) {
+				memcpy(signal + (currentIndex - i) * stride, frames + i * numChannels, numChannels * sizeof(FloatType));
+			}
+			currentIndex -= n;
+		}
+
+		int getBlockSize() const {
+			return blockSize;
+		}
+
+		int getNumChannels() const {
+			return numChannels;
+		}
+
+		// getAt() : writes the outputs (for every channel) of the filter (or subfilter) to out[0] ... out[numChannels - 1],
+		// as they were when the frame which was put age frames ago was the most recent frame.
+		void getAt(int age, int subfilter, FloatType* out) {
+			channelLanes(signal + (currentIndex + 1 + age) * stride, kernel.data() + subfilter * length, length, stride, frameOutput.data());
+			memcpy(out, frameOutput.data(), numChannels * sizeof(FloatType));
+		}
+
+		// getAt4() : same as FIRFilter::getAt4(), except that each output is a frame (and outStride is in frames)
+		void getAt4(const int* ages, int subfilter, FloatType* out, int outStride) {
+			for (int j = 0; j < 4; j++) {
+				getAt(ages[j], subfilter, out + j * outStride * numChannels);
+			}
+		}
+
+		// getKernelBytes() : memory used by the kernel
+		size_t getKernelBytes() const {
+			return kernel.size() * sizeof(FloatType);
+		}
+
+		// getStateBytes() : memory used by the signal history (of all channels)
+		size_t getStateBytes() const {
+			return (signal == nullptr) ? 0 : bufferSize() * sizeof(FloatType);
+		}
+
+	private:
+		int numChannels;
+		int length;			// length of signal history (in frames), and of each subfilter
+		int numSubfilters;
+		int blockSize;
+		int stride;			// number of elements per frame in the history (numChannels rounded up to a whole number of vectors)
+		ChannelLaneFunction<FloatType> channelLanes;
+		std::vector<FloatType> kernel;
+		std::vector<FloatType> frameOutput;
+		FloatType* signal;	// signal buffer (blockSize + length frames), filled in reverse order (as with FIRFilter)
+		int currentIndex;	// position (in frames) of next frame to be put
+
+		// chooseSimdLevel() : the SIMD level (no higher than the level in effect) which needs the fewest vectors per frame,
+		// preferring the narrowest vectors (ie the least padding) when there is a tie
+		static SimdLevel chooseSimdLevel(int numChannels) {
+			SimdLevel best = getSimdLevel();
+			int bestVectors = 0;
+			int bestLanes = 0;
+			for (int l = getSimdLevel(); l > SimdScalar; l--) {
+				auto level = static_cast<SimdLevel>(l);
+				int lanes = simdVectorSize(level) / static_cast<int>(sizeof(FloatType));
+				int vectors = (numChannels + lanes - 1) / lanes;
+				if (bestVectors == 0 || vectors < bestVectors || (vectors == bestVectors && lanes < bestLanes)) {
+					best = level;
+					bestVectors = vectors;
+					bestLanes = lanes;
+				}
+			}
+			return best;
+		}
+
+		size_t bufferSize() const {
+			return static_cast<size_t>(blockSize + length) * stride;
+		}
+
+		// makeRoom() : ensures there is room for n more frames below currentIndex (see FIRFilter::makeRoom())
+		void makeRoom(int n) {
+			if (currentIndex + 1 < n) {
+				memmove(signal + blockSize * stride, signal + (currentIndex + 1) * stride, length * stride * sizeof(FloatType));
+				currentIndex = blockSize - 1;
+			}
+		}
+
+		void copyParameters(const MultichannelFIRFilter& other) {
+			numChannels = other.numChannels;
+			length = other.length;
+			numSubfilters = other.numSubfilters;
+			blockSize = other.blockSize;
+			stride = other.stride;
+			channelLanes = other.channelLanes;
+			currentIndex = other.currentIndex;
+		}
+
+		void allocateBuffers() {
+			signal = (blockSize == 0) ? nullptr : static_cast<FloatType*>(aligned_malloc(bufferSize() * sizeof(FloatType), ALIGNMENT_SIZE));
+		}
+
+		void copyBuffers(const MultichannelFIRFilter& other) {
+			if (signal != nullptr) {
+				memcpy(signal, other.signal, bufferSize() * sizeof(FloatType));
+			}
+		}
+	};
+
+} // namespace ReSampler
+
+#endif // MULTICHANNELFIRFILTER_H
@@ -0,0 +1,391 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef PARTITIONEDFFTFILTER_H
+#define PARTITIONEDFFTFILTER_H 1
+
+// PartitionedFFTFilter.h : FIR filtering by uniformly-partitioned overlap-save convolution (a frequency-domain delay line).
+// The filter is split into partitions of partitionSize taps, each of which is convolved (by overlap-save, with an FFT of twice the
+// partition size) with the input, delayed by a whole number of partitions. The delayed input spectra are kept (the delay line), so
+// each partition of input is transformed only once, and the outputs are the inverse transform of the sum of the products
+// of the spectra of each partition of the filter and the corresponding input spectrum.
+
+// Unlike FFTFilter (whose FFT is several times the length of the filter), the amount of work per block doesn't depend on the
+// length of the filter, except through the number of products to be summed, so it stays efficient when the blocks are short
+// (and the latency is low): each block costs two FFTs of twice the partition size, plus the sum of products.
+// The sum of the products for the earlier partitions of the filter is only calculated once per partition of input, so blocks which are
+// shorter than a partition cost one sum of products each (plus the FFTs), instead of one for each partition of the filter.
+// No particular symmetry of the filter is assumed: minimum-phase filters (see makeMinPhase()) work just as well as linear-phase ones.
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define PARTITIONEDFFT_MAC_COST 2.0 // (measured with --benchmark) cost of one complex multiply-accumulate per bin, relative to one unit of N.log2(N) of an FFT
+
+namespace ReSampler {
+
+	// PartitionedFFTFilter : alternative to the block interface of FIRFilter (ie put(values, n) / getAt(age, subfilter)), like FFTFilter.
+	// As with FFTFilter, the taps may be decomposed into numSubfilters polyphase components, of which only those whose index is a multiple
+	// of subfilterStep are calculated. Calculations are done in double precision, regardless of FloatType.
+
+	template <typename FloatType>
+	class PartitionedFFTFilter {
+
+	public:
+
+		// default constructor: an empty (unused) filter
+		PartitionedFFTFilter() : length(0), numSubfilters(1), subfilterStep(1), numComputedSubfilters(0),
+			partitionSize(0), numPartitions(0), fftSize(0), numBins(0), fill(0), newest(0), lastBlockSize(0),
+			x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{}
+
+		// partitionSize: number of taps (of each subfilter) per partition, and the maximum number of samples per block
+		PartitionedFFTFilter(const FloatType* taps, int numTaps, int partitionSize, int numSubfilters = 1, int subfilterStep = 1) :
+			length((numTaps + numSubfilters - 1) / numSubfilters), numSubfilters(numSubfilters), subfilterStep(subfilterStep),
+			numComputedSubfilters((numSubfilters + subfilterStep - 1) / subfilterStep),
+			partitionSize(partitionSize), numPartitions((length + partitionSize - 1) / partitionSize),
+			fftSize(2 * partitionSize), numBins(partitionSize + 1), fill(0), newest(0), lastBlockSize(0),
+			x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{
+			allocateBuffers();
+
+			forwardPlan.reset(fftw_plan_dft_r2c_1d(fftSize, x, X, FFTW_ESTIMATE), fftw_destroy_plan);
+			inversePlan.reset(fftw_plan_dft_c2r_1d(fftSize, Y, y, FFTW_ESTIMATE), fftw_destroy_plan);
+
+			// calculate the frequency response of each partition of each (computed) subfilter, with the 1/fftSize scaling of the inverse FFT folded in.
+			// Note: the taps are paired with the signal history in exactly the same way as FIRFilter (including the rotation by one).
+			// Layout: [subfilter][partition][re[numBins] | im[numBins]]
+			const double scale = 1.0 / fftSize;
+			auto responses = std::make_shared<std::vector<double>>(static_cast<size_t>(2 * numBins) * numPartitions * numComputedSubfilters);
+			for (int c = 0; c < numComputedSubfilters; c++) {
+				int s = c * subfilterStep;
+				for (int p = 0; p < numPartitions; p++) {
+					std::fill(x, x + fftSize, 0.0);
+					for (int i = 0; i < partitionSize && p * partitionSize + i < length; ++i) {
+						int t = s + (p * partitionSize + i) * numSubfilters; // corresponding position in zero-stuffed history
+						x[i] = (t < numTaps) ? scale * taps[(t + 1) % numTaps] : 0.0;
+					}
+					fftw_execute_dft_r2c(forwardPlan.get(), x, X);
+					double* h = responses->data() + responseOffset(c, p);
+					for (int k = 0; k < numBins; k++) {
+						h[k] = X[k][0];
+						h[numBins + k] = X[k][1];
+					}
+				}
+			}
+			H = std::move(responses);
+
+			spectra.resize(static_cast<size_t>(2 * numBins) * numPartitions);
+			sums.resize(static_cast<size_t>(2 * numBins) * numComputedSubfilters);
+			output.resize(static_cast<size_t>(partitionSize) * numComputedSubfilters);
+			reset();
+		}
+
+		// deconstructor:
+		~PartitionedFFTFilter() {
+			freeBuffers();
+		}
+
+		// copy constructor: (the plans and the frequency responses are shared, but not the buffers)
+		PartitionedFFTFilter(const PartitionedFFTFilter& other) :
+			length(other.length), numSubfilters(other.numSubfilters), subfilterStep(other.subfilterStep),
+			numComputedSubfilters(other.numComputedSubfilters), partitionSize(other.partitionSize), numPartitions(other.numPartitions),
+			fftSize(other.fftSize), numBins(other.numBins), fill(other.fill), newest(other.newest), lastBlockSize(other.lastBlockSize),
+			forwardPlan(other.forwardPlan), inversePlan(other.inversePlan), H(other.H),
+			spectra(other.spectra), sums(other.sums), output(other.output), x(nullptr), y(nullptr), X(nullptr), Y(nullptr)
+		{
+			allocateBuffers();
+			copyBuffers(other);
+		}
+
+		// move constructor:
+		PartitionedFFTFilter(PartitionedFFTFilter&& other) noexcept :
+			length(other.length), numSubfilters(other.numSubfilters), subfilterStep(other.subfilterStep),
+			numComputedSubfilters(other.numComputedSubfilters), partitionSize(other.partitionSize), numPartitions(other.numPartitions),
+			fftSize(other.fftSize), numBins(other.numBins), fill(other.fill), newest(other.newest), lastBlockSize(other.lastBlockSize),
+			forwardPlan(std::move(other.forwardPlan)), inversePlan(std::move(other.inversePlan)), H(std::move(other.H)),
+			spectra(std::move(other.spectra)), sums(std::move(other.sums)), output(std::move(other.output)),
+			x(other.x), y(other.y), X(other.X), Y(other.Y)
+		{
+			other.x = nullptr;
+			other.y = nullptr;
+			other.X = nullptr;
+			other.Y = nullptr;
+		}
+
+		// copy assignment:
+		PartitionedFFTFilter& operator= (const PartitionedFFTFilter& other)
+		{
+			if (this != &other) {
+				freeBuffers();
+				copyParameters(other);
+				forwardPlan = other.forwardPlan;
+				inversePlan = other.inversePlan;
+				H = other.H;
+				spectra = other.spectra;
+				sums = other.sums;
+				output = other.output;
+				allocateBuffers();
+				copyBuffers(other);
+			}
+			return *this;
+		}
+
+		// move assignment:
+		PartitionedFFTFilter& operator= (PartitionedFFTFilter&& other) noexcept
+		{
+			if (this != &other) {
+				freeBuffers();
+				copyParameters(other);
+				forwardPlan = std::move(other.forwardPlan);
+				inversePlan = std::move(other.inversePlan);
+				H = std::move(other.H);
+				spectra = std::move(other.spectra);
+				sums = std::move(other.sums);
+				output = std::move(other.output);
+				x = other.x;
+				y = other.y;
+				X = other.X;
+				Y = other.Y;
+				other.x = nullptr;
+				other.y = nullptr;
+				other.X = nullptr;
+				other.Y = nullptr;
+			}
+			return *this;
+		}
+
+		void reset() {
+			fill = 0;
+			newest = 0;
+			lastBlockSize = 0;
+			if (x != nullptr) {
+				std::fill(x, x + fftSize, 0.0);
+			}
+			std::fill(spectra.begin(), spectra.end(), 0.0);
+			std::fill(sums.begin(), sums.end(), 0.0);
+			std::fill(output.begin(), output.end(), 0.0);
+		}
+
+		// put() : puts values[0] ... values[n - 1] (n must not exceed getBlockSize()), and calculates
+		// the outputs (of each computed subfilter) for every sample in the block
+		void put(const FloatType* values, int n) {
+			assert(n <= partitionSize);
+			int i = 0;
+			while (i < n) { // (a block may straddle two partitions of input)
+				int count = std::min(n - i, partitionSize - fill);
+				putSegment(values + i, count, i);
+				i += count;
+			}
+			lastBlockSize = n;
+		}
+
+		int getBlockSize() const {
+			return partitionSize;
+		}
+
+		int getPartitionSize() const {
+			return partitionSize;
+		}
+
+		int getNumPartitions() const {
+			return numPartitions;
+		}
+
+		// getAt() : returns the output of the subfilter for the sample which was put age samples ago.
+		// (Only valid for samples in the block most recently put, and subfilters which are a multiple of subfilterStep)
+		FloatType getAt(int age, int subfilter = 0) const {
+			assert(age < lastBlockSize && subfilter % subfilterStep == 0);
+			return output[partitionSize * (subfilter / subfilterStep) + lastBlockSize - 1 - age];
+		}
+
+		// getAt4() : same as FIRFilter::getAt4() (for PartitionedFFTFilter, the outputs are already calculated)
+		void getAt4(const int* ages, int subfilter, FloatType* out, int outStride) const {
+			for (int j = 0; j < 4; j++) {
+				out[j * outStride] = getAt(ages[j], subfilter);
+			}
+		}
+
+		// getKernelBytes() : memory used by the frequency responses (which are shared by all copies of the filter)
+		size_t getKernelBytes() const {
+			return H ? H->size() * sizeof(double) : 0;
+		}
+
+		// getStateBytes() : memory used by the delay line and buffers (of this copy of the filter)
+		size_t getStateBytes() const {
+			return static_cast<size_t>(2 * fftSize) * sizeof(double) + static_cast<size_t>(2 * numBins) * sizeof(fftw_complex)
+					+ (spectra.size() + sums.size()) * sizeof(double) + output.size() * sizeof(FloatType);
+		}
+
+		// estimateCost() : estimated amount of work per input sample, in the same units as FFTFilter::estimateCost()
+		// (N.log2(N) per FFT), for a filter with the given subfilter length and number of computed subfilters, when it is given
+		// blocks of blockSize samples (one per partition). Each block costs one forward FFT, and one inverse FFT per subfilter,
+		// and each partition of input costs one complex multiply-accumulate per bin, per partition of each subfilter.
+		static double estimateCost(int length, int numComputedSubfilters, int blockSize) {
+			int partitionSize = calcPartitionSize(blockSize);
+			int fftSize = 2 * partitionSize;
+			int numPartitions = (length + partitionSize - 1) / partitionSize;
+			double fftCost = (1 + numComputedSubfilters) * fftSize * std::log2(fftSize);
+			double macCost = PARTITIONEDFFT_MAC_COST * numComputedSubfilters * numPartitions * (partitionSize + 1);
+			return (fftCost + macCost) / blockSize;
+		}
+
+		// calcPartitionSize() : partition size for blocks of blockSize samples (the smallest power of 2 which is at least blockSize)
+		static int calcPartitionSize(int blockSize) {
+			int size = 16;
+			while (size < blockSize) {
+				size <<= 1;
+			}
+			return size;
+		}
+
+	private:
+		int length;					// length of each subfilter
+		int numSubfilters;
+		int subfilterStep;
+		int numComputedSubfilters;
+		int partitionSize;			// taps per partition (and maximum number of samples per block)
+		int numPartitions;			// partitions per subfilter
+		int fftSize;
+		int numBins;
+		int fill;					// number of samples in the current (incomplete) partition of input
+		int newest;					// index (in spectra) of the spectrum of the current partition of input
+		int lastBlockSize;			// number of samples in the block most recently put
+		std::shared_ptr<fftw_plan_s> forwardPlan;
+		std::shared_ptr<fftw_plan_s> inversePlan;
+		std::shared_ptr<const std::vector<double>> H;	// frequency response of each partition of each computed subfilter, shared by copies
+		std::vector<double> spectra;	// the delay line: spectrum of each of the last numPartitions partitions of input (circular, re | im)
+		std::vector<double> sums;		// for each computed subfilter, the sum of the products of the earlier partitions (re | im)
+		std::vector<FloatType> output;
+		double* x;					// time-domain input (previous partition + current partition)
+		double* y;					// time-domain output
+		fftw_complex* X;
+		fftw_complex* Y;
+
+		size_t responseOffset(int c, int p) const {
+			return static_cast<size_t>(2 * numBins) * (static_cast<size_t>(c) * numPartitions + p);
+		}
+
+		// putSegment() : puts n samples (which don't go beyond the end of the current partition of input),
+		// and calculates their outputs, starting at position o of the output block
+		void putSegment(const FloatType* values, int n, int o) {
+			if (fill == 0) { // start of a new partition: sum the products of the earlier partitions of input
+				sumEarlierPartitions();
+			}
+
+			// x = [ previous partition | current partition (so far) | (stale) ]
+			// (the stale part only affects outputs which are yet to be calculated)
+			double* p = x + partitionSize + fill;
+			for (int i = 0; i < n; i++) {
+				p[i] = values[i];
+			}
+			fftw_execute_dft_r2c(forwardPlan.get(), x, X);
+
+			double* re = spectra.data() + static_cast<size_t>(2 * numBins) * newest;
+			double* im = re + numBins;
+			for (int k = 0; k < numBins; k++) {
+				re[k] = X[k][0];
+				im[k] = X[k][1];
+			}
+
+			for (int c = 0; c < numComputedSubfilters; c++) {
+				const double* h = H->data() + responseOffset(c, 0);
+				const double* sum = sums.data() + static_cast<size_t>(2 * numBins) * c;
+				for (int k = 0; k < numBins; k++) {
+					Y[k][0] = sum[k] + re[k] * h[k] - im[k] * h[numBins + k];
+					Y[k][1] = sum[numBins + k] + re[k] * h[numBins + k] + im[k] * h[k];
+				}
+				fftw_execute_dft_c2r(inversePlan.get(), Y, y);
+				FloatType* out = output.data() + partitionSize * c + o;
+				const double* valid = y + partitionSize + fill;
+				for (int i = 0; i < n; i++) {
+					out[i] = static_cast<FloatType>(valid[i]);
+				}
+			}
+
+			fill += n;
+			if (fill == partitionSize) { // the partition is complete: it becomes the previous partition
+				memcpy(x, x + partitionSize, partitionSize * sizeof(double));
+				fill = 0;
+				newest = (newest + 1) % numPartitions;
+			}
+		}
+
+		// sumEarlierPartitions() : for each computed subfilter, sums the products of partitions 1 ... numPartitions - 1
+		// of the subfilter and the spectra of the corresponding earlier partitions of input
+		void sumEarlierPartitions() {
+			for (int c = 0; c < numComputedSubfilters; c++) {
+				double* sumRe = sums.data() + static_cast<size_t>(2 * numBins) * c;
+				double* sumIm = sumRe + numBins;
+				std::fill(sumRe, sumRe + 2 * numBins, 0.0);
+				for (int q = 1; q < numPartitions; q++) {
+					const double* hRe = H->data() + responseOffset(c, q);
+					const double* hIm = hRe + numBins;
+					const double* xRe = spectra.data() + static_cast<size_t>(2 * numBins) * ((newest + numPartitions - q) % numPartitions);
+					const double* xIm = xRe + numBins;
+					for (int k = 0; k < numBins; k++) {
+						sumRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+						sumIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+					}
+				}
+			}
+		}
+
+		void copyParameters(const PartitionedFFTFilter& other) {
+			length = other.length;
+			numSubfilters = other.numSubfilters;
+			subfilterStep = other.subfilterStep;
+			numComputedSubfilters = other.numComputedSubfilters;
+			partitionSize = other.partitionSize;
+			numPartitions = other.numPartitions;
+			fftSize = other.fftSize;
+			numBins = other.numBins;
+			fill = other.fill;
+			newest = other.newest;
+			lastBlockSize = other.lastBlockSize;
+		}
+
+		void allocateBuffers() {
+			if (fftSize == 0) {
+				return;
+			}
+			x = fftw_alloc_real(static_cast<size_t>(fftSize));
+			y = fftw_alloc_real(static_cast<size_t>(fftSize));
+			X = fftw_alloc_complex(static_cast<size_t>(numBins));
+			Y = fftw_alloc_complex(static_cast<size_t>(numBins));
+		}
+
+		void copyBuffers(const PartitionedFFTFilter& other) {
+			if (fftSize == 0) {
+				return;
+			}
+			memcpy(x, other.x, fftSize * sizeof(double));
+		}
+
+		void freeBuffers() {
+			fftw_free(x);
+			fftw_free(y);
+			fftw_free(X);
+			fftw_free(Y);
+			x = nullptr;
+			y = nullptr;
+			X = nullptr;
+			Y = nullptr;
+		}
+	};
+
+} // namespace ReSampler
+
+#endif // PARTITIONEDFFTFILTER_H
@@ -15,7 +15,9 @@
 #include "raiitimer.h"
 #include "fraction.h"
 #include "srconvert.h"
+#include "ratioschedule.h"
 #include "ditherer.h"
+#include "benchmark.h"
 
 #include <cstdio>
 #include <string>
@@ -44,6 +46,19 @@ namespace ReSampler {
 // parseGlobalOptions() - result indicates whether to terminate.
 bool parseGlobalOptions(int argc, char * argv[]) {
 
+	// simd switch (not a terminating option: applies to whatever follows)
+	if (getCmdlineParam(argv, argv + argc, "--simd")) {
+		std::string levelName;
+		SimdLevel level;
+		getCmdlineParam(argv, argv + argc, "--simd", levelName);
+		if (!simdLevelFromName(levelName, level)) {
+			std::cout << "Warning: unknown SIMD level '" << levelName << "' (expected scalar, sse2, avx, avx2 or avx512) - using " << simdLevelName(getSimdLevel()) << std::endl;
+		}
+		else if (!setSimdLevel(level)) {
+			std::cout << "Warning: this CPU doesn't support " << levelName << " - using " << simdLevelName(getSimdLevel()) << std::endl;
+		}
+	}
+
 	// help switch:
 	if (getCmdlineParam(argv, argv + argc, "--help") || getCmdlineParam(argv, argv + argc, "-h")) {
 		std::cout << strUsage << std::endl;
@@ -93,6 +108,12 @@ bool parseGlobalOptions(int argc, char * argv[]) {
 		return true;
 	}
 
+	// benchmark
+	if (getCmdlineParam(argv, argv + argc, "--benchmark")) {
+		runBenchmarks();
+		return true;
+	}
+
 	return false;
 }
 
@@ -373,10 +394,36 @@ bool convert(ConversionInfo& ci)
 	// determine conversion ratio:
 	Fraction fraction = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
 
-	// set buffer sizes:
-	auto inputChannelBufferSize = static_cast<size_t>(BUFFERSIZE);
-	auto inputBlockSize = static_cast<size_t>(BUFFERSIZE * nChannels);
-	auto outputChannelBufferSize = static_cast<size_t>(1 + std::ceil(BUFFERSIZE * static_cast<double>(fraction.numerator) / static_cast<double>(fraction.denominator)));
+	// load the schedule of ratio factors (variable-ratio mode):
+	RatioSchedule ratioSchedule;
+	if (ci.bVariableRatio) {
+		std::string errorMessage;
+		if (!ratioSchedule.load(ci.ratioScheduleFilename, errorMessage)) {
+			std::cout << "Error: " << errorMessage << std::endl;
+			return false;
+		}
+		ci.minRatioFactor = ratioSchedule.getMinFactor();
+	}
+	const double maxRatioFactor = ci.bVariableRatio ? ratioSchedule.getMaxFactor() : 1.0;
+
+	// (--autotune) find the fastest way of doing this conversion on this machine, and save it in the tuning database (which the Converters consult):
+	if (ci.bAutotune) {
+		TuningEntry tuning;
+		if (!autotune<FloatType>(ci, tuning)) {
+			std::cout << "Nothing to tune (the conversion isn't done in stages)" << std::endl;
+		} else if (storeTuning(ci, tuning)) {
+			std::cout << "Saved in tuning database " << ci.tuningDatabase << std::endl;
+		} else {
+			std::cout << "Warning: couldn't save in tuning database " << (ci.tuningDatabase.empty() ? std::string{"(none)"} : ci.tuningDatabase) << std::endl;
+		}
+	}
+
+	// set buffer sizes (in low-latency mode, the input is read in short blocks, as though it were a live feed; otherwise, in blocks of the size found by --autotune, if any):
+	TuningEntry tuning;
+	const int tunedBlockSize = (Converter<FloatType>::isMultistageConversion(ci) && lookupTuning(ci, tuning)) ? std::min(tuning.blockSize, BUFFERSIZE) : BUFFERSIZE;
+	auto inputChannelBufferSize = static_cast<size_t>(ci.bLowLatency ? ci.lowLatencyBlockSize : tunedBlockSize);
+	auto inputBlockSize = static_cast<size_t>(inputChannelBufferSize * nChannels);
+	auto outputChannelBufferSize = static_cast<size_t>(1 + std::ceil(BUFFERSIZE * maxRatioFactor * static_cast<double>(fraction.numerator) / static_cast<double>(fraction.denominator)));
 	auto outputBlockSize = static_cast<size_t>(nChannels * (1 + outputChannelBufferSize));
 
 	// allocate buffers:
@@ -469,11 +516,19 @@ bool convert(ConversionInfo& ci)
 	if (ci.bMinPhase) {
 		std::cout << "Using Minimum-Phase LPF" << std::endl;
 	}
+	if (ci.qualityTier != qualityArchival) {
+		std::cout << "Quality: " << getQualityTierName(ci.qualityTier) << " (stopband attenuation " <<
+					 getSidelobeAttenuation(ci.qualityTier, (fraction.numerator == 1) || (fraction.denominator == 1)) << " dB)" << std::endl;
+	}
 
 	// echo conversion ratio to user:
 	FloatType resamplingFactor = static_cast<FloatType>(ci.outputSampleRate) / ci.inputSampleRate;
 	std::cout << "Conversion ratio: " << resamplingFactor
 			  << " (" << fraction.numerator << ":" << fraction.denominator << ")" << std::endl;
+	if (ci.bVariableRatio) {
+		std::cout << "Ratio schedule: " << ratioSchedule.getNumPoints() << " point(s), factor " << std::setprecision(9)
+				  << ratioSchedule.getMinFactor() << " to " << ratioSchedule.getMaxFactor() << std::setprecision(static_cast<int>(prec)) << std::endl;
+	}
 
 	// if the outputFormat is zero, it means "No change to file format"
 	// if output file format has changed, use outputFormat. Otherwise, use same format as infile:
@@ -487,7 +542,7 @@ bool convert(ConversionInfo& ci)
 	// for wav files, determine whether to switch to rf64 mode:
 	if ((outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAV || (outputFileFormat & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAVEX) {
 		if (ci.bRf64 ||
-				checkWarnOutputSize(inputSampleCount, getSfBytesPerSample(outputFileFormat), fraction.numerator, fraction.denominator)) {
+				checkWarnOutputSize(static_cast<sf_count_t>(std::ceil(inputSampleCount * maxRatioFactor)), getSfBytesPerSample(outputFileFormat), fraction.numerator, fraction.denominator)) {
 			std::cout << "Switching to rf64 format !" << std::endl;
 			outputFileFormat &= ~SF_FORMAT_TYPEMASK; // clear file type
 			outputFileFormat |= SF_FORMAT_RF64;
@@ -548,15 +603,55 @@ bool convert(ConversionInfo& ci)
 		ditherers.emplace_back(outputSignalBits, ci.ditherAmount, ci.bAutoBlankingEnabled, n + seed, static_cast<DitherProfileID>(ci.ditherProfileID));
 	}
 
-	// make a vector of Resamplers
+	// decide whether to convert all channels together (interleaved, with the channels in SIMD lanes),
+	// or each channel separately (which allows one thread per channel)
+#ifdef USE_MULTICHANNEL_FIR
+	// (the channel lanes have no wide-accumulation kernels)
+	const bool channelLanes = (nChannels >= MULTICHANNEL_MIN_CHANNELS) && !multiThreaded && !ci.bWideAccumulation;
+#else
+	const bool channelLanes = false;
+#endif
+
+	// decide whether to convert the whole file at once, in the frequency domain (short files only),
+	// instead of a block at a time, with Converters
+	const bool wholeSignal = shouldUseWholeSignal(ci, inputFrames);
+	std::vector<FloatType> wholeSignalInput; // (whole-signal) all of the interleaved input samples
+	std::unique_ptr<WholeSignalResampler<FloatType>> wholeSignalResampler;
+
+	// make a vector of Resamplers (just one, for all channels, when using channel lanes).
+	// The filters are only designed once: the other channels' Resamplers are copies of the first,
+	// which share its (immutable) filter kernels, and only have their own filter histories.
 	std::vector<Converter<FloatType>> converters;
-	converters.reserve(static_cast<size_t>(nChannels));
-	for (int n = 0; n < nChannels; n++) {
+	if (wholeSignal) {
+		wholeSignalResampler.reset(new WholeSignalResampler<FloatType>(makeWholeSignalResampler<FloatType>(ci)));
+		if (ci.bShowStages) {
+			std::cout << "Filtering method: whole-signal FFT (" << wholeSignalResampler->getFFTSize(static_cast<size_t>(inputFrames)) << "-point, with "
+					  << wholeSignalResampler->getPaddingFrames() << " frames of padding)\n" << std::endl;
+		}
+	}
+	else if (channelLanes) {
+		converters.emplace_back(ci, nChannels);
+	}
+	else {
+		converters.reserve(static_cast<size_t>(nChannels));
 		converters.emplace_back(ci);
+		for (int n = 1; n < nChannels; n++) {
+			converters.push_back(converters.front());
+		}
+	}
+
+	if (ci.bShowStages && !wholeSignal) { // report the memory used by the filters:
+		size_t stateBytes = 0;
+		for (const auto& converter : converters) {
+			stateBytes += converter.getStateBytes();
+		}
+		std::cout << "Filter memory: " << converters[0].getKernelBytes() / 1024 << " KB of kernels (shared by all channels), "
+				  << stateBytes / 1024 << " KB of filter state and buffers\n" << std::endl;
 	}
 
-	// Calculate initial gain:
-	FloatType gain = static_cast<FloatType>(ci.gain) * static_cast<FloatType>(converters[0].getGain()) *
+	// Calculate initial gain (the WholeSignalResampler has unity gain, so it mustn't be multiplied by the interpolation factor):
+	double converterGain = wholeSignal ? 1.0 / fraction.numerator : converters[0].getGain();
+	FloatType gain = static_cast<FloatType>(ci.gain) * static_cast<FloatType>(converterGain) *
 			static_cast<FloatType>(ci.bNormalize ? fraction.numerator * (ci.limit / static_cast<double>(peakInputSample)) : fraction.numerator * ci.limit);
 
 	// todo: more testing with very low bit depths (eg 4 bits)
@@ -566,7 +661,7 @@ bool convert(ConversionInfo& ci)
 		gain *= ditherCompensation;
 	}
 
-	int groupDelay = static_cast<int>(converters[0].getGroupDelay());
+	int groupDelay = wholeSignal ? 0 : static_cast<int>(converters[0].getGroupDelay());
 
 	FloatType peakOutputSample;
 	bool bClippingDetected;
@@ -686,8 +781,8 @@ bool convert(ConversionInfo& ci)
 		} // ends opening of temp file
 
 		// echo conversion mode to user (multi-stage/single-stage, multi-threaded/single-threaded)
-		std::string stageness(ci.bMultiStage ? "multi-stage" : "single-stage");
-		std::string threadedness(ci.bMultiThreaded ? ", multi-threaded" : "");
+		std::string stageness(wholeSignal ? "whole-signal FFT" : ci.bMultiStage ? "multi-stage" : "single-stage");
+		std::string threadedness(wholeSignal ? "" : ci.bMultiThreaded ? ", multi-threaded" : channelLanes ? ", channel lanes" : "");
 		std::cout << "Converting (" << stageness << threadedness << ") ..." << std::endl;
 
 		peakOutputSample = 0.0;
@@ -697,12 +792,97 @@ bool convert(ConversionInfo& ci)
 
 		int outStartOffset = std::min(groupDelay * nChannels, static_cast<int>(outputBlockSize) - nChannels);
 
+		if (ci.bVariableRatio) { // start with the ratio factor at the beginning of the schedule:
+			for (auto& converter : converters) {
+				converter.setRatio(ratioSchedule.getFactor(0.0), false);
+			}
+		}
+
+		if (wholeSignal) {
+			wholeSignalInput.clear();
+			wholeSignalInput.reserve(static_cast<size_t>(inputSampleCount));
+		}
+
+		// writeOutputBlock() : writes outputBlock[0 ... outputBlockIndex - 1] to either temp file or outfile (with Group Delay Compensation),
+		// and conditionally sends a progress update
+		auto writeOutputBlock = [&](size_t outputBlockIndex) {
+			// skip the first outStartOffset samples of output (which may span several blocks, when the blocks are short)
+			auto skip = std::min(static_cast<size_t>(outStartOffset), outputBlockIndex);
+			if (ci.bTmpFile) {
+				tmpSndfileHandle->write(outputBlock.data() + skip, outputBlockIndex - skip);
+			}
+			else {
+				if (ci.csvOutput) {
+					csvFile->write(outputBlock.data() + skip, outputBlockIndex - skip);
+				}
+				else {
+					outFile->write(outputBlock.data() + skip, outputBlockIndex - skip);
+				}
+			}
+			outStartOffset -= static_cast<int>(skip);
+
+			// conditionally send progress update:
+			if (totalSamplesRead > nextProgressThreshold) {
+				int progressPercentage = std::min(static_cast<int>(99), static_cast<int>(100 * totalSamplesRead / inputSampleCount));
+				OutputManager::callProgressFunc(progressPercentage);
+				nextProgressThreshold += incrementalProgressThreshold;
+			}
+		};
+
 		do { // central conversion loop (the heart of the matter ...)
 
 			// Grab a block of interleaved samples from file:
 			samplesRead = infile.read(inputBlock.data(), inputBlockSize);
 			totalSamplesRead += samplesRead;
 
+			if (ci.bVariableRatio) { // ramp to the ratio factor at the end of this block:
+				double factor = ratioSchedule.getFactor(static_cast<double>(totalSamplesRead / nChannels) / ci.inputSampleRate);
+				for (auto& converter : converters) {
+					converter.setRatio(factor);
+				}
+			}
+
+			if (wholeSignal) { // collect the input, and convert it all at the end
+				wholeSignalInput.insert(wholeSignalInput.end(), inputBlock.begin(), inputBlock.begin() + samplesRead);
+				if (samplesRead > 0) {
+					continue;
+				}
+				size_t numFrames = wholeSignalInput.size() / nChannels;
+				size_t outputBlockIndex = wholeSignalResampler->getOutputFrames(numFrames) * nChannels;
+				if (outputBlock.size() < outputBlockIndex) {
+					outputBlock.resize(outputBlockIndex);
+				}
+				wholeSignalResampler->convert(wholeSignalInput.data(), numFrames, nChannels, outputBlock.data());
+				for (size_t f = 0; f < outputBlockIndex; f += nChannels) {
+					for (int ch = 0; ch < nChannels; ++ch) {
+						// note: disable dither for temp files (dithering to be done in post)
+						FloatType outputSample = (ci.bDither && !ci.bTmpFile) ? ditherers[ch].dither(gain * outputBlock[f + ch]) : gain * outputBlock[f + ch]; // gain, dither
+						peakOutputSample = std::max(peakOutputSample, std::abs(outputSample)); // peak
+						outputBlock[f + ch] = outputSample;
+					}
+				}
+
+				writeOutputBlock(outputBlockIndex);
+				continue;
+			}
+
+			if (channelLanes) { // convert all channels at once, straight from (and to) interleaved buffers
+				size_t o = 0;
+				converters[0].convert(outputBlock.data(), o, inputBlock.data(), static_cast<size_t>(samplesRead / nChannels));
+				size_t outputBlockIndex = o * nChannels;
+				for (size_t f = 0; f < outputBlockIndex; f += nChannels) {
+					for (int ch = 0; ch < nChannels; ++ch) {
+						// note: disable dither for temp files (dithering to be done in post)
+						FloatType outputSample = (ci.bDither && !ci.bTmpFile) ? ditherers[ch].dither(gain * outputBlock[f + ch]) : gain * outputBlock[f + ch]; // gain, dither
+						peakOutputSample = std::max(peakOutputSample, std::abs(outputSample)); // peak
+						outputBlock[f + ch] = outputSample;
+					}
+				}
+
+				writeOutputBlock(outputBlockIndex);
+				continue;
+			}
+
 			// de-interleave into channel buffers
 			size_t i = 0;
 			for (int s = 0; s < samplesRead; s += nChannels) {
@@ -761,26 +941,7 @@ bool convert(ConversionInfo& ci)
 				}
 			}
 
-			// write to either temp file or outfile (with Group Delay Compensation):
-			if (ci.bTmpFile) {
-				tmpSndfileHandle->write(outputBlock.data() + outStartOffset, outputBlockIndex - outStartOffset);
-			}
-			else {
-				if (ci.csvOutput) {
-					csvFile->write(outputBlock.data() + outStartOffset, outputBlockIndex - outStartOffset);
-				}
-				else {
-					outFile->write(outputBlock.data() + outStartOffset, outputBlockIndex - outStartOffset);
-				}
-			}
-			outStartOffset = 0; // reset after first use
-
-			// conditionally send progress update:
-			if (totalSamplesRead > nextProgressThreshold) {
-				int progressPercentage = std::min(static_cast<int>(99), static_cast<int>(100 * totalSamplesRead / inputSampleCount));
-				OutputManager::callProgressFunc(progressPercentage);
-				nextProgressThreshold += incrementalProgressThreshold;
-			}
+			writeOutputBlock(outputBlockIndex);
 
 		} while (samplesRead > 0); // ends central conversion loop
 
@@ -1224,16 +1385,7 @@ void generateExpSweep(const std::string& filename, int sampleRate, int format, d
 #endif
 
 bool checkSSE2() {
-#if defined (_MSC_VER) || defined (__INTEL_COMPILER)
-	bool bSSE2ok = false;
-	int CPUInfo[4] = { 0,0,0,0 };
-	__cpuid(CPUInfo, 0);
-	if (CPUInfo[0] != 0) {
-		__cpuid(CPUInfo, 1);
-		if (CPUInfo[3] & (1 << 26))
-			bSSE2ok = true;
-	}
-	if (bSSE2ok) {
+	if (detectSimdLevel() >= SimdSSE2) {
 		std::cout << "CPU supports SSE2 (ok)";
 		return true;
 	}
@@ -1241,24 +1393,10 @@ bool checkSSE2() {
 		std::cout << "Your CPU doesn't support SSE2 - please try a non-SSE2 build on this machine" << std::endl;
 		return false;
 	}
-#endif // defined (_MSC_VER) || defined (__INTEL_COMPILER)
-	return true; // todo: fix the check on gcc
 }
 
 bool checkAVX() {
-#if defined (_MSC_VER) || defined (__INTEL_COMPILER)
-	// Verify CPU capabilities:
-	bool bAVXok = false;
-	int cpuInfo[4] = { 0,0,0,0 };
-	__cpuid(cpuInfo, 0);
-	if (cpuInfo[0] != 0) {
-		__cpuid(cpuInfo, 1);
-		if (cpuInfo[2] & (1 << 28)) {
-			bAVXok = true; // Note: this test only confirms CPU AVX capability, and does not check OS capability.
-			// to-do: check for AVX2 ...
-		}
-	}
-	if (bAVXok) {
+	if (detectSimdLevel() >= SimdAVX) {
 		std::cout << "CPU supports AVX (ok)";
 		return true;
 	}
@@ -1266,8 +1404,6 @@ bool checkAVX() {
 		std::cout << "Your CPU doesn't support AVX - please try a non-AVX build on this machine" << std::endl;
 		return false;
 	}
-#endif // defined (_MSC_VER) || defined (__INTEL_COMPILER)
-	return true; // todo: gcc detection
 }
 
 bool showBuildVersion() {
@@ -1278,9 +1414,6 @@ bool showBuildVersion() {
 	std::cout << " AVX build ... ";
 	if (!checkAVX())
 		return false;
-#ifdef USE_FMA
-	std::cout << "\nusing FMA (Fused Multiply-Add) instruction ... ";
-#endif
 #endif // USE_AVX
 	std::cout << std::endl;
 #else
@@ -1293,6 +1426,7 @@ bool showBuildVersion() {
 #endif // defined(USE_SSE2)
 	std::cout << "\n" << std::endl;
 #endif
+	std::cout << "using " << simdLevelName(getSimdLevel()) << " filter kernels" << std::endl;
 	return true;
 }
 
@@ -1424,14 +1558,33 @@ int runCommand(int argc, char** argv) {
 		}
 	}
 
+	// resolve automatic quality tier, from the output bit format (which is the bit format of the input file, if not specified):
+	if (ci.qualityTier == qualityAuto) {
+		std::string bitFormat{ci.outBitFormat};
+		if (bitFormat.empty() && !ci.csvOutput) {
+			determineBestBitFormat(bitFormat, ci);
+		}
+		ci.setQualityTier(getQualityTierFromBitFormat(bitFormat, ci.quantize ? ci.quantizeBits : 0));
+	}
+
 	try {
 
+		// applies to the single-precision FIR filters constructed from now on
+		setWideAccumulation(ci.bWideAccumulation);
+
 		if (ci.bUseDoublePrecision) {
 
 #ifdef USE_QUADMATH
 			std::cout << "Using quadruple-precision for calculations.\n";
 #else
-			std::cout << "Using double precision for calculations." << std::endl;
+			if (ci.bMixedPrecision) {
+				std::cout << "Using mixed precision for calculations (single precision for the early stages, double precision for the final stage)." << std::endl;
+				if (ci.bWideAccumulation) {
+					std::cout << "The early stages accumulate in double precision." << std::endl;
+				}
+			} else {
+				std::cout << "Using double precision for calculations." << std::endl;
+			}
 #endif
 
 			if (ci.dsfInput) {
@@ -1452,6 +1605,10 @@ int runCommand(int argc, char** argv) {
 
 #ifdef USE_QUADMATH
 		std::cout << "Using quadruple-precision for calculations.\n";
+#else
+		if (ci.bWideAccumulation) {
+			std::cout << "Using single precision for calculations, with double-precision accumulation in the FIR filters." << std::endl;
+		}
 #endif
 		if (ci.dsfInput) {
 			ci.bEnablePeakDetection = false;
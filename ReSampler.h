@@ -49,17 +49,29 @@ const std::string strExtraOptions(
 		"--sndfile-version\n"
 		"--listsubformats <ext>\n"
 		"--showDitherProfiles\n"
+		"--benchmark\n"
+		"--simd <scalar|sse2|avx|avx2|avx512>\n"
 		"--gain [<amount>]\n"
 		"--doubleprecision\n"
+		"--mixedPrecision\n"
+		"--wideAccumulation\n"
 		"--dither [<amount>] [--autoblank] [--ns [<ID>]] [--flat-tpdf] [--seed [<num>]] [--quantize-bits <number of bits>]\n"
 		"--noDelayTrim\n"
 		"--minphase\n"
+		"--equiripple [<passband ripple dB>]\n"
+		"--iir\n"
+		"--noWholeSignal\n"
+		"--lowLatency [<block size (frames)>]\n"
+		"--autotune\n"
+		"--tuningDB <filename>\n"
+		"--noTuning\n"
 		"--flacCompression <compressionlevel>\n"
 		"--vorbisQuality <quality>\n"
 		"--noClippingProtection\n"
 		"--relaxedLPF\n"
 		"--steepLPF\n"
 		"--lpf-cutoff <percentage> [--lpf-transition <percentage>]\n"
+		"--quality [<draft|16|24|archival|auto>]\n"
 		"--mt\n"
 		"--rf64\n"
 		"--noPeakChunk\n"
@@ -68,6 +80,7 @@ const std::string strExtraOptions(
 		"--multiStage\n"
 		"--maxStages\n"
 		"--showStages\n"
+		"--ratioSchedule <filename>\n"
 		"--rawInput <samplerate> <bitformat> [numChannels]\n"
 		"--progress-updates <0..100>\n"
 
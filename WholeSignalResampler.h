@@ -0,0 +1,192 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef WHOLESIGNALRESAMPLER_H
+#define WHOLESIGNALRESAMPLER_H 1
+
+// WholeSignalResampler.h : sample-rate conversion of a whole (short) signal at once, in the frequency domain.
+// The signal (padded with zeros) is transformed with one real FFT, the spectrum is tapered to zero across the transition band
+// of the anti-aliasing filter, truncated (or zero-padded) to the length of the output spectrum, and transformed back.
+// There is no filter to design, and no filter delay to trim: the output is aligned with the input, and has the same duration.
+
+// The taper falls from 1 at the passband edge to 0 at the stopband edge as the (normalized) running integral of a Kaiser window,
+// ie the ideal lowpass response convolved with a Kaiser window in frequency. This is the dual of a Kaiser-windowed FIR filter:
+// the impulse response is the ideal (sinc) response multiplied by the transform of the Kaiser window, which falls to the
+// sidelobe level (the requested attenuation) beyond the same half-length as the equivalent FIR filter.
+// The zero-padding must cover that half-length, so that the circular convolution of the FFT doesn't wrap the end of the signal onto the start.
+// The passband is exactly flat, the stopband is exactly zero (apart from the wrapped-around sidelobes and the rounding of the FFT),
+// and calculations are done in double precision, regardless of FloatType.
+
+#include "FIRFilter.h"
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define WHOLESIGNAL_MAX_FRAMES (1 << 18) // (per channel, input or output) longest signal converted in one go (see shouldUseWholeSignal()). Beyond a few seconds, the FFTs take longer than a Converter
+
+namespace ReSampler {
+
+	// besselI0() : 0th-order modified Bessel function of the first kind (by the power series, with each term calculated from the previous one)
+	inline double besselI0(double z) {
+		const double q = z * z / 4.0;
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; term > sum * 1e-17; k++) {
+			term *= q / (static_cast<double>(k) * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	// WholeSignalResampler : converts by L / M, with a taper from passFreq to stopFreq (both as fractions of the input rate),
+	// and the given stopband attenuation (dB). The output has unity gain.
+
+	template <typename FloatType>
+	class WholeSignalResampler {
+
+	public:
+		WholeSignalResampler(int L, int M, double passFreq, double stopFreq, double attenuation) :
+			L(L), M(M), passFreq(passFreq), stopFreq(stopFreq),
+			beta(calcKaiserBeta(attenuation))
+		{
+			assert(L > 0 && M > 0);
+			assert(passFreq > 0.0 && passFreq < stopFreq && stopFreq <= 0.5 * std::min(1.0, static_cast<double>(L) / M) + 1e-12);
+
+			// half-length of the impulse response (in input samples): the first zero of the transform of the Kaiser window, whose width is stopFreq - passFreq.
+			paddingFrames = static_cast<int>(std::ceil(std::sqrt(beta * beta + M_PI * M_PI) / (M_PI * (stopFreq - passFreq)))) + 1;
+		}
+
+		// getOutputFrames() : number of output frames for numFrames input frames (the same duration)
+		size_t getOutputFrames(size_t numFrames) const {
+			return static_cast<size_t>((static_cast<uint64_t>(numFrames) * L + M - 1) / M);
+		}
+
+		// getFFTSize() : length of the forward transform for numFrames input frames
+		// (the signal and its padding, rounded up to a multiple of M with only small prime factors besides those of M, so that the inverse transform,
+		// of length getFFTSize() * L / M, has output samples at exactly the output rate)
+		size_t getFFTSize(size_t numFrames) const {
+			const auto minBlocks = static_cast<uint64_t>((numFrames + paddingFrames + M - 1) / M);
+			uint64_t blocks = minBlocks;
+			while (!isSmooth(blocks)) {
+				++blocks;
+			}
+			return static_cast<size_t>(blocks * M);
+		}
+
+		int getPaddingFrames() const {
+			return paddingFrames;
+		}
+
+		// convert() : converts numFrames interleaved frames of numChannels samples from input into output,
+		// which must have room for getOutputFrames(numFrames) frames
+		void convert(const FloatType* input, size_t numFrames, int numChannels, FloatType* output) {
+			const size_t fftSize = getFFTSize(numFrames);
+			const size_t outputFFTSize = fftSize / M * L;
+			const size_t numOutputFrames = getOutputFrames(numFrames);
+			const size_t numBins = fftSize / 2 + 1;
+			const size_t numOutputBins = outputFFTSize / 2 + 1;
+
+			std::unique_ptr<double, decltype(&fftw_free)> x(fftw_alloc_real(fftSize), fftw_free);
+			std::unique_ptr<double, decltype(&fftw_free)> y(fftw_alloc_real(outputFFTSize), fftw_free);
+			std::unique_ptr<fftw_complex, decltype(&fftw_free)> X(fftw_alloc_complex(numBins), fftw_free);
+			std::unique_ptr<fftw_complex, decltype(&fftw_free)> Y(fftw_alloc_complex(numOutputBins), fftw_free);
+			std::unique_ptr<fftw_plan_s, decltype(&fftw_destroy_plan)> forwardPlan(
+						fftw_plan_dft_r2c_1d(static_cast<int>(fftSize), x.get(), X.get(), FFTW_ESTIMATE), fftw_destroy_plan);
+			std::unique_ptr<fftw_plan_s, decltype(&fftw_destroy_plan)> inversePlan(
+						fftw_plan_dft_c2r_1d(static_cast<int>(outputFFTSize), Y.get(), y.get(), FFTW_ESTIMATE), fftw_destroy_plan);
+
+			// taper (with the 1 / fftSize scaling of the inverse FFT folded in)
+			std::vector<double> taper = makeTaper(fftSize);
+			const size_t numTaperBins = std::min(taper.size(), numOutputBins);
+
+			for (int ch = 0; ch < numChannels; ch++) {
+				for (size_t i = 0; i < numFrames; i++) {
+					x.get()[i] = static_cast<double>(input[i * numChannels + ch]);
+				}
+				std::fill(x.get() + numFrames, x.get() + fftSize, 0.0);
+				fftw_execute(forwardPlan.get());
+
+				for (size_t k = 0; k < numTaperBins; k++) {
+					Y.get()[k][0] = X.get()[k][0] * taper[k];
+					Y.get()[k][1] = X.get()[k][1] * taper[k];
+				}
+				for (size_t k = numTaperBins; k < numOutputBins; k++) {
+					Y.get()[k][0] = 0.0;
+					Y.get()[k][1] = 0.0;
+				}
+				fftw_execute(inversePlan.get());
+
+				for (size_t i = 0; i < numOutputFrames; i++) {
+					output[i * numChannels + ch] = static_cast<FloatType>(y.get()[i]);
+				}
+			}
+		}
+
+	private:
+		int L;
+		int M;
+		double passFreq;
+		double stopFreq;
+		double beta;
+		int paddingFrames;
+
+		// isSmooth() : whether n has no prime factors other than 2, 3, 5 and 7
+		static bool isSmooth(uint64_t n) {
+			for (uint64_t p : {2, 3, 5, 7}) {
+				while (n % p == 0) {
+					n /= p;
+				}
+			}
+			return n == 1;
+		}
+
+		// kaiser() : Kaiser window (unnormalized) at u, from 0 to 1 across the transition band
+		double kaiser(double u) const {
+			const double v = 2.0 * u - 1.0;
+			return besselI0(beta * std::sqrt(std::max(0.0, 1.0 - v * v)));
+		}
+
+		// makeTaper() : the taper for each bin of an fftSize-point transform, up to the last bin below stopFreq, scaled by 1 / fftSize.
+		// The running integral of the Kaiser window is accumulated by Simpson's rule between consecutive bins.
+		std::vector<double> makeTaper(size_t fftSize) const {
+			const double scale = 1.0 / static_cast<double>(fftSize);
+			const double width = stopFreq - passFreq;
+			const auto numBins = static_cast<size_t>(std::ceil(stopFreq * static_cast<double>(fftSize)));
+			std::vector<double> taper(numBins, scale);
+
+			auto simpson = [this](double u0, double u1) {
+				return (u1 - u0) / 6.0 * (kaiser(u0) + 4.0 * kaiser(0.5 * (u0 + u1)) + kaiser(u1));
+			};
+
+			const auto firstBin = static_cast<size_t>(std::floor(passFreq * static_cast<double>(fftSize))) + 1;
+			double u0 = 0.0;
+			double integral = 0.0;
+			for (size_t k = firstBin; k < numBins; k++) {
+				const double u = (static_cast<double>(k) / static_cast<double>(fftSize) - passFreq) / width;
+				integral += simpson(u0, u);
+				taper[k] = integral; // (normalized below)
+				u0 = u;
+			}
+			const double total = integral + simpson(u0, 1.0);
+			for (size_t k = firstBin; k < numBins; k++) {
+				taper[k] = scale * (1.0 - taper[k] / total);
+			}
+			return taper;
+		}
+	};
+
+} // namespace ReSampler
+
+#endif // WHOLESIGNALRESAMPLER_H
@@ -0,0 +1,1040 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H 1
+
+// benchmark.h : micro-benchmarks for the DSP code (invoked with the --benchmark option)
+
+#include "FIRFilter.h"
+#include "FFTFilter.h"
+#include "PartitionedFFTFilter.h"
+#include "HalfBandFilter.h"
+#include "MultichannelFIRFilter.h"
+#include "srconvert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ReSampler {
+
+// measureNsPerItem() : repeatedly calls f() (which processes numItems items),
+// and returns the best observed time per item, in nanoseconds
+inline double measureNsPerItem(const std::function<void()>& f, size_t numItems, int numRuns = 5, double minRunSeconds = 0.05) {
+	double best = 0.0;
+	for (int run = 0; run < numRuns; run++) {
+		auto begin = std::chrono::high_resolution_clock::now();
+		size_t items = 0;
+		double elapsed = 0.0;
+		do {
+			f();
+			items += numItems;
+			elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+		} while (elapsed < minRunSeconds);
+		double nsPerItem = 1.0e9 * elapsed / items;
+		best = (run == 0) ? nsPerItem : std::min(best, nsPerItem);
+	}
+	return best;
+}
+
+// makeBenchmarkSignal() : white noise for benchmarking
+template<typename FloatType>
+std::vector<FloatType> makeBenchmarkSignal(size_t length) {
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> dist(-1.0, 1.0);
+	std::vector<FloatType> signal(length);
+	for (auto& s : signal) {
+		s = static_cast<FloatType>(dist(rng));
+	}
+	return signal;
+}
+
+// makeBenchmarkTaps() : lowpass filter for benchmarking
+template<typename FloatType>
+std::vector<FloatType> makeBenchmarkTaps(int numTaps) {
+	std::vector<FloatType> taps(static_cast<size_t>(numTaps), 0);
+	makeLPF<FloatType>(taps.data(), numTaps, 20000, 96000);
+	applyKaiserWindow<FloatType>(taps.data(), numTaps, calcKaiserBeta(160.0));
+	return taps;
+}
+
+// filterBlocks() : filters n samples of input (1:1) using the block interface of the given filter,
+// in blocks of (at most) maxBlockSize samples (0: as many as the filter can take)
+template<typename FloatType, typename Filter>
+void filterBlocks(Filter& filter, const FloatType* input, FloatType* output, size_t n, size_t maxBlockSize = 0) {
+	const size_t blockSize = (maxBlockSize == 0) ? static_cast<size_t>(filter.getBlockSize()) : std::min(maxBlockSize, static_cast<size_t>(filter.getBlockSize()));
+	size_t o = 0;
+	for (size_t i = 0; i < n; ) {
+		auto b = static_cast<int>(std::min(blockSize, n - i));
+		filter.put(input + i, b);
+		for (int age = b - 1; age >= 0; --age) {
+			output[o++] = filter.getAt(age);
+		}
+		i += b;
+	}
+}
+
+// filterBlocks4() : as filterBlocks(), but calculating four outputs at a time with getAt4()
+template<typename FloatType>
+void filterBlocks4(FIRFilter<FloatType>& filter, const FloatType* input, FloatType* output, size_t n) {
+	const size_t blockSize = static_cast<size_t>(filter.getBlockSize());
+	size_t o = 0;
+	for (size_t i = 0; i < n; ) {
+		auto b = static_cast<int>(std::min(blockSize, n - i));
+		filter.put(input + i, b);
+		int age = b - 1;
+		for (; age >= 3; age -= 4) {
+			int ages[4] = {age, age - 1, age - 2, age - 3};
+			filter.getAt4(ages, 0, output + o, 1);
+			o += 4;
+		}
+		for (; age >= 0; --age) {
+			output[o++] = filter.getAt(age);
+		}
+		i += b;
+	}
+}
+
+// benchmarkFIRFilterApi() : compares per-sample put() / get() against block put() / getAt()
+template<typename FloatType>
+void benchmarkFIRFilterApi() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: per-sample API vs block API (ns per output sample)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "per-sample" << std::setw(14) << "block" << std::setw(14) << "overhead" << "\n";
+
+	for (int numTaps : {15, 63, 255, 1023, 4095}) {
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		FIRFilter<FloatType> filter(taps.data(), numTaps);
+
+		double perSample = measureNsPerItem([&]() {
+			for (size_t i = 0; i < n; i++) {
+				filter.put(input[i]);
+				output[i] = filter.get();
+			}
+		}, n);
+
+		double block = measureNsPerItem([&]() {
+			filterBlocks(filter, input.data(), output.data(), n);
+		}, n);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << perSample
+				  << std::setw(14) << block
+				  << std::setw(14) << perSample - block << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkFFTFilter() : compares direct-form (FIRFilter) against overlap-save (FFTFilter) filtering at 1:1 ratio,
+// and reports the filter length at which FFTFilter becomes faster (see FFTFILTER_BREAKEVEN_TAPS)
+template<typename FloatType>
+void benchmarkFFTFilter() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs FFTFilter (ns per output sample)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "direct" << std::setw(14) << "fft" << "\n";
+
+	int breakEven = 0;
+	for (int numTaps : {15, 31, 47, 63, 95, 127, 191, 255, 511, 1023, 4095, 16383, 65535}) {
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		FIRFilter<FloatType> firFilter(taps.data(), numTaps);
+		FFTFilter<FloatType> fftFilter(taps.data(), numTaps);
+
+		double direct = measureNsPerItem([&]() {
+			filterBlocks(firFilter, input.data(), output.data(), n);
+		}, n);
+
+		double fft = measureNsPerItem([&]() {
+			filterBlocks(fftFilter, input.data(), output.data(), n);
+		}, n);
+
+		if (breakEven == 0 && fft < direct) {
+			breakEven = numTaps;
+		}
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << direct
+				  << std::setw(14) << fft << "\n";
+	}
+	std::cout << "break-even: " << breakEven << " taps (FFTFILTER_BREAKEVEN_TAPS = " << FFTFILTER_BREAKEVEN_TAPS << ")\n" << std::endl;
+}
+
+// benchmarkPartitionedFFT() : compares direct-form (FIRFilter), overlap-save (FFTFilter) and uniformly-partitioned (PartitionedFFTFilter) filtering
+// at 1:1 ratio, when the input comes in short blocks (as in low-latency mode), and shows which engine a ResamplingStage would choose
+// (see PARTITIONEDFFT_MAC_COST)
+template<typename FloatType>
+void benchmarkPartitionedFFT() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs FFTFilter vs PartitionedFFTFilter, short blocks (ns per output sample)\n";
+	std::cout << std::setw(8) << "block" << std::setw(8) << "taps" << std::setw(12) << "direct" << std::setw(12) << "fft" << std::setw(14) << "partitioned"
+			  << std::setw(14) << "chosen" << "\n";
+
+	for (int blockSize : {64, 256, 1024}) {
+		for (int numTaps : {255, 1023, 4095, 16383, 65535}) {
+			std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+			FIRFilter<FloatType> firFilter(taps.data(), numTaps);
+			FFTFilter<FloatType> fftFilter(taps.data(), numTaps);
+			PartitionedFFTFilter<FloatType> partitionedFilter(taps.data(), numTaps, PartitionedFFTFilter<FloatType>::calcPartitionSize(blockSize));
+			ResamplingStage<FloatType> stage(1, 1, taps, false, false, 1, blockSize);
+
+			double direct = measureNsPerItem([&]() { filterBlocks(firFilter, input.data(), output.data(), n, blockSize); }, n, 3);
+			double fft = measureNsPerItem([&]() { filterBlocks(fftFilter, input.data(), output.data(), n, blockSize); }, n, 3);
+			double partitioned = measureNsPerItem([&]() { filterBlocks(partitionedFilter, input.data(), output.data(), n, blockSize); }, n, 3);
+
+			std::cout << std::fixed << std::setprecision(2)
+					  << std::setw(8) << blockSize
+					  << std::setw(8) << numTaps
+					  << std::setw(12) << direct
+					  << std::setw(12) << fft
+					  << std::setw(14) << partitioned
+					  << std::setw(14) << (stage.isUsingPartitionedFFT() ? "partitioned" : stage.isUsingFFT() ? "fft" : "direct") << "\n";
+		}
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkSimdLevels() : compares the FIRFilter kernels for each SIMD level supported by this CPU
+template<typename FloatType>
+void benchmarkSimdLevels() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+	const SimdLevel savedLevel = getSimdLevel();
+	const std::vector<int> tapCounts{15, 63, 255, 1023, 4095};
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: SIMD levels (ns per output sample)\n";
+	std::cout << std::setw(8) << "level";
+	for (int numTaps : tapCounts) {
+		std::cout << std::setw(10) << numTaps;
+	}
+	std::cout << "\n";
+
+	for (SimdLevel level : {SimdScalar, SimdSSE2, SimdAVX, SimdAVX2, SimdAVX512}) {
+		if (!setSimdLevel(level)) {
+			continue;
+		}
+		std::cout << std::setw(8) << simdLevelName(level);
+		for (int numTaps : tapCounts) {
+			std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+			FIRFilter<FloatType> filter(taps.data(), numTaps);
+			double t = measureNsPerItem([&]() {
+				filterBlocks(filter, input.data(), output.data(), n);
+			}, n);
+			std::cout << std::fixed << std::setprecision(2) << std::setw(10) << t;
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::endl;
+	setSimdLevel(savedLevel);
+}
+
+// benchmarkMultiOutput() : compares calculating one output at a time (getAt()) against four at a time (getAt4())
+template<typename FloatType>
+void benchmarkMultiOutput() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: getAt() vs getAt4() (ns per output sample)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "getAt" << std::setw(14) << "getAt4" << "\n";
+
+	for (int numTaps : {15, 63, 255, 1023, 4095}) {
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		FIRFilter<FloatType> filter(taps.data(), numTaps);
+
+		double single = measureNsPerItem([&]() {
+			filterBlocks(filter, input.data(), output.data(), n);
+		}, n);
+
+		double multi = measureNsPerItem([&]() {
+			filterBlocks4(filter, input.data(), output.data(), n);
+		}, n);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << single
+				  << std::setw(14) << multi << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkSymmetric() : compares the full kernel against the symmetric (half-length) kernel, for a linear-phase filter
+template<typename FloatType>
+void benchmarkSymmetric() {
+	const size_t n = 32768;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: full vs symmetric kernel (ns per output sample, using getAt() / getAt4())\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "full" << std::setw(14) << "symmetric" << std::setw(14) << "full x4" << std::setw(14) << "symmetric x4" << "\n";
+
+	for (int numTaps : {63, 255, 1023, 4095}) {
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		FIRFilter<FloatType> full(taps.data(), numTaps);
+		FIRFilter<FloatType> symmetric(taps.data(), numTaps, 1, true);
+		double t[4];
+		t[0] = measureNsPerItem([&]() { filterBlocks(full, input.data(), output.data(), n); }, n);
+		t[1] = measureNsPerItem([&]() { filterBlocks(symmetric, input.data(), output.data(), n); }, n);
+		t[2] = measureNsPerItem([&]() { filterBlocks4(full, input.data(), output.data(), n); }, n);
+		t[3] = measureNsPerItem([&]() { filterBlocks4(symmetric, input.data(), output.data(), n); }, n);
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << numTaps;
+		for (double x : t) {
+			std::cout << std::setw(14) << x;
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkKernelLayout() : compares one kernel copy per alignment shift against a single kernel copy (with unaligned signal loads),
+// for getAt(), which is the only method to use the shifted copies (see FIR_SINGLE_KERNEL_MIN_BYTES)
+template<typename FloatType>
+void benchmarkKernelLayout() {
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: shifted kernel copies vs single kernel copy (ns per output sample, using getAt(); kernel KB)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "shifted" << std::setw(14) << "single" << std::setw(14) << "shifted KB" << std::setw(14) << "single KB" << "\n";
+
+	for (int numTaps : {63, 255, 1023, 4095, 16383, 65535, 131071}) {
+		const size_t n = std::max<size_t>(4096, (size_t(1) << 26) / numTaps);
+		std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+		std::vector<FloatType> output(n, 0);
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		FIRFilter<FloatType> shifted(taps.data(), numTaps, 1, false, KernelLayoutShiftedCopies);
+		FIRFilter<FloatType> single(taps.data(), numTaps, 1, false, KernelLayoutSingleCopy);
+		double tShifted = measureNsPerItem([&]() { filterBlocks(shifted, input.data(), output.data(), n); }, n, 3);
+		double tSingle = measureNsPerItem([&]() { filterBlocks(single, input.data(), output.data(), n); }, n, 3);
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << tShifted
+				  << std::setw(14) << tSingle
+				  << std::setw(14) << shifted.getKernelBytes() / 1024
+				  << std::setw(14) << single.getKernelBytes() / 1024 << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkWideAccumulation() : compares FIRFilter<float>, FIRFilter<float> with wide accumulation (single-precision storage, double-precision sums;
+// see setWideAccumulation()) and FIRFilter<double>: the time (using getAt() and getAt4()), and the peak difference from FIRFilter<double> (dB)
+inline void benchmarkWideAccumulation() {
+	std::cout << "FIRFilter<float> vs float with double accumulation vs FIRFilter<double>: ns per output sample (getAt() / getAt4()), and peak difference from double (dB)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(10) << "float" << std::setw(10) << "wide" << std::setw(10) << "double"
+			  << std::setw(10) << "float x4" << std::setw(10) << "wide x4" << std::setw(10) << "double x4"
+			  << std::setw(12) << "float err" << std::setw(12) << "wide err" << "\n";
+
+	const bool savedWideAccumulation = getWideAccumulation();
+	for (int numTaps : {255, 1023, 4095, 16383, 32767}) {
+		const size_t n = static_cast<size_t>(numTaps) + 8192; // (the differences are measured once the history is full)
+		std::vector<float> floatInput = makeBenchmarkSignal<float>(n);
+		std::vector<double> input(floatInput.begin(), floatInput.end());
+		std::vector<float> floatTaps = makeBenchmarkTaps<float>(numTaps);
+		std::vector<double> taps(floatTaps.begin(), floatTaps.end()); // (the same taps, so that only the arithmetic differs)
+		std::vector<float> floatOutput(n, 0);
+		std::vector<float> wideOutput(n, 0);
+		std::vector<double> doubleOutput(n, 0);
+
+		setWideAccumulation(false);
+		FIRFilter<float> floatFilter(floatTaps.data(), numTaps);
+		setWideAccumulation(true);
+		FIRFilter<float> wideFilter(floatTaps.data(), numTaps);
+		setWideAccumulation(false);
+		FIRFilter<double> doubleFilter(taps.data(), numTaps);
+
+		filterBlocks(floatFilter, floatInput.data(), floatOutput.data(), n);
+		filterBlocks(wideFilter, floatInput.data(), wideOutput.data(), n);
+		filterBlocks(doubleFilter, input.data(), doubleOutput.data(), n);
+		double floatError = 0.0;
+		double wideError = 0.0;
+		for (size_t i = static_cast<size_t>(numTaps); i < n; i++) {
+			floatError = std::max(floatError, std::abs(static_cast<double>(floatOutput[i]) - doubleOutput[i]));
+			wideError = std::max(wideError, std::abs(static_cast<double>(wideOutput[i]) - doubleOutput[i]));
+		}
+
+		double t[6];
+		t[0] = measureNsPerItem([&]() { filterBlocks(floatFilter, floatInput.data(), floatOutput.data(), n); }, n, 3);
+		t[1] = measureNsPerItem([&]() { filterBlocks(wideFilter, floatInput.data(), wideOutput.data(), n); }, n, 3);
+		t[2] = measureNsPerItem([&]() { filterBlocks(doubleFilter, input.data(), doubleOutput.data(), n); }, n, 3);
+		t[3] = measureNsPerItem([&]() { filterBlocks4(floatFilter, floatInput.data(), floatOutput.data(), n); }, n, 3);
+		t[4] = measureNsPerItem([&]() { filterBlocks4(wideFilter, floatInput.data(), wideOutput.data(), n); }, n, 3);
+		t[5] = measureNsPerItem([&]() { filterBlocks4(doubleFilter, input.data(), doubleOutput.data(), n); }, n, 3);
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << numTaps;
+		for (double x : t) {
+			std::cout << std::setw(10) << x;
+		}
+		std::cout << std::setprecision(1)
+				  << std::setw(12) << 20.0 * std::log10(floatError)
+				  << std::setw(12) << 20.0 * std::log10(wideError) << "\n";
+	}
+	setWideAccumulation(savedWideAccumulation);
+	std::cout << std::endl;
+}
+
+// benchmarkLazyGet() : compares lazyGet() on a zero-stuffed history (a strided scalar loop)
+// against lazyGet() with the polyphase (contiguous per-phase) kernel layout, for interpolation by L
+template<typename FloatType>
+void benchmarkLazyGet() {
+	const size_t n = 4096;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">::lazyGet(): zero-stuffed vs per-phase kernel (ns per output sample)\n";
+	std::cout << std::setw(8) << "L" << std::setw(8) << "taps" << std::setw(14) << "zero-stuffed" << std::setw(14) << "per-phase" << "\n";
+
+	for (int L : {2, 4, 8, 160}) {
+		const int numTaps = 64 * L - 1;
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		std::vector<FloatType> output(n * L, 0);
+		FIRFilter<FloatType> stuffed(taps.data(), numTaps);
+		FIRFilter<FloatType> perPhase(taps.data(), numTaps, L);
+		auto interpolate = [&](FIRFilter<FloatType>& filter) {
+			size_t o = 0;
+			for (size_t i = 0; i < n; i++) {
+				filter.put(input[i]);
+				output[o++] = filter.lazyGet(L);
+				for (int l = 1; l < L; l++) {
+					filter.putZero();
+					output[o++] = filter.lazyGet(L);
+				}
+			}
+		};
+		double tStuffed = measureNsPerItem([&]() { interpolate(stuffed); }, n * L);
+		double tPerPhase = measureNsPerItem([&]() { interpolate(perPhase); }, n * L);
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << L
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << tStuffed
+				  << std::setw(14) << tPerPhase << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkMirroredHistory() : compares the ordinary signal buffer (whose history is moved back to the top whenever it runs out of room)
+// against a mirrored (ring) buffer, which never needs to move the history (see FIR_MIRRORED_HISTORY_MIN_TAPS)
+template<typename FloatType>
+void benchmarkMirroredHistory() {
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << ">: ordinary vs mirrored history buffer (ns per sample: put() only / filtering with getAt4())\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "put" << std::setw(14) << "put mirrored" << std::setw(14) << "filter" << std::setw(14) << "filt mirrored" << "\n";
+
+	const bool wasEnabled = mirroredBufferEnabled();
+	for (int numTaps : {FIR_MIRRORED_HISTORY_MIN_TAPS + 1, 4 * FIR_MIRRORED_HISTORY_MIN_TAPS - 1}) {
+		const size_t n = std::max<size_t>(8192, (size_t(1) << 26) / numTaps);
+		std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+		std::vector<FloatType> output(n, 0);
+		std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+		double t[4];
+		for (int mirrored = 0; mirrored < 2; mirrored++) {
+			mirroredBufferEnabled() = (mirrored != 0);
+			FIRFilter<FloatType> filter(taps.data(), numTaps);
+			if (filter.hasMirroredHistory() != (mirrored != 0)) {
+				std::cout << std::setw(8) << numTaps << "  (mirrored buffers not available)\n";
+				mirroredBufferEnabled() = wasEnabled;
+				return;
+			}
+			const size_t m = 8 * static_cast<size_t>(filter.getBlockSize());
+			t[mirrored] = measureNsPerItem([&]() {
+				for (size_t i = 0; i < m; i++) {
+					filter.put(input[i % n]);
+				}
+			}, m);
+			t[2 + mirrored] = measureNsPerItem([&]() { filterBlocks4(filter, input.data(), output.data(), n); }, n, 3);
+		}
+		std::cout << std::fixed << std::setprecision(2) << std::setw(8) << numTaps;
+		for (double x : t) {
+			std::cout << std::setw(14) << x;
+		}
+		std::cout << "\n";
+	}
+	mirroredBufferEnabled() = wasEnabled;
+	std::cout << std::endl;
+}
+
+// benchmarkChannelLanes() : compares filtering interleaved multichannel audio with one FIRFilter per channel
+// (including de-interleaving and re-interleaving) against MultichannelFIRFilter (see MULTICHANNEL_MIN_CHANNELS)
+template<typename FloatType>
+void benchmarkChannelLanes() {
+	const size_t numFrames = 16384;
+	const int numTaps = 255;
+	std::vector<FloatType> taps = makeBenchmarkTaps<FloatType>(numTaps);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> per channel vs MultichannelFIRFilter (" << numTaps << " taps, ns per output frame)\n";
+	std::cout << std::setw(8) << "channels" << std::setw(14) << "per-channel" << std::setw(14) << "lanes" << "\n";
+
+	for (int numChannels : {1, 2, 3, 4, 6, 8, 16}) {
+		std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(numFrames * numChannels);
+		std::vector<FloatType> output(numFrames * numChannels, 0);
+		std::vector<FloatType> channelInput(numFrames);
+		std::vector<FloatType> channelOutput(numFrames);
+		std::vector<FIRFilter<FloatType>> filters(static_cast<size_t>(numChannels), FIRFilter<FloatType>(taps.data(), numTaps));
+		MultichannelFIRFilter<FloatType> mcFilter(taps.data(), numTaps, 1, numChannels);
+
+		double perChannel = measureNsPerItem([&]() {
+			for (int ch = 0; ch < numChannels; ch++) {
+				for (size_t i = 0; i < numFrames; i++) {
+					channelInput[i] = input[i * numChannels + ch];
+				}
+				filterBlocks4(filters[ch], channelInput.data(), channelOutput.data(), numFrames);
+				for (size_t i = 0; i < numFrames; i++) {
+					output[i * numChannels + ch] = channelOutput[i];
+				}
+			}
+		}, numFrames);
+
+		double lanes = measureNsPerItem([&]() {
+			const size_t blockSize = static_cast<size_t>(mcFilter.getBlockSize());
+			size_t o = 0;
+			for (size_t i = 0; i < numFrames; ) {
+				auto b = static_cast<int>(std::min(blockSize, numFrames - i));
+				mcFilter.put(input.data() + i * numChannels, b);
+				for (int age = b - 1; age >= 0; --age) {
+					mcFilter.getAt(age, 0, output.data() + o);
+					o += numChannels;
+				}
+				i += b;
+			}
+		}, numFrames);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numChannels
+				  << std::setw(14) << perChannel
+				  << std::setw(14) << lanes << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkHalfBand() : compares 2:1 decimation with FIRFilter (symmetric kernel, getAt4() on every second sample)
+// against HalfBandFilter, for half-band filters of various lengths
+template<typename FloatType>
+void benchmarkHalfBand() {
+	const size_t n = 65536;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(n, 0);
+
+	std::cout << "FIRFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs HalfBandFilter: 2:1 decimation (ns per input sample)\n";
+	std::cout << std::setw(8) << "taps" << std::setw(14) << "FIRFilter" << std::setw(14) << "half-band" << "\n";
+
+	for (int numTaps : {43, 75, 151, 303, 607}) {
+		std::vector<FloatType> taps(static_cast<size_t>(numTaps), 0);
+		makeHalfBandLPF<FloatType>(taps.data(), numTaps);
+		applyKaiserWindow<FloatType>(taps.data(), numTaps, calcKaiserBeta(195.0));
+		FIRFilter<FloatType> filter(taps.data(), numTaps, 1, true);
+		HalfBandFilter<FloatType> hbFilter(taps.data(), numTaps, false);
+
+		double direct = measureNsPerItem([&]() {
+			const size_t blockSize = static_cast<size_t>(filter.getBlockSize());
+			size_t o = 0;
+			for (size_t i = 0; i < n; ) {
+				auto b = static_cast<int>(std::min(blockSize, n - i)); // (an even number)
+				filter.put(input.data() + i, b);
+				for (int age = b - 1; age >= 7; age -= 8) {
+					int ages[4] = {age, age - 2, age - 4, age - 6};
+					filter.getAt4(ages, 0, output.data() + o, 1);
+					o += 4;
+				}
+				i += b;
+			}
+		}, n);
+		double halfBand = measureNsPerItem([&]() { hbFilter.decimate(input.data(), static_cast<int>(n), 0, output.data()); }, n);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(8) << numTaps
+				  << std::setw(14) << direct
+				  << std::setw(14) << halfBand << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkArbitraryRatio() : compares a single ordinary ResamplingStage (L / M polyphase filter) against the FarrowFilter,
+// for conversion ratios of increasing complexity (the ordinary filter is limited to FILTERSIZE_LIMIT taps, so it gets shorter per phase)
+template<typename FloatType>
+void benchmarkArbitraryRatio() {
+	const size_t n = 65536;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+
+	std::cout << "ResamplingStage<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs FarrowFilter (ns per output sample)\n";
+	std::cout << std::setw(16) << "rates" << std::setw(14) << "L/M" << std::setw(14) << "taps/phase" << std::setw(14) << "ordinary"
+			  << std::setw(14) << "taps/phase" << std::setw(14) << "Farrow" << "\n";
+
+	const std::pair<int, int> rates[] = {{44100, 48000}, {44100, 47999}, {48000, 44101}, {96000, 47999}};
+	for (const auto& r : rates) {
+		ConversionInfo ci;
+		ci.inputSampleRate = r.first;
+		ci.outputSampleRate = r.second;
+		ci.lpfCutoff = 100.0 * (10.0 / 11.0);
+		ci.lpfTransitionWidth = 100.0 - ci.lpfCutoff;
+		ci.overSamplingFactor = 1;
+		ci.bMinPhase = false;
+		ci.bEquiripple = false;
+		ci.qualityTier = qualityArchival;
+		Fraction f = getFractionFromSamplerates(r.first, r.second);
+		std::vector<FloatType> output(static_cast<size_t>(2 + std::ceil(static_cast<double>(n) * f.numerator / f.denominator)), 0);
+
+		std::vector<FloatType> taps = makeFilterCoefficients<FloatType>(ci, f);
+		ResamplingStage<FloatType> stage(f.numerator, f.denominator, taps, false, true);
+		std::vector<FloatType> farrowTaps = makeArbitraryRatioCoefficients<FloatType>(ci, FARROW_NUM_PHASES);
+		FarrowFilter<FloatType> farrowFilter(farrowTaps.data(), static_cast<int>(farrowTaps.size()), FARROW_NUM_PHASES, f.numerator, f.denominator);
+		ResamplingStage<FloatType> farrowStage(f.numerator, f.denominator, farrowFilter);
+
+		size_t outSize = 0;
+		const auto numOutputs = static_cast<size_t>(static_cast<double>(n) * f.numerator / f.denominator);
+		double ordinary = measureNsPerItem([&]() { stage.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+		double farrow = measureNsPerItem([&]() { farrowStage.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(16) << (std::to_string(r.first) + "->" + std::to_string(r.second))
+				  << std::setw(14) << (std::to_string(f.numerator) + "/" + std::to_string(f.denominator))
+				  << std::setw(14) << (taps.size() + f.numerator - 1) / f.numerator
+				  << std::setw(14) << ordinary
+				  << std::setw(14) << farrowFilter.getTapsPerPhase()
+				  << std::setw(14) << farrow << "\n";
+	}
+	std::cout << "(the FarrowFilter is used when L or M is at least " << FARROW_MIN_FACTOR << ")\n" << std::endl;
+}
+
+// benchmarkFixedRatio() : compares the general conversion functions of ResamplingStage against the fixed-ratio ones (see fixedRatioConvert()),
+// for each ratio which has one, with a single-stage filter (the engine is chosen as usual)
+template<typename FloatType>
+void benchmarkFixedRatio() {
+	const size_t n = 65536;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+
+	std::cout << "ResamplingStage<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> general vs fixed-ratio conversion functions (ns per output sample)\n";
+	std::cout << std::setw(10) << "L/M" << std::setw(24) << "engine" << std::setw(12) << "taps/phase" << std::setw(12) << "general"
+			  << std::setw(12) << "fixed" << std::setw(10) << "speedup" << "\n";
+
+	const std::pair<int, int> ratios[] = {{2, 1}, {1, 2}, {4, 1}, {1, 4}, {1, 3}, {3, 2}, {2, 3}, {160, 147}, {147, 160},
+										  {1, 7}, {5, 7}, {7, 2}, {7, 4}, {7, 8}, {7, 10}, {7, 16}, {3, 5}};
+	for (const auto& r : ratios) {
+		ConversionInfo ci;
+		ci.inputSampleRate = 1000 * r.second; // (only the ratio of the rates matters)
+		ci.outputSampleRate = 1000 * r.first;
+		ci.lpfCutoff = 100.0 * (10.0 / 11.0);
+		ci.lpfTransitionWidth = 100.0 - ci.lpfCutoff;
+		ci.overSamplingFactor = 1;
+		ci.bMinPhase = false;
+		ci.bEquiripple = false;
+		ci.qualityTier = qualityArchival;
+		Fraction f;
+		f.numerator = r.first;
+		f.denominator = r.second;
+		std::vector<FloatType> taps = makeFilterCoefficients<FloatType>(ci, f);
+		ResamplingStage<FloatType> stage(r.first, r.second, taps, false, true);
+		std::vector<FloatType> output(static_cast<size_t>(2 + std::ceil(static_cast<double>(n) * r.first / r.second)), 0);
+
+		size_t outSize = 0;
+		const auto numOutputs = static_cast<size_t>(static_cast<double>(n) * r.first / r.second);
+		stage.setFixedRatioKernelsEnabled(false);
+		const std::string engine = stage.getFilteringMethod();
+		double general = measureNsPerItem([&]() { stage.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+		stage.setFixedRatioKernelsEnabled(true);
+		double fixed = measureNsPerItem([&]() { stage.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(10) << (std::to_string(r.first) + "/" + std::to_string(r.second))
+				  << std::setw(24) << engine.substr(0, engine.find(' '))
+				  << std::setw(12) << (taps.size() + r.first - 1) / r.first
+				  << std::setw(12) << general
+				  << std::setw(12) << fixed
+				  << std::setw(10) << general / fixed << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkQualityTiers() : compares the whole Converter (with the default multi-stage settings) for each quality tier
+template<typename FloatType>
+void benchmarkQualityTiers() {
+	const size_t n = BUFFERSIZE;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+
+	std::cout << "Converter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> quality tiers (ns per output sample)\n";
+	std::cout << std::setw(16) << "rates";
+	const QualityTier tiers[] = {qualityArchival, quality24Bit, quality16Bit, qualityDraft};
+	for (auto tier : tiers) {
+		std::cout << std::setw(12) << getQualityTierName(tier);
+	}
+	std::cout << "\n";
+
+	const std::pair<int, int> rates[] = {{44100, 48000}, {48000, 44100}, {44100, 88200}, {96000, 48000}, {44100, 96000}};
+	for (const auto& r : rates) {
+		std::cout << std::setw(16) << (std::to_string(r.first) + "->" + std::to_string(r.second));
+		for (auto tier : tiers) {
+			std::vector<std::string> args {"ReSampler", "-i", "in.wav", "-o", "out.wav", "-r", std::to_string(r.second), "--quality", getQualityTierName(tier), "--noTuning"};
+			std::vector<char*> argv;
+			for (auto& arg : args) {
+				argv.push_back(&arg[0]);
+			}
+			ConversionInfo ci;
+			ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+			ci.inputSampleRate = r.first;
+
+			Converter<FloatType> converter(ci);
+			std::vector<FloatType> output(static_cast<size_t>(2 + std::ceil(static_cast<double>(n) * r.second / r.first)), 0);
+			size_t outSize = 0;
+			const auto numOutputs = static_cast<size_t>(static_cast<double>(n) * r.second / r.first);
+			double t = measureNsPerItem([&]() { converter.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+			std::cout << std::fixed << std::setprecision(2) << std::setw(12) << t;
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkStagePlans() : for some multi-stage conversions, compares the stages which would be chosen without the planner (a preset, or the last candidate
+// of getConversionStageCandidates()) with the cheapest plans found by the planner (see planConversionStages()): their estimated cost against the measured time
+template<typename FloatType>
+void benchmarkStagePlans() {
+	const size_t n = BUFFERSIZE;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+
+	std::cout << "Converter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> stage plans: estimated cost (multiply-accumulates per output sample) and time (ns per output sample)\n";
+	std::cout << std::setw(16) << "rates" << std::setw(12) << "plan" << std::setw(12) << "estimate" << std::setw(12) << "time" << "   stages\n";
+
+	const std::pair<int, int> rates[] = {{44100, 32000}, {32000, 44100}, {8000, 44100}, {44100, 16000}, {48000, 44100}, {96000, 44100}};
+	for (const auto& r : rates) {
+		std::vector<std::string> args {"ReSampler", "-i", "in.wav", "-o", "out.wav", "-r", std::to_string(r.second), "--noTuning"};
+		std::vector<char*> argv;
+		for (auto& arg : args) {
+			argv.push_back(&arg[0]);
+		}
+		ConversionInfo ci;
+		ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+		ci.inputSampleRate = r.first;
+		Fraction f = getFractionFromSamplerates(r.first, r.second);
+		StageCostFunction stageCost = Converter<FloatType>::makeStageCostFunction(ci);
+
+		std::vector<std::pair<std::string, StagePlan>> plans;
+		StagePlan unplanned {getConversionStages(f, ci.maxStages, true), 0.0};
+		unplanned.cost = getStagePlanCost(unplanned.stages, getShapingStage(unplanned.stages, true), stageCost);
+		plans.emplace_back("unplanned", unplanned);
+		int rank = 1;
+		for (const auto& plan : planConversionStages(f, ci.maxStages, stageCost, 3)) {
+			plans.emplace_back("#" + std::to_string(rank++), plan);
+		}
+
+		std::vector<FloatType> output(static_cast<size_t>(2 + std::ceil(static_cast<double>(n) * r.second / r.first)), 0);
+		const auto numOutputs = static_cast<size_t>(static_cast<double>(n) * r.second / r.first);
+		for (const auto& plan : plans) {
+			Converter<FloatType> converter(ci, 1, plan.second.stages);
+			size_t outSize = 0;
+			double t = measureNsPerItem([&]() { converter.convert(output.data(), outSize, input.data(), n); }, numOutputs, 3);
+			std::cout << std::fixed << std::setprecision(2)
+					  << std::setw(16) << (std::to_string(r.first) + "->" + std::to_string(r.second))
+					  << std::setw(12) << plan.first
+					  << std::setw(12) << plan.second.cost
+					  << std::setw(12) << t << "   ";
+			dumpFractionList(plan.second.stages);
+			std::cout << "\n";
+		}
+	}
+	std::cout << "(the cheaper of the planner's cheapest plan and the half-band configuration, if the ratio has one, is used)\n" << std::endl;
+}
+
+// benchmarkIIRHalfBand() : compares 2:1 decimation and 1:2 interpolation between 48kHz and 96kHz with the FIR half-band filter (HalfBandFilter)
+// and the IIR half-band filter (IIRHalfBandFilter), both designed for the same passband edge (21818 Hz) and the stopband attenuation of each quality tier
+template<typename FloatType>
+void benchmarkIIRHalfBand() {
+	const size_t n = BUFFERSIZE;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	std::vector<FloatType> output(2 * n, 0);
+	const double highRate = 96000.0;
+	const double passFreq = highRate / 4.0 * (10.0 / 11.0);
+
+	std::cout << "HalfBandFilter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs IIRHalfBandFilter, 96kHz <-> 48kHz (ns per output sample)\n";
+	std::cout << std::setw(10) << "quality" << std::setw(10) << "FIR taps" << std::setw(12) << "decimate" << std::setw(12) << "interpolate"
+			  << std::setw(12) << "IIR coefs" << std::setw(12) << "decimate" << std::setw(12) << "interpolate" << "\n";
+
+	const QualityTier tiers[] = {qualityArchival, quality24Bit, quality16Bit, qualityDraft};
+	for (auto tier : tiers) {
+		std::vector<FloatType> taps = makeHalfBandCoefficients<FloatType>(highRate, highRate / 4.0 - passFreq, tier);
+		ResamplingStage<FloatType> firDecimator(1, 2, taps, false, true);
+		ResamplingStage<FloatType> firInterpolator(2, 1, taps, false, true);
+		std::vector<double> coefficients = makeIIRHalfBandCoefficients(getSidelobeAttenuation(tier, true), 0.5 - 2.0 * passFreq / highRate);
+		ResamplingStage<FloatType> iirDecimator(1, 2, IIRHalfBandFilter<FloatType>(coefficients, false));
+		ResamplingStage<FloatType> iirInterpolator(2, 1, IIRHalfBandFilter<FloatType>(coefficients, true));
+
+		size_t outSize = 0;
+		double firDecimate = measureNsPerItem([&]() { firDecimator.convert(output.data(), outSize, input.data(), n); }, n / 2);
+		double firInterpolate = measureNsPerItem([&]() { firInterpolator.convert(output.data(), outSize, input.data(), n); }, 2 * n);
+		double iirDecimate = measureNsPerItem([&]() { iirDecimator.convert(output.data(), outSize, input.data(), n); }, n / 2);
+		double iirInterpolate = measureNsPerItem([&]() { iirInterpolator.convert(output.data(), outSize, input.data(), n); }, 2 * n);
+
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(10) << getQualityTierName(tier)
+				  << std::setw(10) << taps.size()
+				  << std::setw(12) << firDecimate
+				  << std::setw(12) << firInterpolate
+				  << std::setw(12) << coefficients.size()
+				  << std::setw(12) << iirDecimate
+				  << std::setw(12) << iirInterpolate << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// benchmarkWholeSignal() : compares the time taken to convert a whole (mono) clip with a Converter (including its construction,
+// and feeding it a block of BUFFERSIZE samples at a time) and with a WholeSignalResampler (including its FFT plans), for a few clip lengths
+template<typename FloatType>
+void benchmarkWholeSignal() {
+	std::cout << "Converter<" << (sizeof(FloatType) == 8 ? "double" : "float") << "> vs WholeSignalResampler (ms per clip)\n";
+	std::cout << std::setw(16) << "rates" << std::setw(12) << "seconds" << std::setw(12) << "Converter" << std::setw(14) << "whole-signal" << "\n";
+
+	const std::pair<int, int> rates[] = {{44100, 48000}, {48000, 44100}, {48000, 96000}};
+	const int durations[] = {1, 5, 10};
+	for (const auto& r : rates) {
+		std::vector<std::string> args {"ReSampler", "-i", "in.wav", "-o", "out.wav", "-r", std::to_string(r.second), "--noTuning"};
+		std::vector<char*> argv;
+		for (auto& arg : args) {
+			argv.push_back(&arg[0]);
+		}
+		ConversionInfo ci;
+		ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+		ci.inputSampleRate = r.first;
+
+		for (int seconds : durations) {
+			const auto n = static_cast<size_t>(seconds) * r.first;
+			std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+			std::vector<FloatType> output(static_cast<size_t>(2 + std::ceil(static_cast<double>(n) * r.second / r.first)), 0);
+
+			double blockwise = measureNsPerItem([&]() {
+				Converter<FloatType> converter(ci);
+				size_t outSize = 0;
+				FloatType* out = output.data();
+				for (size_t i = 0; i < n; i += BUFFERSIZE) {
+					converter.convert(out, outSize, input.data() + i, std::min(n - i, static_cast<size_t>(BUFFERSIZE)));
+					out += outSize;
+				}
+			}, 1, 3);
+			double wholeSignal = measureNsPerItem([&]() {
+				WholeSignalResampler<FloatType> resampler = makeWholeSignalResampler<FloatType>(ci);
+				resampler.convert(input.data(), n, 1, output.data());
+			}, 1, 3);
+
+			std::cout << std::fixed << std::setprecision(2)
+					  << std::setw(16) << (std::to_string(r.first) + "->" + std::to_string(r.second))
+					  << std::setw(12) << seconds
+					  << std::setw(12) << blockwise / 1.0e6
+					  << std::setw(14) << wholeSignal / 1.0e6 << "\n";
+		}
+	}
+	std::cout << "(files of up to " << WHOLESIGNAL_MAX_FRAMES << " frames are converted whole, unless --noWholeSignal is given)\n" << std::endl;
+}
+
+// convertBlocks() : converts n samples of input with the converter, in blocks of BUFFERSIZE samples, and returns the number of output samples
+template<typename FloatType>
+size_t convertBlocks(Converter<FloatType>& converter, const FloatType* input, FloatType* output, size_t n) {
+	size_t total = 0;
+	for (size_t i = 0; i < n; i += BUFFERSIZE) {
+		size_t outSize = 0;
+		converter.convert(output + total, outSize, input + i, std::min(n - i, static_cast<size_t>(BUFFERSIZE)));
+		total += outSize;
+	}
+	return total;
+}
+
+// benchmarkMixedPrecision() : for some multi-stage decimations, compares Converter<float>, Converter<double>,
+// and Converter<double> with --mixedPrecision (single precision before the shaping stage): the time, and the peak difference from Converter<double>
+inline void benchmarkMixedPrecision() {
+	const size_t n = 4 * BUFFERSIZE;
+	std::vector<double> input = makeBenchmarkSignal<double>(n);
+	std::vector<float> floatInput(input.begin(), input.end());
+
+	std::cout << "Converter<float> vs Converter<double> vs mixed precision: ns per output sample, and peak difference from double precision (dB)\n";
+	std::cout << std::setw(16) << "rates" << std::setw(10) << "float" << std::setw(10) << "double" << std::setw(10) << "mixed"
+			  << std::setw(12) << "float err" << std::setw(12) << "mixed err" << "   single-precision stages\n";
+
+	const std::pair<int, int> rates[] = {{192000, 48000}, {192000, 44100}, {352800, 48000}, {768000, 48000}, {705600, 44100}, {2822400, 88200}};
+	for (const auto& r : rates) {
+		std::vector<std::string> args {"ReSampler", "-i", "in.wav", "-o", "out.wav", "-r", std::to_string(r.second), "--noTuning"};
+		std::vector<char*> argv;
+		for (auto& arg : args) {
+			argv.push_back(&arg[0]);
+		}
+		ConversionInfo ci;
+		ci.fromCmdLineArgs(static_cast<int>(argv.size()), argv.data());
+		ci.inputSampleRate = r.first;
+		ConversionInfo mixedCi = ci;
+		mixedCi.bUseDoublePrecision = true;
+		mixedCi.bMixedPrecision = true;
+
+		const auto maxOutputs = static_cast<size_t>(std::ceil(static_cast<double>(n) * r.second / r.first)) + 2 * (n / BUFFERSIZE + 1);
+		std::vector<float> floatOutput(maxOutputs, 0);
+		std::vector<double> doubleOutput(maxOutputs, 0);
+		std::vector<double> mixedOutput(maxOutputs, 0);
+		Converter<float> floatConverter(ci);
+		Converter<double> doubleConverter(ci);
+		Converter<double> mixedConverter(mixedCi);
+
+		const size_t numOutputs = convertBlocks(doubleConverter, input.data(), doubleOutput.data(), n);
+		convertBlocks(floatConverter, floatInput.data(), floatOutput.data(), n);
+		convertBlocks(mixedConverter, input.data(), mixedOutput.data(), n);
+		double floatError = 0.0;
+		double mixedError = 0.0;
+		for (size_t i = 0; i < numOutputs; i++) {
+			floatError = std::max(floatError, std::abs(static_cast<double>(floatOutput[i]) - doubleOutput[i]));
+			mixedError = std::max(mixedError, std::abs(mixedOutput[i] - doubleOutput[i]));
+		}
+
+		double tFloat = measureNsPerItem([&]() { convertBlocks(floatConverter, floatInput.data(), floatOutput.data(), n); }, numOutputs, 3);
+		double tDouble = measureNsPerItem([&]() { convertBlocks(doubleConverter, input.data(), doubleOutput.data(), n); }, numOutputs, 3);
+		double tMixed = measureNsPerItem([&]() { convertBlocks(mixedConverter, input.data(), mixedOutput.data(), n); }, numOutputs, 3);
+
+		// (the gain of L is applied by the caller, so the differences are scaled by L too)
+		const double L = getFractionFromSamplerates(r.first, r.second).numerator;
+		std::cout << std::fixed << std::setprecision(2)
+				  << std::setw(16) << (std::to_string(r.first) + "->" + std::to_string(r.second))
+				  << std::setw(10) << tFloat
+				  << std::setw(10) << tDouble
+				  << std::setw(10) << tMixed
+				  << std::setprecision(1)
+				  << std::setw(12) << 20.0 * std::log10(L * floatError)
+				  << std::setw(12) << 20.0 * std::log10(L * mixedError) << "   "
+				  << mixedConverter.getNumFloatStages() << "\n";
+	}
+	std::cout << std::endl;
+}
+
+// autotune() : (--autotune) times the conversion described by ci (one channel at a time) with each combination of the candidate stages
+// (the stages which would otherwise be chosen, and the cheapest plans of planConversionStages()), the block sizes (input frames per call of
+// Converter::convert()), and with and without the fixed-ratio conversion functions, and returns the fastest in best.
+// Returns false if the conversion isn't done in stages (see Converter::isMultistageConversion()), so there is nothing to tune
+template<typename FloatType>
+bool autotune(const ConversionInfo& ci, TuningEntry& best) {
+	if (!Converter<FloatType>::isMultistageConversion(ci)) {
+		return false;
+	}
+
+	ConversionInfo tuningCi = ci;
+	tuningCi.bShowStages = false;
+	const Fraction f = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
+	const bool useHalfBandStages = !ci.bMinPhase || ci.bIIR;
+	StageCostFunction stageCost = Converter<FloatType>::makeStageCostFunction(tuningCi);
+
+	// (the half-band configuration, if any, is a candidate even when the planner estimates it to be dearer)
+	std::vector<std::vector<Fraction>> candidates {getConversionStages(f, ci.maxStages, useHalfBandStages, stageCost)};
+	auto addCandidate = [&candidates](const std::vector<Fraction>& candidate) {
+		if (!candidate.empty() && std::none_of(candidates.begin(), candidates.end(), [&candidate](const std::vector<Fraction>& stages) {
+			return stages.size() == candidate.size() && std::equal(stages.begin(), stages.end(), candidate.begin(), [](const Fraction& a, const Fraction& b) {
+				return a.numerator == b.numerator && a.denominator == b.denominator;
+			});
+		})) {
+			candidates.push_back(candidate);
+		}
+	};
+	if (useHalfBandStages) {
+		addCandidate(getHalfBandConversionStages(f, ci.maxStages));
+	}
+	for (const auto& plan : planConversionStages(f, ci.maxStages, stageCost, 4)) {
+		addCandidate(plan.stages);
+	}
+
+	// (in low-latency mode, the block size is given)
+	const std::vector<int> blockSizes = ci.bLowLatency ? std::vector<int>{ci.lowLatencyBlockSize} : std::vector<int>{4096, 8192, 16384, BUFFERSIZE};
+
+	const size_t n = 4 * BUFFERSIZE;
+	std::vector<FloatType> input = makeBenchmarkSignal<FloatType>(n);
+	const size_t numBlocks = n / static_cast<size_t>(blockSizes.front()) + 1; // (each block may produce one more output than its share)
+	std::vector<FloatType> output(static_cast<size_t>(std::ceil(static_cast<double>(n) * f.numerator / f.denominator)) + 2 * numBlocks, 0);
+	const auto numOutputs = static_cast<size_t>(static_cast<double>(n) * f.numerator / f.denominator);
+
+	std::cout << "Autotuning " << ci.inputSampleRate << "->" << ci.outputSampleRate << " (" << (sizeof(FloatType) == 8 ? "double" : "float")
+			  << "): ns per output sample\n";
+	std::cout << std::setw(8) << "block" << std::setw(10) << "kernels" << std::setw(12) << "time" << "   stages\n";
+
+	best.nsPerOutput = 0.0;
+	for (const auto& stages : candidates) {
+		Converter<FloatType> converter(tuningCi, 1, stages);
+		const bool fixedRatioKernels = converter.isUsingFixedRatioKernel();
+		for (int kernels = 0; kernels < (fixedRatioKernels ? 2 : 1); kernels++) {
+			converter.setFixedRatioKernelsEnabled(kernels == 0);
+			for (int blockSize : blockSizes) {
+				double t = measureNsPerItem([&]() {
+					size_t outSize = 0;
+					FloatType* out = output.data();
+					for (size_t i = 0; i < n; i += static_cast<size_t>(blockSize)) {
+						converter.convert(out, outSize, input.data() + i, std::min(n - i, static_cast<size_t>(blockSize)));
+						out += outSize;
+					}
+				}, numOutputs, 3);
+
+				std::cout << std::fixed << std::setprecision(2)
+						  << std::setw(8) << blockSize
+						  << std::setw(10) << (!fixedRatioKernels ? "-" : (kernels == 0 ? "fixed" : "general"))
+						  << std::setw(12) << t << "   ";
+				dumpFractionList(stages);
+				std::cout << "\n";
+
+				if (best.nsPerOutput == 0.0 || t < best.nsPerOutput) {
+					best = TuningEntry{stages, blockSize, kernels == 0, t};
+				}
+			}
+		}
+	}
+
+	std::cout << "Fastest: ";
+	dumpFractionList(best.stages);
+	std::cout << " (block size " << best.blockSize << (best.fixedRatioKernels ? "" : ", general conversion functions") << ", "
+			  << std::fixed << std::setprecision(2) << best.nsPerOutput << " ns per output sample)" << std::endl;
+	return true;
+}
+
+// runBenchmarks() : run all benchmarks
+inline void runBenchmarks() {
+	std::cout << "SIMD level: " << simdLevelName(getSimdLevel()) << " (detected: " << simdLevelName(detectSimdLevel()) << ")\n" << std::endl;
+	benchmarkFIRFilterApi<float>();
+	benchmarkFIRFilterApi<double>();
+	benchmarkSimdLevels<float>();
+	benchmarkSimdLevels<double>();
+	benchmarkMultiOutput<float>();
+	benchmarkMultiOutput<double>();
+	benchmarkSymmetric<float>();
+	benchmarkSymmetric<double>();
+	benchmarkKernelLayout<float>();
+	benchmarkKernelLayout<double>();
+	benchmarkWideAccumulation();
+	benchmarkLazyGet<float>();
+	benchmarkLazyGet<double>();
+	benchmarkMirroredHistory<float>();
+	benchmarkMirroredHistory<double>();
+	benchmarkChannelLanes<float>();
+	benchmarkChannelLanes<double>();
+	benchmarkHalfBand<float>();
+	benchmarkHalfBand<double>();
+	benchmarkIIRHalfBand<float>();
+	benchmarkIIRHalfBand<double>();
+	benchmarkFFTFilter<float>();
+	benchmarkFFTFilter<double>();
+	benchmarkPartitionedFFT<float>();
+	benchmarkPartitionedFFT<double>();
+	benchmarkArbitraryRatio<float>();
+	benchmarkArbitraryRatio<double>();
+	benchmarkFixedRatio<float>();
+	benchmarkFixedRatio<double>();
+	benchmarkQualityTiers<float>();
+	benchmarkQualityTiers<double>();
+	benchmarkStagePlans<float>();
+	benchmarkStagePlans<double>();
+	benchmarkMixedPrecision();
+	benchmarkWholeSignal<float>();
+	benchmarkWholeSignal<double>();
+}
+
+} // namespace ReSampler
+
+#endif // BENCHMARK_H
@@ -1,9 +1,11 @@
 #include "conversioninfo.h"
 #include "ditherer.h"
+#include "tuning.h"
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <map>
 #include <stdexcept>
 
 namespace ReSampler {
@@ -109,9 +111,14 @@ std::string ConversionInfo::toCmdLineArgs() {
 	args.emplace_back("-r");
 	args.push_back(std::to_string(outputSampleRate));
 
-	if(bUseDoublePrecision)
+	if (bMixedPrecision)
+		args.emplace_back("--mixedPrecision");
+	else if(bUseDoublePrecision)
 		args.emplace_back("--doubleprecision");
 
+	if (bWideAccumulation)
+		args.emplace_back("--wideAccumulation");
+
 	if(bNormalize) {
 		args.emplace_back("-n");
 		args.push_back(std::to_string(normalizeAmount));
@@ -120,6 +127,26 @@ std::string ConversionInfo::toCmdLineArgs() {
 	if(bMinPhase)
 		args.emplace_back("--minphase");
 
+	if (bEquiripple) {
+		args.emplace_back("--equiripple");
+		if (equiripplePassbandRipple > 0.0) {
+			args.push_back(std::to_string(equiripplePassbandRipple));
+		}
+	}
+
+	if (bIIR) {
+		args.emplace_back("--iir");
+	}
+
+	if (!bWholeSignal) {
+		args.emplace_back("--noWholeSignal");
+	}
+
+	if (bLowLatency) {
+		args.emplace_back("--lowLatency");
+		args.push_back(std::to_string(lowLatencyBlockSize));
+	}
+
 	if (lpfMode == custom) {
 		args.emplace_back("--lpf-cutoff");
 		args.push_back(std::to_string(lpfCutoff));
@@ -127,11 +154,21 @@ std::string ConversionInfo::toCmdLineArgs() {
 		args.push_back(std::to_string(lpfTransitionWidth));
 	}
 
+	if (qualityTier != qualityArchival) {
+		args.emplace_back("--quality");
+		args.push_back(getQualityTierName(qualityTier));
+	}
+
 	if (maxStages == 1) {
 		args.emplace_back("--maxStages");
 		args.push_back(std::to_string(maxStages));
 	}
 
+	if (bVariableRatio) {
+		args.emplace_back("--ratioSchedule");
+		args.push_back(ratioScheduleFilename);
+	}
+
 	for(auto it = args.begin(); it != args.end(); it++) {
 		result.append(*it);
 		if(it != std::prev(args.end()))
@@ -153,6 +190,56 @@ int getDefaultNoiseShape(int sampleRate) {
 	return DitherProfileID::flat_f;
 }
 
+// getQualityTierFromBitFormat() : quality tier appropriate to an output bit format (see subFormats in ReSampler.h),
+// according to the number of bits it can resolve (or quantizeBits, if smaller and non-zero)
+QualityTier getQualityTierFromBitFormat(const std::string& bitFormat, int quantizeBits) {
+	static const std::map<std::string, int> resolution {
+		{"s8", 8}, {"u8", 8}, {"8", 8}, {"16", 16}, {"24", 24}, {"32", 32}, {"32f", 24}, {"64f", 53},
+		{"ulaw", 14}, {"alaw", 13}, {"ima-adpcm", 12}, {"ms-adpcm", 12}, {"gsm610", 12}, {"vox-adpcm", 12},
+		{"g721-32", 12}, {"g723-24", 12}, {"g723-40", 12}, {"dwvw12", 12}, {"dwvw16", 16}, {"dwvw24", 24}, {"dwvwn", 32},
+		{"dpcm8", 8}, {"dpcm16", 16}, {"vorbis", 16}, {"alac16", 16}, {"alac20", 20}, {"alac24", 24}, {"alac32", 32}
+	};
+
+	auto it = resolution.find(bitFormat);
+	int bits = (it != resolution.end()) ? it->second : 16;
+	if (quantizeBits > 0) {
+		bits = std::min(bits, quantizeBits);
+	}
+
+	if (bits <= 12) {
+		return qualityDraft;
+	}
+	if (bits <= 16) {
+		return quality16Bit;
+	}
+	if (bits <= 24) {
+		return quality24Bit;
+	}
+	return qualityArchival;
+}
+
+std::string getQualityTierName(QualityTier tier) {
+	switch (tier) {
+	case quality24Bit:
+		return "24";
+	case quality16Bit:
+		return "16";
+	case qualityDraft:
+		return "draft";
+	case qualityAuto:
+		return "auto";
+	default:
+		return "archival";
+	}
+}
+
+void ConversionInfo::setQualityTier(QualityTier tier) {
+	qualityTier = tier;
+	if (tier == qualityDraft && lpfMode == normal) {
+		lpfTransitionWidth *= 2.0; // (same cutoff, but wide transition)
+	}
+}
+
 // fromCmdLineArgs()
 // Return value indicates whether caller should continue execution (ie true: continue, false: terminate)
 // Some commandline options (eg --version) should result in termination, but not error.
@@ -168,6 +255,8 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	gain = 1.0;
 	limit = 1.0;
 	bUseDoublePrecision = false;
+	bMixedPrecision = false;
+	bWideAccumulation = false;
 	bNormalize = false;
 	normalizeAmount = 1.0;
 	outputFormat = 0;
@@ -178,6 +267,14 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	bAutoBlankingEnabled = false;
 	bDelayTrim = true;
 	bMinPhase = false;
+	bEquiripple = false;
+	equiripplePassbandRipple = 0.0;
+	bIIR = false;
+	bWholeSignal = true;
+	bLowLatency = false;
+	lowLatencyBlockSize = 256;
+	bAutotune = false;
+	tuningDatabase.clear();
 	bSetFlacCompression = false;
 	flacCompressionLevel = 5;
 	bSetVorbisQuality = true;
@@ -186,6 +283,7 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	lpfMode = normal;
 	lpfCutoff = 100.0 * (10.0 / 11.0);
 	lpfTransitionWidth = 100.0 - lpfCutoff;
+	qualityTier = qualityArchival;
 	bUseSeed = false;
 	seed = 0;
 	dsfInput = false;
@@ -199,6 +297,9 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	bSingleStage = false;
 	bMultiStage = true;
 	bShowStages = false;
+	bVariableRatio = false;
+	ratioScheduleFilename.clear();
+	minRatioFactor = 1.0;
 	bTmpFile = true;
 	bShowTempFile = false;
 	overSamplingFactor = 1;
@@ -216,6 +317,11 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	// get extended parameters
 	getCmdlineParam(argv, argv + argc, "--gain", gain);
 	bUseDoublePrecision = getCmdlineParam(argv, argv + argc, "--doubleprecision");
+	bMixedPrecision = getCmdlineParam(argv, argv + argc, "--mixedPrecision");
+	if (bMixedPrecision) {
+		bUseDoublePrecision = true;
+	}
+	bWideAccumulation = getCmdlineParam(argv, argv + argc, "--wideAccumulation");
 	disableClippingProtection = getCmdlineParam(argv, argv + argc, "--noClippingProtection");
 	bNormalize = getCmdlineParam(argv, argv + argc, "-n", normalizeAmount);
 	bDither = getCmdlineParam(argv, argv + argc, "--dither", ditherAmount);
@@ -226,6 +332,14 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	bUseSeed = getCmdlineParam(argv, argv + argc, "--seed", seed);
 	bDelayTrim = !getCmdlineParam(argv, argv + argc, "--noDelayTrim");
 	bMinPhase = getCmdlineParam(argv, argv + argc, "--minphase");
+	bEquiripple = getCmdlineParam(argv, argv + argc, "--equiripple", equiripplePassbandRipple);
+	bIIR = getCmdlineParam(argv, argv + argc, "--iir");
+	bWholeSignal = !getCmdlineParam(argv, argv + argc, "--noWholeSignal");
+	bLowLatency = getCmdlineParam(argv, argv + argc, "--lowLatency", lowLatencyBlockSize);
+	bAutotune = getCmdlineParam(argv, argv + argc, "--autotune");
+	if (!getCmdlineParam(argv, argv + argc, "--noTuning") && !getCmdlineParam(argv, argv + argc, "--tuningDB", tuningDatabase)) {
+		tuningDatabase = getDefaultTuningDatabasePath();
+	}
 	bSetFlacCompression = getCmdlineParam(argv, argv + argc, "--flacCompression", flacCompressionLevel);
 	bSetVorbisQuality = getCmdlineParam(argv, argv + argc, "--vorbisQuality", vorbisQuality);
 	bMultiThreaded = getCmdlineParam(argv, argv + argc, "--mt");
@@ -261,6 +375,7 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 		bSingleStage = false;
 
 	bShowStages = getCmdlineParam(argv, argv + argc, "--showStages");
+	bVariableRatio = getCmdlineParam(argv, argv + argc, "--ratioSchedule", ratioScheduleFilename);
 
 	// LPFilter settings:
 	if (getCmdlineParam(argv, argv + argc, "--relaxedLPF")) {
@@ -282,6 +397,22 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 		}
 	}
 
+	// quality tier (after LPF settings, which it may modify):
+	std::string qualityTierName;
+	bool unknownQualityTier = false;
+	if (getCmdlineParam(argv, argv + argc, "--quality", qualityTierName)) {
+		if (qualityTierName.empty() || qualityTierName[0] == '-') {
+			qualityTierName = getQualityTierName(qualityAuto); // (--quality on its own, at the end or followed by another option)
+		}
+		unknownQualityTier = true;
+		for (auto t : {qualityArchival, quality24Bit, quality16Bit, qualityDraft, qualityAuto}) {
+			if (qualityTierName == getQualityTierName(t)) {
+				setQualityTier(t);
+				unknownQualityTier = false;
+			}
+		}
+	}
+
 	if (getCmdlineParam(argv, argv + argc, "--raw-input")) {
 		std::vector<std::string> rawInputParams;
 		if (getCmdlineParam(argv, argv + argc, "--raw-input", rawInputParams)) {
@@ -317,7 +448,9 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 	constrainInt(maxStages, 1, 10);
 	constrainDouble(lpfCutoff, 1.0, 99.9);
 	constrainDouble(lpfTransitionWidth, 0.1, 400.0);
+	constrainDouble(equiripplePassbandRipple, 0.0, 1.0);
 	constrainInt(progressUpdates, 0, 100);
+	constrainInt(lowLatencyBlockSize, 16, 32768); // (up to BUFFERSIZE)
 
 	if (bNormalize) {
 		if (normalizeAmount <= 0.0)
@@ -368,6 +501,11 @@ bool ConversionInfo::fromCmdLineArgs(int argc, char** argv) {
 		bBadParams = true;
 	}
 
+	if (unknownQualityTier) {
+		std::cout << "Error: unknown quality tier '" << qualityTierName << "' (expected archival, 24, 16, draft or auto)" << std::endl;
+		bBadParams = true;
+	}
+
 	return !bBadParams;
 }
 
@@ -27,6 +27,16 @@ typedef enum {
 	custom
 } LPFMode;
 
+// QualityTier : trades filter length for stopband attenuation, according to what the output format can resolve
+// (see getSidelobeAttenuation() in srconvert.h). qualityAuto is resolved from the output bit format before conversion.
+typedef enum {
+	qualityArchival,
+	quality24Bit,
+	quality16Bit,
+	qualityDraft,
+	qualityAuto
+} QualityTier;
+
 // struct ConversionInfo : structure for holding all the parameters required for a conversion job
 struct ConversionInfo
 {
@@ -37,6 +47,8 @@ struct ConversionInfo
 	double gain;
 	double limit;
 	bool bUseDoublePrecision;
+	bool bMixedPrecision; // (with bUseDoublePrecision) the stages before the shaping stage of a multi-stage conversion convert in single precision
+	bool bWideAccumulation; // single-precision FIR filters accumulate in double precision (see setWideAccumulation())
 	bool bNormalize;
 	double normalizeAmount;
 	int outputFormat;
@@ -47,6 +59,14 @@ struct ConversionInfo
 	bool bAutoBlankingEnabled;
 	bool bDelayTrim;
 	bool bMinPhase;
+	bool bEquiripple;
+	double equiripplePassbandRipple; // (dB; 0: same as the Kaiser design)
+	bool bIIR; // use IIR half-band filters for 2:1 and 1:2 stages
+	bool bWholeSignal; // convert short files all at once, in the frequency domain (see shouldUseWholeSignal())
+	bool bLowLatency; // convert in short blocks, as for a live feed
+	int lowLatencyBlockSize; // (low-latency mode) input frames per block
+	bool bAutotune; // time the candidate stages, block sizes and conversion functions on this machine, and save the fastest in the tuning database
+	std::string tuningDatabase; // file of the fastest conversions found by --autotune (see tuning.h). Empty: not used
 	bool bSetFlacCompression;
 	int flacCompressionLevel;
 	bool bSetVorbisQuality;
@@ -55,6 +75,7 @@ struct ConversionInfo
 	LPFMode lpfMode;
 	double lpfCutoff;
 	double lpfTransitionWidth;
+	QualityTier qualityTier;
 	bool bUseSeed;
 	int seed;
 	bool dsfInput;
@@ -69,6 +90,9 @@ struct ConversionInfo
 	bool bSingleStage;
 	bool bMultiStage;
 	bool bShowStages;
+	bool bVariableRatio;
+	std::string ratioScheduleFilename;
+	double minRatioFactor; // (variable-ratio mode) smallest ratio factor in the schedule, which the anti-aliasing filter is designed for (set when the schedule is loaded)
 	int progressUpdates;
 	int overSamplingFactor;
 	bool bBadParams;
@@ -92,6 +116,7 @@ struct ConversionInfo
 	// functions
 	bool fromCmdLineArgs(int argc, char **argv); // populate ConversionInfo from args
 	std::string toCmdLineArgs(); // format ConversionInfo into a space-separated string of args
+	void setQualityTier(QualityTier tier); // set quality tier (and widen the transition band of the lowpass filter for draft quality)
 };
 
 std::string sanitize(const std::string& str);
@@ -101,6 +126,8 @@ bool getCmdlineParam(char** begin, char** end, const std::string& option, std::s
 bool getCmdlineParam(char** begin, char** end, const std::string& option, std::vector<std::string>& parameters); // fetch a vector of strings
 bool getCmdlineParam(char** begin, char** end, const std::string& option); // detect presence of command-line switch only
 int getDefaultNoiseShape(int sampleRate);
+QualityTier getQualityTierFromBitFormat(const std::string& bitFormat, int quantizeBits = 0);
+std::string getQualityTierName(QualityTier tier);
 
 static_assert(std::is_copy_constructible<ConversionInfo>::value,
 	"ConversionInfo must be copy constructible");
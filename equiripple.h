@@ -0,0 +1,314 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// equiripple.h : equiripple (Parks-McClellan) lowpass filter design, as an alternative to makeLPF() + applyKaiserWindow(),
+// and measurement of the passband ripple / stopband attenuation of lowpass filters (for comparing the two designs)
+
+#ifndef RESAMPLER_EQUIRIPPLE_H
+#define RESAMPLER_EQUIRIPPLE_H 1
+
+#include "FIRFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+#define EQUIRIPPLE_MAX_TAPS 2047 // longest filter for which the equiripple design is attempted (the design time grows as the cube of the length)
+#define EQUIRIPPLE_GRID_DENSITY 16 // grid points per extremal frequency
+#define EQUIRIPPLE_MAX_ITERATIONS 100
+
+namespace ReSampler {
+
+	// LPFResponse : measured response of a lowpass filter (normalised to its DC gain), for a given passband and stopband
+	struct LPFResponse {
+		double passbandRipple;	// largest deviation from unity gain in the passband (linear)
+		double stopbandPeak;	// largest gain in the stopband (linear)
+
+		double passbandRippleDB() const {
+			return 20.0 * std::log10(1.0 + passbandRipple);
+		}
+
+		double stopbandAttenuationDB() const {
+			return -20.0 * std::log10(std::max(stopbandPeak, std::numeric_limits<double>::min()));
+		}
+	};
+
+	// measureLPFResponse() : measures the response of the filter (with FFT), where passbandEdge and stopbandEdge are normalised frequencies (0 ... 0.5)
+	template<typename FloatType>
+	LPFResponse measureLPFResponse(const FloatType* filter, int Length, double passbandEdge, double stopbandEdge)
+	{
+		size_t fftLength = 1024;
+		while (fftLength < 16 * static_cast<size_t>(Length)) {
+			fftLength *= 2;
+		}
+		std::vector<std::complex<double>> input(fftLength, 0.0);
+		double dcGain = 0.0;
+		for (int n = 0; n < Length; ++n) {
+			input[n] = filter[n];
+			dcGain += filter[n];
+		}
+		std::vector<std::complex<double>> H = fftV(input);
+
+		LPFResponse r{ 0.0, 0.0 };
+		for (size_t k = 0; k <= fftLength / 2; ++k) {
+			double f = static_cast<double>(k) / fftLength;
+			double mag = std::abs(H[k]) / std::abs(dcGain);
+			if (f <= passbandEdge) {
+				r.passbandRipple = std::max(r.passbandRipple, std::abs(mag - 1.0));
+			}
+			else if (f >= stopbandEdge) {
+				r.stopbandPeak = std::max(r.stopbandPeak, mag);
+			}
+		}
+		return r;
+	}
+
+	// getKaiserTransitionWidth() : (normalised) width of the transition band of a Kaiser-windowed sinc of the given length and attenuation.
+	// The band is centred on the cutoff frequency given to makeLPF().
+	inline double getKaiserTransitionWidth(int Length, double dB)
+	{
+		return (dB - 7.95) / (14.36 * std::max(1, Length - 1));
+	}
+
+	// estimateEquirippleLength() : (odd) length of an equiripple lowpass filter for the given ripples and (normalised) transition width (Kaiser's formula)
+	inline int estimateEquirippleLength(double passbandRipple, double stopbandPeak, double transitionWidth)
+	{
+		double n = (-20.0 * std::log10(std::sqrt(passbandRipple * stopbandPeak)) - 13.0) / (14.6 * transitionWidth) + 1.0;
+		return std::max(3, static_cast<int>(std::ceil(n)) | 1);
+	}
+
+	// makeEquirippleLPF() : generates (odd-length, linear-phase) lowpass filter coefficients with the Parks-McClellan (Remez exchange) algorithm.
+	// passbandEdge and stopbandEdge are frequencies in Hz; passbandWeight is the weight of the passband error relative to the stopband error
+	// (ie the stopband ripple divided by the passband ripple). The gain at DC is (close to) unity, as for makeLPF().
+	// Returns false if Length is even or too long, or if the algorithm fails to converge (in which case filter is left unchanged).
+	template<typename FloatType> bool makeEquirippleLPF(FloatType* filter, int Length, double passbandEdge, double stopbandEdge, double sampleRate, double passbandWeight = 1.0)
+	{
+		if (!(Length & 1) || Length < 3 || Length > EQUIRIPPLE_MAX_TAPS)
+			return false;
+
+		const double fp = passbandEdge / sampleRate;
+		const double fs = stopbandEdge / sampleRate;
+		if (!(fp > 0.0 && fp < fs && fs < 0.5))
+			return false;
+
+		const int r = (Length + 1) / 2; // number of cosine terms (the response is a polynomial of degree r - 1 in cos(w))
+
+		// dense grid over the passband [0, fp] and stopband [fs, 0.5] (including the band edges):
+		std::vector<double> gridF;
+		std::vector<double> gridD; // desired response
+		std::vector<double> gridW; // weight
+		const double spacing = 0.5 / (EQUIRIPPLE_GRID_DENSITY * r);
+		const auto passPoints = static_cast<int>(std::ceil(fp / spacing)) + 1;
+		const auto stopPoints = static_cast<int>(std::ceil((0.5 - fs) / spacing)) + 1;
+		for (int i = 0; i < passPoints; ++i) {
+			gridF.push_back(fp * i / (passPoints - 1));
+			gridD.push_back(1.0);
+			gridW.push_back(passbandWeight);
+		}
+		for (int i = 0; i < stopPoints; ++i) {
+			gridF.push_back(fs + (0.5 - fs) * i / (stopPoints - 1));
+			gridD.push_back(0.0);
+			gridW.push_back(1.0);
+		}
+		const auto gridSize = static_cast<int>(gridF.size());
+		if (gridSize < 2 * (r + 1))
+			return false;
+
+		std::vector<double> gridX(gridSize);
+		for (int i = 0; i < gridSize; ++i) {
+			gridX[i] = std::cos(2.0 * M_PI * gridF[i]);
+		}
+
+		std::vector<double> E(gridSize); // weighted error
+
+		// selectExtrema() : the largest error in each run of errors of the same sign (within each band) which is at least threshold,
+		// with alternating signs (of adjacent extrema with the same sign, the larger is kept), reduced to at most r + 1 by removing the smallest
+		auto selectExtrema = [&](double threshold) -> std::vector<int> {
+			std::vector<int> candidates;
+			auto findExtrema = [&](int first, int last) {
+				int best = first;
+				for (int i = first + 1; i <= last + 1; ++i) {
+					if (i > last || (E[i] > 0.0) != (E[best] > 0.0)) { // (end of run)
+						if (std::abs(E[best]) >= threshold)
+							candidates.push_back(best);
+						best = i;
+					}
+					else if (std::abs(E[i]) > std::abs(E[best])) {
+						best = i;
+					}
+				}
+			};
+			findExtrema(0, passPoints - 1);
+			findExtrema(passPoints, gridSize - 1);
+
+			auto enforceAlternation = [&]() {
+				std::vector<int> alternating;
+				for (int i : candidates) {
+					if (!alternating.empty() && (E[i] > 0.0) == (E[alternating.back()] > 0.0)) {
+						if (std::abs(E[i]) > std::abs(E[alternating.back()]))
+							alternating.back() = i;
+					}
+					else {
+						alternating.push_back(i);
+					}
+				}
+				candidates.swap(alternating);
+			};
+			enforceAlternation();
+
+			while (static_cast<int>(candidates.size()) > r + 1) {
+				if (static_cast<int>(candidates.size()) == r + 2) { // (removing one from the middle would break the alternation)
+					if (std::abs(E[candidates.front()]) <= std::abs(E[candidates.back()]))
+						candidates.erase(candidates.begin());
+					else
+						candidates.pop_back();
+				}
+				else {
+					auto smallest = std::min_element(candidates.begin(), candidates.end(), [&E](int a, int b) {
+						return std::abs(E[a]) < std::abs(E[b]);
+					});
+					candidates.erase(smallest);
+					enforceAlternation();
+				}
+			}
+			return candidates;
+		};
+
+		// fillGaps() : when there are too few extremal frequencies (usually only one or two short), adds more by splitting the largest gaps
+		auto fillGaps = [&](std::vector<int>& extrema) {
+			while (static_cast<int>(extrema.size()) < r + 1) {
+				std::vector<int> bounds(extrema);
+				bounds.insert(bounds.begin(), -1);
+				bounds.push_back(gridSize);
+				size_t widest = 0;
+				for (size_t k = 1; k < bounds.size() - 1; ++k) {
+					widest = (bounds[k + 1] - bounds[k] > bounds[widest + 1] - bounds[widest]) ? k : widest;
+				}
+				extrema.insert(extrema.begin() + widest, (bounds[widest] + bounds[widest + 1] + 1) / 2); // (gridSize > r + 1, so there is room)
+			}
+		};
+
+		// initial extremal frequencies: the extrema of the error of a Kaiser-windowed sinc of the same length and transition band
+		// (evenly-spaced extremal frequencies would give a deviation far too small to be resolved in double precision)
+		std::vector<int> ext;
+		{
+			std::vector<double> h(Length);
+			makeLPF<double>(h.data(), Length, 0.5 * (fp + fs), 1.0);
+			applyKaiserWindow<double>(h.data(), Length, calcKaiserBeta(14.36 * (Length - 1) * (fs - fp) + 7.95));
+			const int halfLength = Length / 2;
+			for (int i = 0; i < gridSize; ++i) {
+				double w = 2.0 * M_PI * gridF[i];
+				double response = h[halfLength];
+				for (int k = 1; k <= halfLength; ++k) {
+					response += 2.0 * h[halfLength - k] * std::cos(w * k);
+				}
+				E[i] = gridW[i] * (gridD[i] - response);
+			}
+			ext = selectExtrema(0.0);
+			fillGaps(ext);
+		}
+
+		std::vector<double> x(r + 1); // extremal frequencies (as cos(w))
+		std::vector<double> c(r + 1); // response at the extremal frequencies
+		std::vector<double> ad(r + 1); // barycentric weights for interpolating through them
+
+		// A() : the response (at cos(w) == xx), interpolated through the extremal frequencies.
+		// (The values c are consistent with a polynomial of degree r - 1. Interpolating through all r + 1 points, rather than only r of them,
+		// avoids extrapolating beyond the outermost point, which is numerically unstable at high orders)
+		auto A = [&](double xx) -> double {
+			double num = 0.0;
+			double den = 0.0;
+			for (int k = 0; k <= r; ++k) {
+				double d = xx - x[k];
+				if (d == 0.0)
+					return c[k];
+				double t = ad[k] / d;
+				num += t * c[k];
+				den += t;
+			}
+			return num / den;
+		};
+
+		bool converged = false;
+		for (int iteration = 0; iteration < EQUIRIPPLE_MAX_ITERATIONS && !converged; ++iteration) {
+			for (int k = 0; k <= r; ++k) {
+				x[k] = gridX[ext[k]];
+			}
+
+			// barycentric weights of all r + 1 points (scaled by a common factor, which cancels out, to avoid overflow):
+			std::vector<double> logAd(r + 1, 0.0);
+			std::vector<double> signAd(r + 1, 1.0);
+			double maxLog = -std::numeric_limits<double>::infinity();
+			for (int k = 0; k <= r; ++k) {
+				for (int j = 0; j <= r; ++j) {
+					if (j != k) {
+						double d = x[k] - x[j];
+						logAd[k] -= std::log(std::abs(d));
+						signAd[k] = (d < 0.0) ? -signAd[k] : signAd[k];
+					}
+				}
+				maxLog = std::max(maxLog, logAd[k]);
+			}
+			for (int k = 0; k <= r; ++k) {
+				ad[k] = signAd[k] * std::exp(logAd[k] - maxLog);
+			}
+
+			// deviation (delta) for which the weighted error alternates in sign with equal magnitude at the extremal frequencies:
+			double num = 0.0;
+			double den = 0.0;
+			for (int k = 0; k <= r; ++k) {
+				num += ad[k] * gridD[ext[k]];
+				den += ad[k] * ((k & 1) ? -1.0 : 1.0) / gridW[ext[k]];
+			}
+			const double delta = num / den;
+
+			for (int k = 0; k <= r; ++k) {
+				c[k] = gridD[ext[k]] - ((k & 1) ? -1.0 : 1.0) * delta / gridW[ext[k]];
+			}
+
+			// weighted error over the grid:
+			double maxError = 0.0;
+			for (int i = 0; i < gridSize; ++i) {
+				E[i] = gridW[i] * (gridD[i] - A(gridX[i]));
+				maxError = std::max(maxError, std::abs(E[i]));
+			}
+
+			// new extremal frequencies:
+			std::vector<int> candidates = selectExtrema(0.99 * std::abs(delta));
+			fillGaps(candidates); // (only needed if the alternation has been lost, through rounding errors)
+
+			converged = (maxError - std::abs(delta)) <= 1.0e-3 * maxError || candidates == ext;
+			ext = candidates;
+		}
+
+		if (!converged)
+			return false;
+
+		// impulse response, by frequency sampling of the (interpolated) response at w = 2 * pi * k / Length:
+		std::vector<double> Ak(r);
+		for (int k = 0; k < r; ++k) {
+			Ak[k] = A(std::cos(2.0 * M_PI * k / Length));
+		}
+		const int halfLength = Length / 2;
+		for (int n = 0; n <= halfLength; ++n) {
+			double sum = Ak[0];
+			for (int k = 1; k < r; ++k) {
+				sum += 2.0 * Ak[k] * std::cos(2.0 * M_PI * k * (n - halfLength) / Length);
+			}
+			filter[Length - n - 1] = filter[n] = static_cast<FloatType>(sum / Length); // exploit symmetry
+		}
+
+		return true;
+	}
+
+} // namespace ReSampler
+
+#endif // RESAMPLER_EQUIRIPPLE_H
@@ -190,10 +190,181 @@ inline std::vector<Fraction> getBestConversionStagesCandidate(Fraction f, int ma
 	return *solutions.rbegin(); // last is best
 }
 
-// getConversionStages() : get converter stages from hardcoded presets,
-// failing that, find converter configuration algorithmically.
+// StagePlan : a configuration of converter stages, with its estimated cost (see planConversionStages())
+struct StagePlan {
+	std::vector<Fraction> stages;
+	double cost;
+};
+
+// StageCostFunction : returns the estimated cost of the last of the given stages (which are applied in order, starting at the input rate),
+// or a negative value if that stage isn't viable. shapingStage is the index of the stage which must meet the full filter specification
+// (normally the final stage; stages.size() if it is yet to come).
+typedef std::function<double(const std::vector<Fraction>& stages, int shapingStage)> StageCostFunction;
+
+// getDivisors() - returns the divisors of n, in ascending order
+
+inline std::vector<int> getDivisors(int n) {
+	std::vector<int> divisors;
+	for (int d = 1; d * d <= n; d++) {
+		if (n % d == 0) {
+			divisors.push_back(d);
+			if (d * d != n) {
+				divisors.push_back(n / d);
+			}
+		}
+	}
+	std::sort(divisors.begin(), divisors.end());
+	return divisors;
+}
+
+// planConversionStages() : finds the numPlans cheapest configurations of (at most) maxStages converter stages for f,
+// according to stageCost, and returns them (cheapest first).
+// Every way of sharing the numerator and the denominator between the stages is considered, in every order.
+// The search is depth-first, adding one stage at a time: as the cost of a stage depends only on the stages before it (and whether it is the final stage),
+// any partial configuration which already costs more than the numPlans-th cheapest complete configuration is abandoned, along with all of its continuations.
+// As with getConversionStageCandidates(), the conversion ratio may not fall below that of f (or 1, if that is less) before the final stage.
+
+inline std::vector<StagePlan> planConversionStages(Fraction f, int maxStages, const StageCostFunction& stageCost, size_t numPlans = 1) {
+	std::vector<StagePlan> plans; // return value (cheapest first)
+	const double minRatio = std::min(1.0, static_cast<double>(f.numerator) / f.denominator);
+	const std::vector<int> numeratorDivisors = getDivisors(f.numerator);
+	const std::vector<int> denominatorDivisors = getDivisors(f.denominator);
+	std::vector<Fraction> stages;
+
+	auto bound = [&plans, numPlans]() {
+		return (plans.size() < numPlans) ? HUGE_VAL : plans.back().cost;
+	};
+
+	auto addPlan = [&plans, numPlans](const std::vector<Fraction>& stages, double cost) {
+		auto it = std::find_if(plans.begin(), plans.end(), [cost](const StagePlan& plan) { return cost < plan.cost; });
+		plans.insert(it, StagePlan{stages, cost});
+		if (plans.size() > numPlans) {
+			plans.pop_back();
+		}
+	};
+
+	// search() : completes the configuration, from the stages so far (which cost costSoFar), where the remaining stages must convert by numerator / denominator
+	std::function<void(int, int, double, double)> search = [&](int numerator, int denominator, double ratio, double costSoFar) {
+
+		// finish with the remainder as the final stage:
+		stages.push_back(Fraction{numerator, denominator});
+		double cost = stageCost(stages, static_cast<int>(stages.size()) - 1);
+		if (cost >= 0.0 && costSoFar + cost < bound()) {
+			addPlan(stages, costSoFar + cost);
+		}
+		stages.pop_back();
 
-inline std::vector<Fraction> getConversionStages(Fraction f, int maxStages) {
+		if (static_cast<int>(stages.size()) + 1 >= maxStages) {
+			return;
+		}
+
+		// or add an intermediate stage (leaving a remainder other than 1/1 for the stages after it):
+		for (int n : numeratorDivisors) {
+			if (numerator % n != 0) {
+				continue;
+			}
+			for (int d : denominatorDivisors) {
+				if (denominator % d != 0 || (n == 1 && d == 1) || (n == numerator && d == denominator)) {
+					continue;
+				}
+				double stageRatio = ratio * n / d;
+				if (stageRatio < minRatio) {
+					continue;
+				}
+				stages.push_back(Fraction{n, d});
+				cost = stageCost(stages, static_cast<int>(stages.size()));
+				if (cost >= 0.0 && costSoFar + cost < bound()) {
+					search(numerator / n, denominator / d, stageRatio, costSoFar + cost);
+				}
+				stages.pop_back();
+			}
+		}
+	};
+
+	search(f.numerator, f.denominator, 1.0, 0.0);
+	return plans;
+}
+
+// getHalfBandConversionStages() : for an integer conversion ratio (L / 1 or 1 / M) with a factor of 2^k,
+// return a configuration in which the factors of 2 are split off into 2/1 (or 1/2) stages, in the order which
+// allows them to use half-band filters (see HalfBandFilter.h): when decimating, the 1/2 stages come first,
+// and when interpolating, the 2/1 stages come last. The remaining stage (at the lowest sample rates) must meet
+// the full filter specification, which a half-band filter cannot; so a lone factor of 2 is left in it.
+// Returns an empty result if there is no such configuration.
+
+inline std::vector<Fraction> getHalfBandConversionStages(Fraction f, int maxStages) {
+	std::vector<Fraction> fractions; // return value
+	if (maxStages <= 1 || (f.numerator != 1 && f.denominator != 1)) {
+		return fractions;
+	}
+
+	const bool decimating = (f.numerator == 1);
+	int remainder = decimating ? f.denominator : f.numerator;
+	int powerOf2 = 0;
+	while (remainder % 2 == 0) {
+		remainder /= 2;
+		powerOf2++;
+	}
+
+	int numHalfBandStages = std::min(maxStages - 1, (remainder == 1) ? powerOf2 - 1 : powerOf2);
+	if (numHalfBandStages < 1) {
+		return fractions;
+	}
+
+	int remainingFactor = (decimating ? f.denominator : f.numerator) >> numHalfBandStages;
+	fractions.assign(numHalfBandStages, decimating ? Fraction{1, 2} : Fraction{2, 1});
+	if (decimating) {
+		fractions.push_back(Fraction{1, remainingFactor});
+	}
+	else {
+		fractions.insert(fractions.begin(), Fraction{remainingFactor, 1});
+	}
+	return fractions;
+}
+
+// getShapingStage() : the index of the stage which must meet the full filter specification: normally the last stage, but when interpolating
+// by an integer ratio with 2/1 stages after the first (see getHalfBandConversionStages()), and halfBandStages is true, the first stage,
+// so that the later stages are free to use half-band filters.
+
+inline int getShapingStage(const std::vector<Fraction>& stages, bool halfBandStages) {
+	const int lastStage = static_cast<int>(stages.size()) - 1;
+	if (!halfBandStages || lastStage < 1) {
+		return lastStage;
+	}
+	long long numerator = 1;
+	long long denominator = 1;
+	for (const Fraction& stage : stages) {
+		numerator *= stage.numerator;
+		denominator *= stage.denominator;
+	}
+	const bool interpolating = (numerator % denominator == 0);
+	const bool halfBandTail = std::all_of(stages.begin() + 1, stages.end(), [](const Fraction& f) { return f.numerator == 2 && f.denominator == 1; });
+	return (interpolating && halfBandTail) ? 0 : lastStage;
+}
+
+// getStagePlanCost() : the estimated cost of the given stages according to stageCost (the sum of the costs of the stages),
+// or a negative value if a stage isn't viable
+
+inline double getStagePlanCost(const std::vector<Fraction>& stages, int shapingStage, const StageCostFunction& stageCost) {
+	double cost = 0.0;
+	for (size_t i = 0; i < stages.size(); i++) {
+		std::vector<Fraction> prefix(stages.begin(), stages.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+		double stageCostValue = stageCost(prefix, shapingStage);
+		if (stageCostValue < 0.0) {
+			return -1.0;
+		}
+		cost += stageCostValue;
+	}
+	return cost;
+}
+
+// getConversionStages() : get the cheapest converter configuration according to stageCost (see planConversionStages()), if supplied.
+// Otherwise, get converter stages from hardcoded presets, failing that, find converter configuration algorithmically.
+// If halfBandStages is true, integer ratios with factors of 2 also have the half-band configuration (see getHalfBandConversionStages()):
+// with stageCost, it is priced (with its actual shaping stage, see getShapingStage()) as one more candidate, and used if it is the cheapest;
+// without stageCost, it is used unconditionally.
+
+inline std::vector<Fraction> getConversionStages(Fraction f, int maxStages, bool halfBandStages = false, const StageCostFunction& stageCost = nullptr) {
 
 	// apply single-stage policies:
 	if (maxStages <= 1) {
@@ -208,6 +379,28 @@ inline std::vector<Fraction> getConversionStages(Fraction f, int maxStages) {
 		return std::vector<Fraction> {f}; // single-stage conversion
 	}
 
+	std::vector<Fraction> halfBandFractions;
+	if (halfBandStages) {
+		halfBandFractions = getHalfBandConversionStages(f, maxStages);
+	}
+
+	if (stageCost) {
+		auto plans = planConversionStages(f, maxStages, stageCost);
+		if (!halfBandFractions.empty()) {
+			double halfBandCost = getStagePlanCost(halfBandFractions, getShapingStage(halfBandFractions, true), stageCost);
+			if (halfBandCost >= 0.0 && (plans.empty() || halfBandCost <= plans.front().cost)) {
+				return halfBandFractions;
+			}
+		}
+		if (!plans.empty()) {
+			return plans.front().stages;
+		}
+	}
+
+	if (!halfBandFractions.empty()) {
+		return halfBandFractions;
+	}
+
 	struct PresetFractionSet {
 		Fraction master;
 		std::vector<Fraction> components;
@@ -0,0 +1,128 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// ratioschedule.h : defines a schedule of conversion-ratio factors over time, for variable-ratio (eg drift-corrected) conversions
+
+#ifndef RESAMPLER_RATIOSCHEDULE_H
+#define RESAMPLER_RATIOSCHEDULE_H 1
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define RATIOSCHEDULE_MIN_FACTOR 0.5
+#define RATIOSCHEDULE_MAX_FACTOR 2.0
+
+namespace ReSampler {
+
+// class RatioSchedule : a piecewise-linear function of time (in seconds of input), giving the factor by which the nominal
+// conversion ratio (output rate / input rate) is multiplied. Before the first point and after the last, the factor is constant.
+// A control file has one point per line: <time in seconds> <factor>  (blank lines, and lines starting with #, are ignored)
+// eg a recorder whose clock runs 50 ppm fast (ie recorded at 48002.4 Hz when "48000") is corrected with a factor of 1 / 1.00005
+
+class RatioSchedule {
+public:
+	RatioSchedule() = default;
+
+	explicit RatioSchedule(std::vector<std::pair<double, double>> points) : points(std::move(points)) {
+		std::sort(this->points.begin(), this->points.end());
+	}
+
+	// load() : reads a control file. Returns false (with a description of the problem in errorMessage) if the file is unusable.
+	bool load(const std::string& filename, std::string& errorMessage) {
+		std::ifstream f(filename);
+		if (!f) {
+			errorMessage = "couldn't open ratio schedule file " + filename;
+			return false;
+		}
+
+		std::vector<std::pair<double, double>> newPoints;
+		std::string line;
+		for (int lineNumber = 1; std::getline(f, line); lineNumber++) {
+			auto first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#') {
+				continue;
+			}
+			std::replace(line.begin(), line.end(), ',', ' ');
+			std::istringstream ss(line);
+			double t, factor;
+			if (!(ss >> t >> factor)) {
+				errorMessage = "bad line in ratio schedule file (line " + std::to_string(lineNumber) + ")";
+				return false;
+			}
+			if (factor < RATIOSCHEDULE_MIN_FACTOR || factor > RATIOSCHEDULE_MAX_FACTOR) {
+				errorMessage = "ratio factor out of range in ratio schedule file (line " + std::to_string(lineNumber) + ")";
+				return false;
+			}
+			newPoints.emplace_back(t, factor);
+		}
+
+		if (newPoints.empty()) {
+			errorMessage = "no points in ratio schedule file " + filename;
+			return false;
+		}
+
+		std::sort(newPoints.begin(), newPoints.end());
+		points = newPoints;
+		return true;
+	}
+
+	bool isEmpty() const {
+		return points.empty();
+	}
+
+	size_t getNumPoints() const {
+		return points.size();
+	}
+
+	// getFactor() : factor at time t (in seconds of input)
+	double getFactor(double t) const {
+		if (points.empty()) {
+			return 1.0;
+		}
+		auto next = std::upper_bound(points.begin(), points.end(), t, [](double t, const std::pair<double, double>& p) {
+			return t < p.first;
+		});
+		if (next == points.begin()) {
+			return next->second;
+		}
+		if (next == points.end()) {
+			return points.back().second;
+		}
+		auto prev = std::prev(next);
+		return prev->second + (next->second - prev->second) * (t - prev->first) / (next->first - prev->first);
+	}
+
+	double getMinFactor() const {
+		double m = 1.0;
+		for (size_t i = 0; i < points.size(); i++) {
+			m = (i == 0) ? points[i].second : std::min(m, points[i].second);
+		}
+		return m;
+	}
+
+	double getMaxFactor() const {
+		double m = 1.0;
+		for (size_t i = 0; i < points.size(); i++) {
+			m = (i == 0) ? points[i].second : std::max(m, points[i].second);
+		}
+		return m;
+	}
+
+private:
+	std::vector<std::pair<double, double>> points; // (time, factor), in order of time
+};
+
+} // namespace ReSampler
+
+#endif // RESAMPLER_RATIOSCHEDULE_H
@@ -0,0 +1,2045 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+#ifndef SIMD_H
+#define SIMD_H 1
+
+// simd.h : run-time detection of the CPU's SIMD capabilities, and the dot-product kernels (for each SIMD level)
+// which are used by FIRFilter. All kernels are compiled into the one binary; the one used is chosen at run time.
+
+// usage:
+// getSimdLevel() returns the SIMD level which will be used by filters (defaults to the best level the CPU supports)
+// setSimdLevel() overrides this (eg for testing), provided the CPU supports the requested level
+// setWideAccumulation() makes single-precision filters accumulate in double precision (see the wide-accumulation kernels)
+
+#include <string>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// SIMD_TARGET: allow the compiler to use the given instruction set within a function
+// (msvc allows intrinsics anywhere, and doesn't need this)
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+namespace ReSampler {
+
+enum SimdLevel {
+	SimdScalar,
+	SimdSSE2,
+	SimdAVX,
+	SimdAVX2,	// AVX2 + FMA
+	SimdAVX512	// AVX-512F (with FMA)
+};
+
+// detectSimdLevel() : returns the highest SIMD level supported by both the CPU and the OS
+inline SimdLevel detectSimdLevel() {
+#if defined(SIMD_X86)
+#if defined(_MSC_VER)
+	int cpuInfo[4] = { 0, 0, 0, 0 };
+	__cpuid(cpuInfo, 0);
+	int maxLeaf = cpuInfo[0];
+	if (maxLeaf < 1) {
+		return SimdScalar;
+	}
+
+	__cpuid(cpuInfo, 1);
+	bool sse2 = (cpuInfo[3] & (1 << 26)) != 0;
+	bool fma = (cpuInfo[2] & (1 << 12)) != 0;
+	bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+	bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+
+	// check that the OS saves the ymm (and zmm) registers
+	unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	bool ymmEnabled = (xcr0 & 0x06) == 0x06;
+	bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+	bool avx2 = false;
+	bool avx512f = false;
+	if (maxLeaf >= 7) {
+		__cpuidex(cpuInfo, 7, 0);
+		avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+		avx512f = (cpuInfo[1] & (1 << 16)) != 0;
+	}
+
+	avx = avx && ymmEnabled;
+	avx2 = avx2 && avx;
+	avx512f = avx512f && avx && zmmEnabled;
+
+#else
+	// (gcc / clang builtins also check that the OS has enabled the relevant registers)
+	__builtin_cpu_init();
+	bool sse2 = __builtin_cpu_supports("sse2");
+	bool fma = __builtin_cpu_supports("fma");
+	bool avx = __builtin_cpu_supports("avx");
+	bool avx2 = __builtin_cpu_supports("avx2");
+	bool avx512f = __builtin_cpu_supports("avx512f");
+#endif
+
+	if (avx512f && fma) {
+		return SimdAVX512;
+	}
+	if (avx2 && fma) {
+		return SimdAVX2;
+	}
+	if (avx) {
+		return SimdAVX;
+	}
+	if (sse2) {
+		return SimdSSE2;
+	}
+#endif // defined(SIMD_X86)
+	return SimdScalar;
+}
+
+// selectedSimdLevel() : the SIMD level in use (for filters constructed from now on)
+inline SimdLevel& selectedSimdLevel() {
+	static SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+inline SimdLevel getSimdLevel() {
+	return selectedSimdLevel();
+}
+
+// setSimdLevel() : returns false (and leaves level unchanged) if the CPU doesn't support the requested level
+inline bool setSimdLevel(SimdLevel level) {
+	if (level > detectSimdLevel()) {
+		return false;
+	}
+	selectedSimdLevel() = level;
+	return true;
+}
+
+// selectedWideAccumulation() : whether single-precision filters (constructed from now on) use the wide-accumulation kernels
+inline bool& selectedWideAccumulation() {
+	static bool wide = false;
+	return wide;
+}
+
+inline bool getWideAccumulation() {
+	return selectedWideAccumulation();
+}
+
+inline void setWideAccumulation(bool wide) {
+	selectedWideAccumulation() = wide;
+}
+
+inline std::string simdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdSSE2:
+		return "sse2";
+	case SimdAVX:
+		return "avx";
+	case SimdAVX2:
+		return "avx2";
+	case SimdAVX512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+// simdLevelFromName() : returns false if name isn't recognised
+inline bool simdLevelFromName(const std::string& name, SimdLevel& level) {
+	for (SimdLevel l : {SimdScalar, SimdSSE2, SimdAVX, SimdAVX2, SimdAVX512}) {
+		if (name == simdLevelName(l)) {
+			level = l;
+			return true;
+		}
+	}
+	return false;
+}
+
+// simdVectorSize() : size (in bytes) of the vector registers used at the given SIMD level
+inline int simdVectorSize(SimdLevel level) {
+	switch (level) {
+	case SimdSSE2:
+		return 16;
+	case SimdAVX:
+	case SimdAVX2:
+		return 32;
+	case SimdAVX512:
+		return 64;
+	default:
+		return 0;
+	}
+}
+
+// Dot-product kernels: return the sum of signal[i] * kernel[i] for i = 0 ... length - 1.
+// For the SIMD versions, signal and kernel must be aligned to the vector size, and length must be a multiple of the number of elements per vector.
+
+template<typename FloatType>
+using DotProductFunction = FloatType (*)(const FloatType* signal, const FloatType* kernel, int length);
+
+template<typename FloatType>
+inline FloatType dotProductScalar(const FloatType* signal, const FloatType* kernel, int length) {
+	FloatType output = 0.0;
+	for (int i = 0; i < length; ++i) {
+		output += signal[i] * kernel[i];
+	}
+	return output;
+}
+
+// Unaligned dot-product kernels: same as the dot-product kernels above (and with the same signature),
+// except that the signal need not be aligned. (Used with a single, aligned copy of the kernel - see FIRFilter)
+
+template<typename FloatType>
+inline FloatType dotProductUnalignedScalar(const FloatType* signal, const FloatType* kernel, int length) {
+	return dotProductScalar(signal, kernel, length);
+}
+
+// Multi-output dot-product kernels: out[j] = the sum of signals[j][i] * kernel[i] for i = 0 ... length - 1, for j = 0 ... 3.
+// Each load of the kernel is shared by the four outputs, which have independent accumulators (and are reduced together at the end).
+// For the SIMD versions, kernel must be aligned to the vector size, and length must be a multiple of the number of elements per vector;
+// the signals need not be aligned.
+
+template<typename FloatType>
+using DotProduct4Function = void (*)(const FloatType* kernel, const FloatType* const* signals, int length, FloatType* out);
+
+template<typename FloatType>
+inline void dotProduct4Scalar(const FloatType* kernel, const FloatType* const* signals, int length, FloatType* out) {
+	const FloatType* s0 = signals[0];
+	const FloatType* s1 = signals[1];
+	const FloatType* s2 = signals[2];
+	const FloatType* s3 = signals[3];
+	FloatType a0 = 0.0;
+	FloatType a1 = 0.0;
+	FloatType a2 = 0.0;
+	FloatType a3 = 0.0;
+	for (int i = 0; i < length; ++i) {
+		FloatType k = kernel[i];
+		a0 += s0[i] * k;
+		a1 += s1[i] * k;
+		a2 += s2[i] * k;
+		a3 += s3[i] * k;
+	}
+	out[0] = a0;
+	out[1] = a1;
+	out[2] = a2;
+	out[3] = a3;
+}
+
+// Symmetric dot-product kernels: for a kernel of the given length which is symmetric (ie kernel[i] == kernel[length - 1 - i]),
+// return the sum of (signal[i] + signal[length - 1 - i]) * halfKernel[i] for i = 0 ... halfLength - 1,
+// where halfKernel is the first half of the kernel (with the centre tap halved when length is odd, as it is paired with itself),
+// padded with zeros to halfLength. This takes half the multiplies (and half the kernel memory) of an ordinary dot product.
+// For the SIMD versions, halfKernel must be aligned to the vector size, and halfLength must be a multiple of the number of
+// elements per vector, and must not exceed length; the signal need not be aligned.
+// (The mirrored half of the signal is read with a reversed load, ending at signal[length - 1 - i].)
+
+template<typename FloatType>
+using DotProductSymmetricFunction = FloatType (*)(const FloatType* signal, const FloatType* halfKernel, int halfLength, int length);
+
+template<typename FloatType>
+inline FloatType dotProductSymmetricScalar(const FloatType* signal, const FloatType* halfKernel, int halfLength, int length) {
+	FloatType output = 0.0;
+	const FloatType* mirror = signal + length - 1;
+	for (int i = 0; i < halfLength; ++i) {
+		output += (signal[i] + mirror[-i]) * halfKernel[i];
+	}
+	return output;
+}
+
+// Multi-output symmetric dot-product kernels: as above, for four signals at once (see also DotProduct4Function)
+
+template<typename FloatType>
+using DotProductSymmetric4Function = void (*)(const FloatType* halfKernel, const FloatType* const* signals, int halfLength, int length, FloatType* out);
+
+template<typename FloatType>
+inline void dotProductSymmetric4Scalar(const FloatType* halfKernel, const FloatType* const* signals, int halfLength, int length, FloatType* out) {
+	for (int j = 0; j < 4; j++) {
+		out[j] = dotProductSymmetricScalar(signals[j], halfKernel, halfLength, length);
+	}
+}
+
+// Channel-lane kernels: for interleaved frames (each of stride elements), for c = 0 ... stride - 1,
+// out[c] = the sum of kernel[i] * frames[i * stride + c] for i = 0 ... length - 1.
+// ie each channel occupies its own lane of the vectors, and each tap is broadcast and multiplied by a whole frame at a time.
+// For the SIMD versions, frames must be aligned to the vector size, and stride must be a multiple of the number of elements per vector.
+
+template<typename FloatType>
+using ChannelLaneFunction = void (*)(const FloatType* frames, const FloatType* kernel, int length, int stride, FloatType* out);
+
+template<typename FloatType>
+inline void channelLanesScalar(const FloatType* frames, const FloatType* kernel, int length, int stride, FloatType* out) {
+	for (int c = 0; c < stride; c++) {
+		FloatType output = 0.0;
+		const FloatType* p = frames + c;
+		for (int i = 0; i < length; ++i) {
+			output += kernel[i] * p[i * stride];
+		}
+		out[c] = output;
+	}
+}
+
+// Symmetric output-lane kernels: for j = 0 ... count - 1,
+// out[j] = the sum of halfKernel[i] * (signal[j + i] + signal[j + length - 1 - i]) for i = 0 ... halfLength - 1.
+// ie a symmetric filter (of length taps) evaluated at count consecutive positions, with consecutive outputs in the lanes of the vectors,
+// and each tap broadcast. (Used by HalfBandFilter, whose sub-filters are applied to every input sample of a block.)
+// The signal need not be aligned.
+
+template<typename FloatType>
+using SymmetricLaneFunction = void (*)(const FloatType* signal, const FloatType* halfKernel, int halfLength, int length, int count, FloatType* out);
+
+template<typename FloatType>
+inline void symmetricLanesScalar(const FloatType* signal, const FloatType* halfKernel, int halfLength, int length, int count, FloatType* out) {
+	for (int j = 0; j < count; j++) {
+		FloatType output = 0.0;
+		const FloatType* p = signal + j;
+		for (int i = 0; i < halfLength; ++i) {
+			output += halfKernel[i] * (p[i] + p[length - 1 - i]);
+		}
+		out[j] = output;
+	}
+}
+
+// Wide-accumulation kernels (single precision only): as the dot-product kernels above, with the same signatures,
+// except that the samples and taps are widened to double precision, and the products are summed in double precision;
+// only the result is rounded to single precision. (The product of two floats is exact in double precision.)
+// This keeps the storage (and memory traffic) of single precision, without the rounding error of a long single-precision sum,
+// which grows with the length of the filter. The signal need not be aligned, so the same kernel serves as the unaligned kernel.
+
+inline float dotProductWideScalar(const float* signal, const float* kernel, int length) {
+	double output = 0.0;
+	for (int i = 0; i < length; ++i) {
+		output += static_cast<double>(signal[i]) * kernel[i];
+	}
+	return static_cast<float>(output);
+}
+
+inline void dotProduct4WideScalar(const float* kernel, const float* const* signals, int length, float* out) {
+	for (int j = 0; j < 4; j++) {
+		out[j] = dotProductWideScalar(signals[j], kernel, length);
+	}
+}
+
+inline float dotProductSymmetricWideScalar(const float* signal, const float* halfKernel, int halfLength, int length) {
+	double output = 0.0;
+	const float* mirror = signal + length - 1;
+	for (int i = 0; i < halfLength; ++i) {
+		output += (static_cast<double>(signal[i]) + mirror[-i]) * halfKernel[i];
+	}
+	return static_cast<float>(output);
+}
+
+inline void dotProductSymmetric4WideScalar(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	for (int j = 0; j < 4; j++) {
+		out[j] = dotProductSymmetricWideScalar(signals[j], halfKernel, halfLength, length);
+	}
+}
+
+#if defined(SIMD_X86)
+
+// Horizontal add function (sums 4 floats into single float)
+SIMD_TARGET("sse2")
+inline float sum4floats(__m128 accumulator) {
+	// http://stackoverflow.com/questions/6996764/fastest-way-to-do-horizontal-float-vector-sum-on-x86
+	__m128 a = _mm_shuffle_ps(
+		accumulator,
+		accumulator,                 // accumulator = [D     C     | B     A    ]
+		_MM_SHUFFLE(2, 3, 0, 1));                  // [C     D     | A     B    ]
+	__m128 b = _mm_add_ps(accumulator, a);         // [D+C   C+D   | B+A   A+B  ]
+	a = _mm_movehl_ps(a, b);                       // [C     D     | D+C   C+D  ]
+	b = _mm_add_ss(a, b);                          // [C     D     | D+C A+B+C+D]
+	return _mm_cvtss_f32(b);                       // A+B+C+D
+}
+
+SIMD_TARGET("sse2")
+inline float dotProductSSE2(const float* signal, const float* kernel, int length) {
+	__m128 accumulator = _mm_setzero_ps();
+	for (int i = 0; i < length; i += 4) {
+		__m128 s = _mm_load_ps(signal + i);
+		__m128 k = _mm_load_ps(kernel + i);
+		accumulator = _mm_add_ps(_mm_mul_ps(s, k), accumulator);
+	}
+	return sum4floats(accumulator);
+}
+
+SIMD_TARGET("sse2")
+inline double dotProductSSE2(const double* signal, const double* kernel, int length) {
+	__m128d accumulator = _mm_setzero_pd();
+	for (int i = 0; i < length; i += 2) {
+		__m128d s = _mm_load_pd(signal + i);
+		__m128d k = _mm_load_pd(kernel + i);
+		accumulator = _mm_add_pd(_mm_mul_pd(s, k), accumulator);
+	}
+
+	// horizontal add of two doubles
+	__m128d shuf = _mm_unpackhi_pd(accumulator, accumulator);
+	return _mm_cvtsd_f64(_mm_add_sd(accumulator, shuf));
+}
+
+// Horizontal add function (sums 8 floats into single float) http://stackoverflow.com/questions/23189488/horizontal-sum-of-32-bit-floats-in-256-bit-avx-vector
+SIMD_TARGET("avx")
+inline float sum8floats(__m256 x) {
+	const __m128 x128 = _mm_add_ps(
+		_mm256_extractf128_ps(x, 1),
+		_mm256_castps256_ps128(x));																// ( x3+x7, x2+x6, x1+x5, x0+x4 )
+	const __m128 x64 = _mm_add_ps(x128, _mm_movehl_ps(x128, x128));								// ( -, -, x1+x3+x5+x7, x0+x2+x4+x6 )
+	const __m128 x32 = _mm_add_ss(x64, _mm_shuffle_ps(x64, x64, 0x55));							// ( -, -, -, x0+x1+x2+x3+x4+x5+x6+x7 )
+	return _mm_cvtss_f32(x32);
+}
+
+// Horizontal add function (sums 4 doubles into single double)
+SIMD_TARGET("avx")
+inline double sum4doubles(__m256d x) {
+	const __m128d x128 = _mm_add_pd(
+		_mm256_extractf128_pd(x, 1),
+		_mm256_castpd256_pd128(x));
+	const __m128d x64 = _mm_add_pd(_mm_permute_pd(x128, 1), x128);
+	return _mm_cvtsd_f64(x64);
+}
+
+// Horizontal add function (sums 16 floats into single float), by adding the two halves and reusing sum8floats()
+// (avoids _mm512_reduce_add_ps(), whose implementation in some versions of GCC produces spurious uninitialized-variable warnings.
+// For the same reason, the halves are extracted with the zero-masking form, with every element selected, which compiles to the plain instruction
+// (in GCC, the 512-to-256-bit casts are themselves extractions)
+SIMD_TARGET("avx512f")
+inline float sum16floats(__m512 x) {
+	const __m512d xd = _mm512_castps_pd(x);
+	const __m256 low = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, xd, 0));
+	const __m256 high = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xf, xd, 1));
+	return sum8floats(_mm256_add_ps(low, high));
+}
+
+// Horizontal add function (sums 8 doubles into single double), by adding the two halves and reusing sum4doubles()
+SIMD_TARGET("avx512f")
+inline double sum8doubles(__m512d x) {
+	return sum4doubles(_mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xf, x, 0), _mm512_maskz_extractf64x4_pd(0xf, x, 1)));
+}
+
+SIMD_TARGET("avx")
+inline float dotProductAVX(const float* signal, const float* kernel, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 s = _mm256_load_ps(signal + i);
+		__m256 k = _mm256_load_ps(kernel + i);
+		accumulator = _mm256_add_ps(_mm256_mul_ps(s, k), accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx")
+inline double dotProductAVX(const double* signal, const double* kernel, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d s = _mm256_load_pd(signal + i);
+		__m256d k = _mm256_load_pd(kernel + i);
+		accumulator = _mm256_add_pd(_mm256_mul_pd(s, k), accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline float dotProductAVX2(const float* signal, const float* kernel, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 s = _mm256_load_ps(signal + i);
+		__m256 k = _mm256_load_ps(kernel + i);
+		accumulator = _mm256_fmadd_ps(s, k, accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline double dotProductAVX2(const double* signal, const double* kernel, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d s = _mm256_load_pd(signal + i);
+		__m256d k = _mm256_load_pd(kernel + i);
+		accumulator = _mm256_fmadd_pd(s, k, accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline float dotProductAVX512(const float* signal, const float* kernel, int length) {
+	__m512 accumulator = _mm512_setzero_ps();
+	for (int i = 0; i < length; i += 16) {
+		__m512 s = _mm512_load_ps(signal + i);
+		__m512 k = _mm512_load_ps(kernel + i);
+		accumulator = _mm512_fmadd_ps(s, k, accumulator);
+	}
+	return sum16floats(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline double dotProductAVX512(const double* signal, const double* kernel, int length) {
+	__m512d accumulator = _mm512_setzero_pd();
+	for (int i = 0; i < length; i += 8) {
+		__m512d s = _mm512_load_pd(signal + i);
+		__m512d k = _mm512_load_pd(kernel + i);
+		accumulator = _mm512_fmadd_pd(s, k, accumulator);
+	}
+	return sum8doubles(accumulator);
+}
+
+SIMD_TARGET("sse2")
+inline float dotProductUnalignedSSE2(const float* signal, const float* kernel, int length) {
+	__m128 accumulator = _mm_setzero_ps();
+	for (int i = 0; i < length; i += 4) {
+		__m128 s = _mm_loadu_ps(signal + i);
+		__m128 k = _mm_load_ps(kernel + i);
+		accumulator = _mm_add_ps(_mm_mul_ps(s, k), accumulator);
+	}
+	return sum4floats(accumulator);
+}
+
+SIMD_TARGET("sse2")
+inline double dotProductUnalignedSSE2(const double* signal, const double* kernel, int length) {
+	__m128d accumulator = _mm_setzero_pd();
+	for (int i = 0; i < length; i += 2) {
+		__m128d s = _mm_loadu_pd(signal + i);
+		__m128d k = _mm_load_pd(kernel + i);
+		accumulator = _mm_add_pd(_mm_mul_pd(s, k), accumulator);
+	}
+
+	// horizontal add of two doubles
+	__m128d shuf = _mm_unpackhi_pd(accumulator, accumulator);
+	return _mm_cvtsd_f64(_mm_add_sd(accumulator, shuf));
+}
+
+SIMD_TARGET("avx")
+inline float dotProductUnalignedAVX(const float* signal, const float* kernel, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 s = _mm256_loadu_ps(signal + i);
+		__m256 k = _mm256_load_ps(kernel + i);
+		accumulator = _mm256_add_ps(_mm256_mul_ps(s, k), accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx")
+inline double dotProductUnalignedAVX(const double* signal, const double* kernel, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d s = _mm256_loadu_pd(signal + i);
+		__m256d k = _mm256_load_pd(kernel + i);
+		accumulator = _mm256_add_pd(_mm256_mul_pd(s, k), accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline float dotProductUnalignedAVX2(const float* signal, const float* kernel, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 s = _mm256_loadu_ps(signal + i);
+		__m256 k = _mm256_load_ps(kernel + i);
+		accumulator = _mm256_fmadd_ps(s, k, accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline double dotProductUnalignedAVX2(const double* signal, const double* kernel, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d s = _mm256_loadu_pd(signal + i);
+		__m256d k = _mm256_load_pd(kernel + i);
+		accumulator = _mm256_fmadd_pd(s, k, accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline float dotProductUnalignedAVX512(const float* signal, const float* kernel, int length) {
+	__m512 accumulator = _mm512_setzero_ps();
+	for (int i = 0; i < length; i += 16) {
+		__m512 s = _mm512_loadu_ps(signal + i);
+		__m512 k = _mm512_load_ps(kernel + i);
+		accumulator = _mm512_fmadd_ps(s, k, accumulator);
+	}
+	return sum16floats(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline double dotProductUnalignedAVX512(const double* signal, const double* kernel, int length) {
+	__m512d accumulator = _mm512_setzero_pd();
+	for (int i = 0; i < length; i += 8) {
+		__m512d s = _mm512_loadu_pd(signal + i);
+		__m512d k = _mm512_load_pd(kernel + i);
+		accumulator = _mm512_fmadd_pd(s, k, accumulator);
+	}
+	return sum8doubles(accumulator);
+}
+
+SIMD_TARGET("sse2")
+inline void dotProduct4SSE2(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	__m128 a2 = _mm_setzero_ps();
+	__m128 a3 = _mm_setzero_ps();
+	for (int i = 0; i < length; i += 4) {
+		__m128 k = _mm_load_ps(kernel + i);
+		a0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s0 + i), k), a0);
+		a1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s1 + i), k), a1);
+		a2 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s2 + i), k), a2);
+		a3 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s3 + i), k), a3);
+	}
+
+	// transpose, then add: (each element of the result is the sum of one accumulator)
+	_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+	_mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+}
+
+SIMD_TARGET("sse2")
+inline void dotProduct4SSE2(const double* kernel, const double* const* signals, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	__m128d a2 = _mm_setzero_pd();
+	__m128d a3 = _mm_setzero_pd();
+	for (int i = 0; i < length; i += 2) {
+		__m128d k = _mm_load_pd(kernel + i);
+		a0 = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(s0 + i), k), a0);
+		a1 = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(s1 + i), k), a1);
+		a2 = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(s2 + i), k), a2);
+		a3 = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(s3 + i), k), a3);
+	}
+	_mm_storeu_pd(out, _mm_add_pd(_mm_unpacklo_pd(a0, a1), _mm_unpackhi_pd(a0, a1)));
+	_mm_storeu_pd(out + 2, _mm_add_pd(_mm_unpacklo_pd(a2, a3), _mm_unpackhi_pd(a2, a3)));
+}
+
+// sum4x8floats() : horizontal sums of four vectors of 8 floats
+SIMD_TARGET("avx")
+inline void sum4x8floats(__m256 a0, __m256 a1, __m256 a2, __m256 a3, float* out) {
+	__m256 h = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));	// ( a3[4..7], a2[4..7], a1[4..7], a0[4..7] | a3[0..3], a2[0..3], a1[0..3], a0[0..3] )
+	_mm_storeu_ps(out, _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1)));
+}
+
+// sum4x4doubles() : horizontal sums of four vectors of 4 doubles
+SIMD_TARGET("avx")
+inline void sum4x4doubles(__m256d a0, __m256d a1, __m256d a2, __m256d a3, double* out) {
+	__m256d h01 = _mm256_hadd_pd(a0, a1);	// ( a1[2..3], a0[2..3] | a1[0..1], a0[0..1] )
+	__m256d h23 = _mm256_hadd_pd(a2, a3);
+	_mm256_storeu_pd(out, _mm256_add_pd(_mm256_permute2f128_pd(h01, h23, 0x20), _mm256_permute2f128_pd(h01, h23, 0x31)));
+}
+
+SIMD_TARGET("avx")
+inline void dotProduct4AVX(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	__m256 a2 = _mm256_setzero_ps();
+	__m256 a3 = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 k = _mm256_load_ps(kernel + i);
+		a0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s0 + i), k), a0);
+		a1 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s1 + i), k), a1);
+		a2 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s2 + i), k), a2);
+		a3 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s3 + i), k), a3);
+	}
+	sum4x8floats(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx")
+inline void dotProduct4AVX(const double* kernel, const double* const* signals, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d k = _mm256_load_pd(kernel + i);
+		a0 = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(s0 + i), k), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(s1 + i), k), a1);
+		a2 = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(s2 + i), k), a2);
+		a3 = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(s3 + i), k), a3);
+	}
+	sum4x4doubles(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void dotProduct4AVX2(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	__m256 a2 = _mm256_setzero_ps();
+	__m256 a3 = _mm256_setzero_ps();
+	for (int i = 0; i < length; i += 8) {
+		__m256 k = _mm256_load_ps(kernel + i);
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(s0 + i), k, a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(s1 + i), k, a1);
+		a2 = _mm256_fmadd_ps(_mm256_loadu_ps(s2 + i), k, a2);
+		a3 = _mm256_fmadd_ps(_mm256_loadu_ps(s3 + i), k, a3);
+	}
+	sum4x8floats(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void dotProduct4AVX2(const double* kernel, const double* const* signals, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d k = _mm256_load_pd(kernel + i);
+		a0 = _mm256_fmadd_pd(_mm256_loadu_pd(s0 + i), k, a0);
+		a1 = _mm256_fmadd_pd(_mm256_loadu_pd(s1 + i), k, a1);
+		a2 = _mm256_fmadd_pd(_mm256_loadu_pd(s2 + i), k, a2);
+		a3 = _mm256_fmadd_pd(_mm256_loadu_pd(s3 + i), k, a3);
+	}
+	sum4x4doubles(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProduct4AVX512(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m512 a0 = _mm512_setzero_ps();
+	__m512 a1 = _mm512_setzero_ps();
+	__m512 a2 = _mm512_setzero_ps();
+	__m512 a3 = _mm512_setzero_ps();
+	for (int i = 0; i < length; i += 16) {
+		__m512 k = _mm512_load_ps(kernel + i);
+		a0 = _mm512_fmadd_ps(_mm512_loadu_ps(s0 + i), k, a0);
+		a1 = _mm512_fmadd_ps(_mm512_loadu_ps(s1 + i), k, a1);
+		a2 = _mm512_fmadd_ps(_mm512_loadu_ps(s2 + i), k, a2);
+		a3 = _mm512_fmadd_ps(_mm512_loadu_ps(s3 + i), k, a3);
+	}
+	out[0] = sum16floats(a0);
+	out[1] = sum16floats(a1);
+	out[2] = sum16floats(a2);
+	out[3] = sum16floats(a3);
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProduct4AVX512(const double* kernel, const double* const* signals, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	__m512d a2 = _mm512_setzero_pd();
+	__m512d a3 = _mm512_setzero_pd();
+	for (int i = 0; i < length; i += 8) {
+		__m512d k = _mm512_load_pd(kernel + i);
+		a0 = _mm512_fmadd_pd(_mm512_loadu_pd(s0 + i), k, a0);
+		a1 = _mm512_fmadd_pd(_mm512_loadu_pd(s1 + i), k, a1);
+		a2 = _mm512_fmadd_pd(_mm512_loadu_pd(s2 + i), k, a2);
+		a3 = _mm512_fmadd_pd(_mm512_loadu_pd(s3 + i), k, a3);
+	}
+	out[0] = sum8doubles(a0);
+	out[1] = sum8doubles(a1);
+	out[2] = sum8doubles(a2);
+	out[3] = sum8doubles(a3);
+}
+
+// foldSSE2() : signal[i ... i + 3] + (signal[length - 1 - i] ... signal[length - 4 - i]), where mirror = signal + length - 4 - i
+SIMD_TARGET("sse2")
+inline __m128 foldSSE2(const float* signal, const float* mirror) {
+	__m128 m = _mm_loadu_ps(mirror);
+	return _mm_add_ps(_mm_loadu_ps(signal), _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 1, 2, 3)));
+}
+
+SIMD_TARGET("sse2")
+inline __m128d foldSSE2(const double* signal, const double* mirror) {
+	__m128d m = _mm_loadu_pd(mirror);
+	return _mm_add_pd(_mm_loadu_pd(signal), _mm_shuffle_pd(m, m, 1));
+}
+
+SIMD_TARGET("sse2")
+inline float dotProductSymmetricSSE2(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m128 accumulator = _mm_setzero_ps();
+	const float* mirror = signal + length - 4;
+	for (int i = 0; i < halfLength; i += 4) {
+		accumulator = _mm_add_ps(_mm_mul_ps(foldSSE2(signal + i, mirror - i), _mm_load_ps(halfKernel + i)), accumulator);
+	}
+	return sum4floats(accumulator);
+}
+
+SIMD_TARGET("sse2")
+inline void dotProductSymmetric4SSE2(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 4; // offset of the mirrored load
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	__m128 a2 = _mm_setzero_ps();
+	__m128 a3 = _mm_setzero_ps();
+	for (int i = 0; i < halfLength; i += 4) {
+		__m128 k = _mm_load_ps(halfKernel + i);
+		a0 = _mm_add_ps(_mm_mul_ps(foldSSE2(s0 + i, s0 + m - i), k), a0);
+		a1 = _mm_add_ps(_mm_mul_ps(foldSSE2(s1 + i, s1 + m - i), k), a1);
+		a2 = _mm_add_ps(_mm_mul_ps(foldSSE2(s2 + i, s2 + m - i), k), a2);
+		a3 = _mm_add_ps(_mm_mul_ps(foldSSE2(s3 + i, s3 + m - i), k), a3);
+	}
+	_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+	_mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+}
+
+SIMD_TARGET("sse2")
+inline double dotProductSymmetricSSE2(const double* signal, const double* halfKernel, int halfLength, int length) {
+	__m128d accumulator = _mm_setzero_pd();
+	const double* mirror = signal + length - 2;
+	for (int i = 0; i < halfLength; i += 2) {
+		accumulator = _mm_add_pd(_mm_mul_pd(foldSSE2(signal + i, mirror - i), _mm_load_pd(halfKernel + i)), accumulator);
+	}
+	return _mm_cvtsd_f64(_mm_add_sd(accumulator, _mm_unpackhi_pd(accumulator, accumulator)));
+}
+
+SIMD_TARGET("sse2")
+inline void dotProductSymmetric4SSE2(const double* halfKernel, const double* const* signals, int halfLength, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	const int m = length - 2; // offset of the mirrored load
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	__m128d a2 = _mm_setzero_pd();
+	__m128d a3 = _mm_setzero_pd();
+	for (int i = 0; i < halfLength; i += 2) {
+		__m128d k = _mm_load_pd(halfKernel + i);
+		a0 = _mm_add_pd(_mm_mul_pd(foldSSE2(s0 + i, s0 + m - i), k), a0);
+		a1 = _mm_add_pd(_mm_mul_pd(foldSSE2(s1 + i, s1 + m - i), k), a1);
+		a2 = _mm_add_pd(_mm_mul_pd(foldSSE2(s2 + i, s2 + m - i), k), a2);
+		a3 = _mm_add_pd(_mm_mul_pd(foldSSE2(s3 + i, s3 + m - i), k), a3);
+	}
+	_mm_storeu_pd(out, _mm_add_pd(_mm_unpacklo_pd(a0, a1), _mm_unpackhi_pd(a0, a1)));
+	_mm_storeu_pd(out + 2, _mm_add_pd(_mm_unpacklo_pd(a2, a3), _mm_unpackhi_pd(a2, a3)));
+}
+
+// foldAVX() : as foldSSE2(), for 256-bit vectors (also used by the AVX2 kernels)
+SIMD_TARGET("avx")
+inline __m256 foldAVX(const float* signal, const float* mirror) {
+	__m256 m = _mm256_loadu_ps(mirror);
+	m = _mm256_permute2f128_ps(m, m, 1); // swap halves
+	return _mm256_add_ps(_mm256_loadu_ps(signal), _mm256_permute_ps(m, _MM_SHUFFLE(0, 1, 2, 3)));
+}
+
+SIMD_TARGET("avx")
+inline __m256d foldAVX(const double* signal, const double* mirror) {
+	__m256d m = _mm256_loadu_pd(mirror);
+	m = _mm256_permute2f128_pd(m, m, 1); // swap halves
+	return _mm256_add_pd(_mm256_loadu_pd(signal), _mm256_permute_pd(m, 5));
+}
+
+SIMD_TARGET("avx")
+inline float dotProductSymmetricAVX(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	const float* mirror = signal + length - 8;
+	for (int i = 0; i < halfLength; i += 8) {
+		accumulator = _mm256_add_ps(_mm256_mul_ps(foldAVX(signal + i, mirror - i), _mm256_load_ps(halfKernel + i)), accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx")
+inline void dotProductSymmetric4AVX(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 8; // offset of the mirrored load
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	__m256 a2 = _mm256_setzero_ps();
+	__m256 a3 = _mm256_setzero_ps();
+	for (int i = 0; i < halfLength; i += 8) {
+		__m256 k = _mm256_load_ps(halfKernel + i);
+		a0 = _mm256_add_ps(_mm256_mul_ps(foldAVX(s0 + i, s0 + m - i), k), a0);
+		a1 = _mm256_add_ps(_mm256_mul_ps(foldAVX(s1 + i, s1 + m - i), k), a1);
+		a2 = _mm256_add_ps(_mm256_mul_ps(foldAVX(s2 + i, s2 + m - i), k), a2);
+		a3 = _mm256_add_ps(_mm256_mul_ps(foldAVX(s3 + i, s3 + m - i), k), a3);
+	}
+	sum4x8floats(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx")
+inline double dotProductSymmetricAVX(const double* signal, const double* halfKernel, int halfLength, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	const double* mirror = signal + length - 4;
+	for (int i = 0; i < halfLength; i += 4) {
+		accumulator = _mm256_add_pd(_mm256_mul_pd(foldAVX(signal + i, mirror - i), _mm256_load_pd(halfKernel + i)), accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx")
+inline void dotProductSymmetric4AVX(const double* halfKernel, const double* const* signals, int halfLength, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	const int m = length - 4; // offset of the mirrored load
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < halfLength; i += 4) {
+		__m256d k = _mm256_load_pd(halfKernel + i);
+		a0 = _mm256_add_pd(_mm256_mul_pd(foldAVX(s0 + i, s0 + m - i), k), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(foldAVX(s1 + i, s1 + m - i), k), a1);
+		a2 = _mm256_add_pd(_mm256_mul_pd(foldAVX(s2 + i, s2 + m - i), k), a2);
+		a3 = _mm256_add_pd(_mm256_mul_pd(foldAVX(s3 + i, s3 + m - i), k), a3);
+	}
+	sum4x4doubles(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx2,fma")
+inline float dotProductSymmetricAVX2(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m256 accumulator = _mm256_setzero_ps();
+	const float* mirror = signal + length - 8;
+	for (int i = 0; i < halfLength; i += 8) {
+		accumulator = _mm256_fmadd_ps(foldAVX(signal + i, mirror - i), _mm256_load_ps(halfKernel + i), accumulator);
+	}
+	return sum8floats(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void dotProductSymmetric4AVX2(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 8; // offset of the mirrored load
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	__m256 a2 = _mm256_setzero_ps();
+	__m256 a3 = _mm256_setzero_ps();
+	for (int i = 0; i < halfLength; i += 8) {
+		__m256 k = _mm256_load_ps(halfKernel + i);
+		a0 = _mm256_fmadd_ps(foldAVX(s0 + i, s0 + m - i), k, a0);
+		a1 = _mm256_fmadd_ps(foldAVX(s1 + i, s1 + m - i), k, a1);
+		a2 = _mm256_fmadd_ps(foldAVX(s2 + i, s2 + m - i), k, a2);
+		a3 = _mm256_fmadd_ps(foldAVX(s3 + i, s3 + m - i), k, a3);
+	}
+	sum4x8floats(a0, a1, a2, a3, out);
+}
+
+SIMD_TARGET("avx2,fma")
+inline double dotProductSymmetricAVX2(const double* signal, const double* halfKernel, int halfLength, int length) {
+	__m256d accumulator = _mm256_setzero_pd();
+	const double* mirror = signal + length - 4;
+	for (int i = 0; i < halfLength; i += 4) {
+		accumulator = _mm256_fmadd_pd(foldAVX(signal + i, mirror - i), _mm256_load_pd(halfKernel + i), accumulator);
+	}
+	return sum4doubles(accumulator);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void dotProductSymmetric4AVX2(const double* halfKernel, const double* const* signals, int halfLength, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	const int m = length - 4; // offset of the mirrored load
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < halfLength; i += 4) {
+		__m256d k = _mm256_load_pd(halfKernel + i);
+		a0 = _mm256_fmadd_pd(foldAVX(s0 + i, s0 + m - i), k, a0);
+		a1 = _mm256_fmadd_pd(foldAVX(s1 + i, s1 + m - i), k, a1);
+		a2 = _mm256_fmadd_pd(foldAVX(s2 + i, s2 + m - i), k, a2);
+		a3 = _mm256_fmadd_pd(foldAVX(s3 + i, s3 + m - i), k, a3);
+	}
+	sum4x4doubles(a0, a1, a2, a3, out);
+}
+
+// foldAVX512() : as foldSSE2(), for 512-bit vectors
+// (the zero-masking permutes, with every element selected, compile to the plain instruction, and avoid GCC's spurious uninitialized-variable warnings)
+SIMD_TARGET("avx512f")
+inline __m512 foldAVX512(const float* signal, const float* mirror) {
+	const __m512i reversed = _mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	return _mm512_add_ps(_mm512_loadu_ps(signal), _mm512_maskz_permutexvar_ps(0xffff, reversed, _mm512_loadu_ps(mirror)));
+}
+
+SIMD_TARGET("avx512f")
+inline __m512d foldAVX512(const double* signal, const double* mirror) {
+	const __m512i reversed = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	return _mm512_add_pd(_mm512_loadu_pd(signal), _mm512_maskz_permutexvar_pd(0xff, reversed, _mm512_loadu_pd(mirror)));
+}
+
+SIMD_TARGET("avx512f")
+inline float dotProductSymmetricAVX512(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m512 accumulator = _mm512_setzero_ps();
+	const float* mirror = signal + length - 16;
+	for (int i = 0; i < halfLength; i += 16) {
+		accumulator = _mm512_fmadd_ps(foldAVX512(signal + i, mirror - i), _mm512_load_ps(halfKernel + i), accumulator);
+	}
+	return sum16floats(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProductSymmetric4AVX512(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 16; // offset of the mirrored load
+	__m512 a0 = _mm512_setzero_ps();
+	__m512 a1 = _mm512_setzero_ps();
+	__m512 a2 = _mm512_setzero_ps();
+	__m512 a3 = _mm512_setzero_ps();
+	for (int i = 0; i < halfLength; i += 16) {
+		__m512 k = _mm512_load_ps(halfKernel + i);
+		a0 = _mm512_fmadd_ps(foldAVX512(s0 + i, s0 + m - i), k, a0);
+		a1 = _mm512_fmadd_ps(foldAVX512(s1 + i, s1 + m - i), k, a1);
+		a2 = _mm512_fmadd_ps(foldAVX512(s2 + i, s2 + m - i), k, a2);
+		a3 = _mm512_fmadd_ps(foldAVX512(s3 + i, s3 + m - i), k, a3);
+	}
+	out[0] = sum16floats(a0);
+	out[1] = sum16floats(a1);
+	out[2] = sum16floats(a2);
+	out[3] = sum16floats(a3);
+}
+
+SIMD_TARGET("avx512f")
+inline double dotProductSymmetricAVX512(const double* signal, const double* halfKernel, int halfLength, int length) {
+	__m512d accumulator = _mm512_setzero_pd();
+	const double* mirror = signal + length - 8;
+	for (int i = 0; i < halfLength; i += 8) {
+		accumulator = _mm512_fmadd_pd(foldAVX512(signal + i, mirror - i), _mm512_load_pd(halfKernel + i), accumulator);
+	}
+	return sum8doubles(accumulator);
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProductSymmetric4AVX512(const double* halfKernel, const double* const* signals, int halfLength, int length, double* out) {
+	const double* s0 = signals[0];
+	const double* s1 = signals[1];
+	const double* s2 = signals[2];
+	const double* s3 = signals[3];
+	const int m = length - 8; // offset of the mirrored load
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	__m512d a2 = _mm512_setzero_pd();
+	__m512d a3 = _mm512_setzero_pd();
+	for (int i = 0; i < halfLength; i += 8) {
+		__m512d k = _mm512_load_pd(halfKernel + i);
+		a0 = _mm512_fmadd_pd(foldAVX512(s0 + i, s0 + m - i), k, a0);
+		a1 = _mm512_fmadd_pd(foldAVX512(s1 + i, s1 + m - i), k, a1);
+		a2 = _mm512_fmadd_pd(foldAVX512(s2 + i, s2 + m - i), k, a2);
+		a3 = _mm512_fmadd_pd(foldAVX512(s3 + i, s3 + m - i), k, a3);
+	}
+	out[0] = sum8doubles(a0);
+	out[1] = sum8doubles(a1);
+	out[2] = sum8doubles(a2);
+	out[3] = sum8doubles(a3);
+}
+
+SIMD_TARGET("sse2")
+inline void channelLanesSSE2(const float* frames, const float* kernel, int length, int stride, float* out) {
+	for (int c = 0; c < stride; c += 4) {
+		const float* p = frames + c;
+		__m128 a0 = _mm_setzero_ps();
+		__m128 a1 = _mm_setzero_ps();
+		__m128 a2 = _mm_setzero_ps();
+		__m128 a3 = _mm_setzero_ps();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kernel[i]), _mm_load_ps(p)), a0);
+			a1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kernel[i + 1]), _mm_load_ps(p + stride)), a1);
+			a2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kernel[i + 2]), _mm_load_ps(p + 2 * stride)), a2);
+			a3 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kernel[i + 3]), _mm_load_ps(p + 3 * stride)), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kernel[i]), _mm_load_ps(p)), a0);
+			p += stride;
+		}
+		_mm_storeu_ps(out + c, _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+	}
+}
+
+SIMD_TARGET("sse2")
+inline void channelLanesSSE2(const double* frames, const double* kernel, int length, int stride, double* out) {
+	for (int c = 0; c < stride; c += 2) {
+		const double* p = frames + c;
+		__m128d a0 = _mm_setzero_pd();
+		__m128d a1 = _mm_setzero_pd();
+		__m128d a2 = _mm_setzero_pd();
+		__m128d a3 = _mm_setzero_pd();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kernel[i]), _mm_load_pd(p)), a0);
+			a1 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kernel[i + 1]), _mm_load_pd(p + stride)), a1);
+			a2 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kernel[i + 2]), _mm_load_pd(p + 2 * stride)), a2);
+			a3 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kernel[i + 3]), _mm_load_pd(p + 3 * stride)), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(kernel[i]), _mm_load_pd(p)), a0);
+			p += stride;
+		}
+		_mm_storeu_pd(out + c, _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx")
+inline void channelLanesAVX(const float* frames, const float* kernel, int length, int stride, float* out) {
+	for (int c = 0; c < stride; c += 8) {
+		const float* p = frames + c;
+		__m256 a0 = _mm256_setzero_ps();
+		__m256 a1 = _mm256_setzero_ps();
+		__m256 a2 = _mm256_setzero_ps();
+		__m256 a3 = _mm256_setzero_ps();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kernel[i]), _mm256_load_ps(p)), a0);
+			a1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kernel[i + 1]), _mm256_load_ps(p + stride)), a1);
+			a2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kernel[i + 2]), _mm256_load_ps(p + 2 * stride)), a2);
+			a3 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kernel[i + 3]), _mm256_load_ps(p + 3 * stride)), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kernel[i]), _mm256_load_ps(p)), a0);
+			p += stride;
+		}
+		_mm256_storeu_ps(out + c, _mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx")
+inline void channelLanesAVX(const double* frames, const double* kernel, int length, int stride, double* out) {
+	for (int c = 0; c < stride; c += 4) {
+		const double* p = frames + c;
+		__m256d a0 = _mm256_setzero_pd();
+		__m256d a1 = _mm256_setzero_pd();
+		__m256d a2 = _mm256_setzero_pd();
+		__m256d a3 = _mm256_setzero_pd();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kernel[i]), _mm256_load_pd(p)), a0);
+			a1 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kernel[i + 1]), _mm256_load_pd(p + stride)), a1);
+			a2 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kernel[i + 2]), _mm256_load_pd(p + 2 * stride)), a2);
+			a3 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kernel[i + 3]), _mm256_load_pd(p + 3 * stride)), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(kernel[i]), _mm256_load_pd(p)), a0);
+			p += stride;
+		}
+		_mm256_storeu_pd(out + c, _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx2,fma")
+inline void channelLanesAVX2(const float* frames, const float* kernel, int length, int stride, float* out) {
+	for (int c = 0; c < stride; c += 8) {
+		const float* p = frames + c;
+		__m256 a0 = _mm256_setzero_ps();
+		__m256 a1 = _mm256_setzero_ps();
+		__m256 a2 = _mm256_setzero_ps();
+		__m256 a3 = _mm256_setzero_ps();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i]), _mm256_load_ps(p), a0);
+			a1 = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i + 1]), _mm256_load_ps(p + stride), a1);
+			a2 = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i + 2]), _mm256_load_ps(p + 2 * stride), a2);
+			a3 = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i + 3]), _mm256_load_ps(p + 3 * stride), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm256_fmadd_ps(_mm256_set1_ps(kernel[i]), _mm256_load_ps(p), a0);
+			p += stride;
+		}
+		_mm256_storeu_ps(out + c, _mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx2,fma")
+inline void channelLanesAVX2(const double* frames, const double* kernel, int length, int stride, double* out) {
+	for (int c = 0; c < stride; c += 4) {
+		const double* p = frames + c;
+		__m256d a0 = _mm256_setzero_pd();
+		__m256d a1 = _mm256_setzero_pd();
+		__m256d a2 = _mm256_setzero_pd();
+		__m256d a3 = _mm256_setzero_pd();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm256_fmadd_pd(_mm256_set1_pd(kernel[i]), _mm256_load_pd(p), a0);
+			a1 = _mm256_fmadd_pd(_mm256_set1_pd(kernel[i + 1]), _mm256_load_pd(p + stride), a1);
+			a2 = _mm256_fmadd_pd(_mm256_set1_pd(kernel[i + 2]), _mm256_load_pd(p + 2 * stride), a2);
+			a3 = _mm256_fmadd_pd(_mm256_set1_pd(kernel[i + 3]), _mm256_load_pd(p + 3 * stride), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm256_fmadd_pd(_mm256_set1_pd(kernel[i]), _mm256_load_pd(p), a0);
+			p += stride;
+		}
+		_mm256_storeu_pd(out + c, _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx512f")
+inline void channelLanesAVX512(const float* frames, const float* kernel, int length, int stride, float* out) {
+	for (int c = 0; c < stride; c += 16) {
+		const float* p = frames + c;
+		__m512 a0 = _mm512_setzero_ps();
+		__m512 a1 = _mm512_setzero_ps();
+		__m512 a2 = _mm512_setzero_ps();
+		__m512 a3 = _mm512_setzero_ps();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i]), _mm512_load_ps(p), a0);
+			a1 = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i + 1]), _mm512_load_ps(p + stride), a1);
+			a2 = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i + 2]), _mm512_load_ps(p + 2 * stride), a2);
+			a3 = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i + 3]), _mm512_load_ps(p + 3 * stride), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm512_fmadd_ps(_mm512_set1_ps(kernel[i]), _mm512_load_ps(p), a0);
+			p += stride;
+		}
+		_mm512_storeu_ps(out + c, _mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)));
+	}
+}
+
+SIMD_TARGET("avx512f")
+inline void channelLanesAVX512(const double* frames, const double* kernel, int length, int stride, double* out) {
+	for (int c = 0; c < stride; c += 8) {
+		const double* p = frames + c;
+		__m512d a0 = _mm512_setzero_pd();
+		__m512d a1 = _mm512_setzero_pd();
+		__m512d a2 = _mm512_setzero_pd();
+		__m512d a3 = _mm512_setzero_pd();
+		int i = 0;
+		for (; i + 3 < length; i += 4) {
+			a0 = _mm512_fmadd_pd(_mm512_set1_pd(kernel[i]), _mm512_load_pd(p), a0);
+			a1 = _mm512_fmadd_pd(_mm512_set1_pd(kernel[i + 1]), _mm512_load_pd(p + stride), a1);
+			a2 = _mm512_fmadd_pd(_mm512_set1_pd(kernel[i + 2]), _mm512_load_pd(p + 2 * stride), a2);
+			a3 = _mm512_fmadd_pd(_mm512_set1_pd(kernel[i + 3]), _mm512_load_pd(p + 3 * stride), a3);
+			p += 4 * stride;
+		}
+		for (; i < length; ++i) {
+			a0 = _mm512_fmadd_pd(_mm512_set1_pd(kernel[i]), _mm512_load_pd(p), a0);
+			p += stride;
+		}
+		_mm512_storeu_pd(out + c, _mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3)));
+	}
+}
+
+SIMD_TARGET("sse2")
+inline void symmetricLanesSSE2(const float* signal, const float* halfKernel, int halfLength, int length, int count, float* out) {
+	int j = 0;
+	for (; j + 15 < count; j += 16) {
+		const float* q0 = signal + j;
+		const float* q1 = q0 + 4;
+		const float* q2 = q0 + 8;
+		const float* q3 = q0 + 12;
+		__m128 a0 = _mm_setzero_ps();
+		__m128 a1 = _mm_setzero_ps();
+		__m128 a2 = _mm_setzero_ps();
+		__m128 a3 = _mm_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m128 k = _mm_set1_ps(halfKernel[i]);
+			a0 = _mm_add_ps(_mm_mul_ps(k, _mm_add_ps(_mm_loadu_ps(q0 + i), _mm_loadu_ps(q0 + length - 1 - i))), a0);
+			a1 = _mm_add_ps(_mm_mul_ps(k, _mm_add_ps(_mm_loadu_ps(q1 + i), _mm_loadu_ps(q1 + length - 1 - i))), a1);
+			a2 = _mm_add_ps(_mm_mul_ps(k, _mm_add_ps(_mm_loadu_ps(q2 + i), _mm_loadu_ps(q2 + length - 1 - i))), a2);
+			a3 = _mm_add_ps(_mm_mul_ps(k, _mm_add_ps(_mm_loadu_ps(q3 + i), _mm_loadu_ps(q3 + length - 1 - i))), a3);
+		}
+		_mm_storeu_ps(out + j, a0);
+		_mm_storeu_ps(out + j + 4, a1);
+		_mm_storeu_ps(out + j + 8, a2);
+		_mm_storeu_ps(out + j + 12, a3);
+	}
+	for (; j + 3 < count; j += 4) {
+		const float* q0 = signal + j;
+		__m128 a0 = _mm_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(halfKernel[i]), _mm_add_ps(_mm_loadu_ps(q0 + i), _mm_loadu_ps(q0 + length - 1 - i))), a0);
+		}
+		_mm_storeu_ps(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("sse2")
+inline void symmetricLanesSSE2(const double* signal, const double* halfKernel, int halfLength, int length, int count, double* out) {
+	int j = 0;
+	for (; j + 7 < count; j += 8) {
+		const double* q0 = signal + j;
+		const double* q1 = q0 + 2;
+		const double* q2 = q0 + 4;
+		const double* q3 = q0 + 6;
+		__m128d a0 = _mm_setzero_pd();
+		__m128d a1 = _mm_setzero_pd();
+		__m128d a2 = _mm_setzero_pd();
+		__m128d a3 = _mm_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m128d k = _mm_set1_pd(halfKernel[i]);
+			a0 = _mm_add_pd(_mm_mul_pd(k, _mm_add_pd(_mm_loadu_pd(q0 + i), _mm_loadu_pd(q0 + length - 1 - i))), a0);
+			a1 = _mm_add_pd(_mm_mul_pd(k, _mm_add_pd(_mm_loadu_pd(q1 + i), _mm_loadu_pd(q1 + length - 1 - i))), a1);
+			a2 = _mm_add_pd(_mm_mul_pd(k, _mm_add_pd(_mm_loadu_pd(q2 + i), _mm_loadu_pd(q2 + length - 1 - i))), a2);
+			a3 = _mm_add_pd(_mm_mul_pd(k, _mm_add_pd(_mm_loadu_pd(q3 + i), _mm_loadu_pd(q3 + length - 1 - i))), a3);
+		}
+		_mm_storeu_pd(out + j, a0);
+		_mm_storeu_pd(out + j + 2, a1);
+		_mm_storeu_pd(out + j + 4, a2);
+		_mm_storeu_pd(out + j + 6, a3);
+	}
+	for (; j + 1 < count; j += 2) {
+		const double* q0 = signal + j;
+		__m128d a0 = _mm_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(halfKernel[i]), _mm_add_pd(_mm_loadu_pd(q0 + i), _mm_loadu_pd(q0 + length - 1 - i))), a0);
+		}
+		_mm_storeu_pd(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx")
+inline void symmetricLanesAVX(const float* signal, const float* halfKernel, int halfLength, int length, int count, float* out) {
+	int j = 0;
+	for (; j + 31 < count; j += 32) {
+		const float* q0 = signal + j;
+		const float* q1 = q0 + 8;
+		const float* q2 = q0 + 16;
+		const float* q3 = q0 + 24;
+		__m256 a0 = _mm256_setzero_ps();
+		__m256 a1 = _mm256_setzero_ps();
+		__m256 a2 = _mm256_setzero_ps();
+		__m256 a3 = _mm256_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m256 k = _mm256_set1_ps(halfKernel[i]);
+			a0 = _mm256_add_ps(_mm256_mul_ps(k, _mm256_add_ps(_mm256_loadu_ps(q0 + i), _mm256_loadu_ps(q0 + length - 1 - i))), a0);
+			a1 = _mm256_add_ps(_mm256_mul_ps(k, _mm256_add_ps(_mm256_loadu_ps(q1 + i), _mm256_loadu_ps(q1 + length - 1 - i))), a1);
+			a2 = _mm256_add_ps(_mm256_mul_ps(k, _mm256_add_ps(_mm256_loadu_ps(q2 + i), _mm256_loadu_ps(q2 + length - 1 - i))), a2);
+			a3 = _mm256_add_ps(_mm256_mul_ps(k, _mm256_add_ps(_mm256_loadu_ps(q3 + i), _mm256_loadu_ps(q3 + length - 1 - i))), a3);
+		}
+		_mm256_storeu_ps(out + j, a0);
+		_mm256_storeu_ps(out + j + 8, a1);
+		_mm256_storeu_ps(out + j + 16, a2);
+		_mm256_storeu_ps(out + j + 24, a3);
+	}
+	for (; j + 7 < count; j += 8) {
+		const float* q0 = signal + j;
+		__m256 a0 = _mm256_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(halfKernel[i]), _mm256_add_ps(_mm256_loadu_ps(q0 + i), _mm256_loadu_ps(q0 + length - 1 - i))), a0);
+		}
+		_mm256_storeu_ps(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx")
+inline void symmetricLanesAVX(const double* signal, const double* halfKernel, int halfLength, int length, int count, double* out) {
+	int j = 0;
+	for (; j + 15 < count; j += 16) {
+		const double* q0 = signal + j;
+		const double* q1 = q0 + 4;
+		const double* q2 = q0 + 8;
+		const double* q3 = q0 + 12;
+		__m256d a0 = _mm256_setzero_pd();
+		__m256d a1 = _mm256_setzero_pd();
+		__m256d a2 = _mm256_setzero_pd();
+		__m256d a3 = _mm256_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m256d k = _mm256_set1_pd(halfKernel[i]);
+			a0 = _mm256_add_pd(_mm256_mul_pd(k, _mm256_add_pd(_mm256_loadu_pd(q0 + i), _mm256_loadu_pd(q0 + length - 1 - i))), a0);
+			a1 = _mm256_add_pd(_mm256_mul_pd(k, _mm256_add_pd(_mm256_loadu_pd(q1 + i), _mm256_loadu_pd(q1 + length - 1 - i))), a1);
+			a2 = _mm256_add_pd(_mm256_mul_pd(k, _mm256_add_pd(_mm256_loadu_pd(q2 + i), _mm256_loadu_pd(q2 + length - 1 - i))), a2);
+			a3 = _mm256_add_pd(_mm256_mul_pd(k, _mm256_add_pd(_mm256_loadu_pd(q3 + i), _mm256_loadu_pd(q3 + length - 1 - i))), a3);
+		}
+		_mm256_storeu_pd(out + j, a0);
+		_mm256_storeu_pd(out + j + 4, a1);
+		_mm256_storeu_pd(out + j + 8, a2);
+		_mm256_storeu_pd(out + j + 12, a3);
+	}
+	for (; j + 3 < count; j += 4) {
+		const double* q0 = signal + j;
+		__m256d a0 = _mm256_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(halfKernel[i]), _mm256_add_pd(_mm256_loadu_pd(q0 + i), _mm256_loadu_pd(q0 + length - 1 - i))), a0);
+		}
+		_mm256_storeu_pd(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void symmetricLanesAVX2(const float* signal, const float* halfKernel, int halfLength, int length, int count, float* out) {
+	int j = 0;
+	for (; j + 31 < count; j += 32) {
+		const float* q0 = signal + j;
+		const float* q1 = q0 + 8;
+		const float* q2 = q0 + 16;
+		const float* q3 = q0 + 24;
+		__m256 a0 = _mm256_setzero_ps();
+		__m256 a1 = _mm256_setzero_ps();
+		__m256 a2 = _mm256_setzero_ps();
+		__m256 a3 = _mm256_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m256 k = _mm256_set1_ps(halfKernel[i]);
+			a0 = _mm256_fmadd_ps(k, _mm256_add_ps(_mm256_loadu_ps(q0 + i), _mm256_loadu_ps(q0 + length - 1 - i)), a0);
+			a1 = _mm256_fmadd_ps(k, _mm256_add_ps(_mm256_loadu_ps(q1 + i), _mm256_loadu_ps(q1 + length - 1 - i)), a1);
+			a2 = _mm256_fmadd_ps(k, _mm256_add_ps(_mm256_loadu_ps(q2 + i), _mm256_loadu_ps(q2 + length - 1 - i)), a2);
+			a3 = _mm256_fmadd_ps(k, _mm256_add_ps(_mm256_loadu_ps(q3 + i), _mm256_loadu_ps(q3 + length - 1 - i)), a3);
+		}
+		_mm256_storeu_ps(out + j, a0);
+		_mm256_storeu_ps(out + j + 8, a1);
+		_mm256_storeu_ps(out + j + 16, a2);
+		_mm256_storeu_ps(out + j + 24, a3);
+	}
+	for (; j + 7 < count; j += 8) {
+		const float* q0 = signal + j;
+		__m256 a0 = _mm256_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm256_fmadd_ps(_mm256_set1_ps(halfKernel[i]), _mm256_add_ps(_mm256_loadu_ps(q0 + i), _mm256_loadu_ps(q0 + length - 1 - i)), a0);
+		}
+		_mm256_storeu_ps(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx2,fma")
+inline void symmetricLanesAVX2(const double* signal, const double* halfKernel, int halfLength, int length, int count, double* out) {
+	int j = 0;
+	for (; j + 15 < count; j += 16) {
+		const double* q0 = signal + j;
+		const double* q1 = q0 + 4;
+		const double* q2 = q0 + 8;
+		const double* q3 = q0 + 12;
+		__m256d a0 = _mm256_setzero_pd();
+		__m256d a1 = _mm256_setzero_pd();
+		__m256d a2 = _mm256_setzero_pd();
+		__m256d a3 = _mm256_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m256d k = _mm256_set1_pd(halfKernel[i]);
+			a0 = _mm256_fmadd_pd(k, _mm256_add_pd(_mm256_loadu_pd(q0 + i), _mm256_loadu_pd(q0 + length - 1 - i)), a0);
+			a1 = _mm256_fmadd_pd(k, _mm256_add_pd(_mm256_loadu_pd(q1 + i), _mm256_loadu_pd(q1 + length - 1 - i)), a1);
+			a2 = _mm256_fmadd_pd(k, _mm256_add_pd(_mm256_loadu_pd(q2 + i), _mm256_loadu_pd(q2 + length - 1 - i)), a2);
+			a3 = _mm256_fmadd_pd(k, _mm256_add_pd(_mm256_loadu_pd(q3 + i), _mm256_loadu_pd(q3 + length - 1 - i)), a3);
+		}
+		_mm256_storeu_pd(out + j, a0);
+		_mm256_storeu_pd(out + j + 4, a1);
+		_mm256_storeu_pd(out + j + 8, a2);
+		_mm256_storeu_pd(out + j + 12, a3);
+	}
+	for (; j + 3 < count; j += 4) {
+		const double* q0 = signal + j;
+		__m256d a0 = _mm256_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm256_fmadd_pd(_mm256_set1_pd(halfKernel[i]), _mm256_add_pd(_mm256_loadu_pd(q0 + i), _mm256_loadu_pd(q0 + length - 1 - i)), a0);
+		}
+		_mm256_storeu_pd(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx512f")
+inline void symmetricLanesAVX512(const float* signal, const float* halfKernel, int halfLength, int length, int count, float* out) {
+	int j = 0;
+	for (; j + 63 < count; j += 64) {
+		const float* q0 = signal + j;
+		const float* q1 = q0 + 16;
+		const float* q2 = q0 + 32;
+		const float* q3 = q0 + 48;
+		__m512 a0 = _mm512_setzero_ps();
+		__m512 a1 = _mm512_setzero_ps();
+		__m512 a2 = _mm512_setzero_ps();
+		__m512 a3 = _mm512_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m512 k = _mm512_set1_ps(halfKernel[i]);
+			a0 = _mm512_fmadd_ps(k, _mm512_add_ps(_mm512_loadu_ps(q0 + i), _mm512_loadu_ps(q0 + length - 1 - i)), a0);
+			a1 = _mm512_fmadd_ps(k, _mm512_add_ps(_mm512_loadu_ps(q1 + i), _mm512_loadu_ps(q1 + length - 1 - i)), a1);
+			a2 = _mm512_fmadd_ps(k, _mm512_add_ps(_mm512_loadu_ps(q2 + i), _mm512_loadu_ps(q2 + length - 1 - i)), a2);
+			a3 = _mm512_fmadd_ps(k, _mm512_add_ps(_mm512_loadu_ps(q3 + i), _mm512_loadu_ps(q3 + length - 1 - i)), a3);
+		}
+		_mm512_storeu_ps(out + j, a0);
+		_mm512_storeu_ps(out + j + 16, a1);
+		_mm512_storeu_ps(out + j + 32, a2);
+		_mm512_storeu_ps(out + j + 48, a3);
+	}
+	for (; j + 15 < count; j += 16) {
+		const float* q0 = signal + j;
+		__m512 a0 = _mm512_setzero_ps();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm512_fmadd_ps(_mm512_set1_ps(halfKernel[i]), _mm512_add_ps(_mm512_loadu_ps(q0 + i), _mm512_loadu_ps(q0 + length - 1 - i)), a0);
+		}
+		_mm512_storeu_ps(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+SIMD_TARGET("avx512f")
+inline void symmetricLanesAVX512(const double* signal, const double* halfKernel, int halfLength, int length, int count, double* out) {
+	int j = 0;
+	for (; j + 31 < count; j += 32) {
+		const double* q0 = signal + j;
+		const double* q1 = q0 + 8;
+		const double* q2 = q0 + 16;
+		const double* q3 = q0 + 24;
+		__m512d a0 = _mm512_setzero_pd();
+		__m512d a1 = _mm512_setzero_pd();
+		__m512d a2 = _mm512_setzero_pd();
+		__m512d a3 = _mm512_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			const __m512d k = _mm512_set1_pd(halfKernel[i]);
+			a0 = _mm512_fmadd_pd(k, _mm512_add_pd(_mm512_loadu_pd(q0 + i), _mm512_loadu_pd(q0 + length - 1 - i)), a0);
+			a1 = _mm512_fmadd_pd(k, _mm512_add_pd(_mm512_loadu_pd(q1 + i), _mm512_loadu_pd(q1 + length - 1 - i)), a1);
+			a2 = _mm512_fmadd_pd(k, _mm512_add_pd(_mm512_loadu_pd(q2 + i), _mm512_loadu_pd(q2 + length - 1 - i)), a2);
+			a3 = _mm512_fmadd_pd(k, _mm512_add_pd(_mm512_loadu_pd(q3 + i), _mm512_loadu_pd(q3 + length - 1 - i)), a3);
+		}
+		_mm512_storeu_pd(out + j, a0);
+		_mm512_storeu_pd(out + j + 8, a1);
+		_mm512_storeu_pd(out + j + 16, a2);
+		_mm512_storeu_pd(out + j + 24, a3);
+	}
+	for (; j + 7 < count; j += 8) {
+		const double* q0 = signal + j;
+		__m512d a0 = _mm512_setzero_pd();
+		for (int i = 0; i < halfLength; ++i) {
+			a0 = _mm512_fmadd_pd(_mm512_set1_pd(halfKernel[i]), _mm512_add_pd(_mm512_loadu_pd(q0 + i), _mm512_loadu_pd(q0 + length - 1 - i)), a0);
+		}
+		_mm512_storeu_pd(out + j, a0);
+	}
+	symmetricLanesScalar(signal + j, halfKernel, halfLength, length, count - j, out + j);
+}
+
+// Wide-accumulation kernels (see dotProductWideScalar()).
+// The SSE2 kernels widen each vector of 4 floats into two vectors of 2 doubles; the AVX kernels load 4 floats at a time, as a vector of 4 doubles,
+// and the AVX-512 kernels 8 floats at a time. (At the AVX2 level, the AVX kernels are used: the products are exact, so fused multiply-adds would
+// give the same results, and the conversions, rather than the arithmetic, are the bottleneck)
+
+// widenLowSSE2() / widenHighSSE2() : the low / high two floats of x, as doubles
+SIMD_TARGET("sse2")
+inline __m128d widenLowSSE2(__m128 x) {
+	return _mm_cvtps_pd(x);
+}
+
+SIMD_TARGET("sse2")
+inline __m128d widenHighSSE2(__m128 x) {
+	return _mm_cvtps_pd(_mm_movehl_ps(x, x));
+}
+
+SIMD_TARGET("sse2")
+inline double sum2doubles(__m128d x) {
+	return _mm_cvtsd_f64(_mm_add_sd(x, _mm_unpackhi_pd(x, x)));
+}
+
+SIMD_TARGET("sse2")
+inline float dotProductWideSSE2(const float* signal, const float* kernel, int length) {
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m128 s = _mm_loadu_ps(signal + i);
+		__m128 k = _mm_load_ps(kernel + i);
+		a0 = _mm_add_pd(_mm_mul_pd(widenLowSSE2(s), widenLowSSE2(k)), a0);
+		a1 = _mm_add_pd(_mm_mul_pd(widenHighSSE2(s), widenHighSSE2(k)), a1);
+	}
+	return static_cast<float>(sum2doubles(_mm_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("sse2")
+inline void dotProduct4WideSSE2(const float* kernel, const float* const* signals, int length, float* out) {
+	__m128d a[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+	for (int i = 0; i < length; i += 4) {
+		__m128 k = _mm_load_ps(kernel + i);
+		const __m128d kLow = widenLowSSE2(k);
+		const __m128d kHigh = widenHighSSE2(k);
+		for (int j = 0; j < 4; j++) {
+			__m128 s = _mm_loadu_ps(signals[j] + i);
+			a[j] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(widenLowSSE2(s), kLow), _mm_mul_pd(widenHighSSE2(s), kHigh)), a[j]);
+		}
+	}
+	for (int j = 0; j < 4; j++) {
+		out[j] = static_cast<float>(sum2doubles(a[j]));
+	}
+}
+
+// foldWideSSE2() : as foldSSE2(), with the sums in double precision (low and high halves)
+SIMD_TARGET("sse2")
+inline void foldWideSSE2(const float* signal, const float* mirror, __m128d& low, __m128d& high) {
+	__m128 s = _mm_loadu_ps(signal);
+	__m128 m = _mm_loadu_ps(mirror);
+	m = _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 1, 2, 3));
+	low = _mm_add_pd(widenLowSSE2(s), widenLowSSE2(m));
+	high = _mm_add_pd(widenHighSSE2(s), widenHighSSE2(m));
+}
+
+SIMD_TARGET("sse2")
+inline float dotProductSymmetricWideSSE2(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m128d a0 = _mm_setzero_pd();
+	__m128d a1 = _mm_setzero_pd();
+	const float* mirror = signal + length - 4;
+	for (int i = 0; i < halfLength; i += 4) {
+		__m128d low, high;
+		foldWideSSE2(signal + i, mirror - i, low, high);
+		__m128 k = _mm_load_ps(halfKernel + i);
+		a0 = _mm_add_pd(_mm_mul_pd(low, widenLowSSE2(k)), a0);
+		a1 = _mm_add_pd(_mm_mul_pd(high, widenHighSSE2(k)), a1);
+	}
+	return static_cast<float>(sum2doubles(_mm_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("sse2")
+inline void dotProductSymmetric4WideSSE2(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const int m = length - 4; // offset of the mirrored load
+	__m128d a[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+	for (int i = 0; i < halfLength; i += 4) {
+		__m128 k = _mm_load_ps(halfKernel + i);
+		const __m128d kLow = widenLowSSE2(k);
+		const __m128d kHigh = widenHighSSE2(k);
+		for (int j = 0; j < 4; j++) {
+			__m128d low, high;
+			foldWideSSE2(signals[j] + i, signals[j] + m - i, low, high);
+			a[j] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(low, kLow), _mm_mul_pd(high, kHigh)), a[j]);
+		}
+	}
+	for (int j = 0; j < 4; j++) {
+		out[j] = static_cast<float>(sum2doubles(a[j]));
+	}
+}
+
+// loadWideAVX() : 4 floats (aligned or not), as doubles
+SIMD_TARGET("avx")
+inline __m256d loadWideAVX(const float* p) {
+	return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+// foldWideAVX() : signal[i ... i + 3] + (signal[length - 1 - i] ... signal[length - 4 - i]) in double precision, where mirror = signal + length - 4 - i
+SIMD_TARGET("avx")
+inline __m256d foldWideAVX(const float* signal, const float* mirror) {
+	__m128 m = _mm_loadu_ps(mirror);
+	return _mm256_add_pd(loadWideAVX(signal), _mm256_cvtps_pd(_mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 1, 2, 3))));
+}
+
+SIMD_TARGET("avx")
+inline float dotProductWideAVX(const float* signal, const float* kernel, int length) {
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 8) {
+		a0 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(signal + i), loadWideAVX(kernel + i)), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(signal + i + 4), loadWideAVX(kernel + i + 4)), a1);
+	}
+	return static_cast<float>(sum4doubles(_mm256_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("avx")
+inline void dotProduct4WideAVX(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < length; i += 4) {
+		__m256d k = loadWideAVX(kernel + i);
+		a0 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(s0 + i), k), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(s1 + i), k), a1);
+		a2 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(s2 + i), k), a2);
+		a3 = _mm256_add_pd(_mm256_mul_pd(loadWideAVX(s3 + i), k), a3);
+	}
+	out[0] = static_cast<float>(sum4doubles(a0));
+	out[1] = static_cast<float>(sum4doubles(a1));
+	out[2] = static_cast<float>(sum4doubles(a2));
+	out[3] = static_cast<float>(sum4doubles(a3));
+}
+
+SIMD_TARGET("avx")
+inline float dotProductSymmetricWideAVX(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	const float* mirror = signal + length - 4;
+	for (int i = 0; i < halfLength; i += 8) {
+		a0 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(signal + i, mirror - i), loadWideAVX(halfKernel + i)), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(signal + i + 4, mirror - i - 4), loadWideAVX(halfKernel + i + 4)), a1);
+	}
+	return static_cast<float>(sum4doubles(_mm256_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("avx")
+inline void dotProductSymmetric4WideAVX(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 4; // offset of the mirrored load
+	__m256d a0 = _mm256_setzero_pd();
+	__m256d a1 = _mm256_setzero_pd();
+	__m256d a2 = _mm256_setzero_pd();
+	__m256d a3 = _mm256_setzero_pd();
+	for (int i = 0; i < halfLength; i += 4) {
+		__m256d k = loadWideAVX(halfKernel + i);
+		a0 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(s0 + i, s0 + m - i), k), a0);
+		a1 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(s1 + i, s1 + m - i), k), a1);
+		a2 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(s2 + i, s2 + m - i), k), a2);
+		a3 = _mm256_add_pd(_mm256_mul_pd(foldWideAVX(s3 + i, s3 + m - i), k), a3);
+	}
+	out[0] = static_cast<float>(sum4doubles(a0));
+	out[1] = static_cast<float>(sum4doubles(a1));
+	out[2] = static_cast<float>(sum4doubles(a2));
+	out[3] = static_cast<float>(sum4doubles(a3));
+}
+
+// widenAVX512() : 8 floats, as doubles
+// (the zero-masking conversion, with every element selected, compiles to the plain instruction, and avoids GCC's spurious uninitialized-variable warnings)
+SIMD_TARGET("avx512f")
+inline __m512d widenAVX512(__m256 x) {
+	return _mm512_maskz_cvtps_pd(0xff, x);
+}
+
+// loadWideAVX512() : 8 floats (aligned or not), as doubles
+SIMD_TARGET("avx512f")
+inline __m512d loadWideAVX512(const float* p) {
+	return widenAVX512(_mm256_loadu_ps(p));
+}
+
+// foldWideAVX512() : signal[i ... i + 7] + (signal[length - 1 - i] ... signal[length - 8 - i]) in double precision, where mirror = signal + length - 8 - i
+SIMD_TARGET("avx512f")
+inline __m512d foldWideAVX512(const float* signal, const float* mirror) {
+	__m256 m = _mm256_loadu_ps(mirror);
+	m = _mm256_permute2f128_ps(m, m, 1); // swap halves
+	return _mm512_add_pd(loadWideAVX512(signal), widenAVX512(_mm256_permute_ps(m, _MM_SHUFFLE(0, 1, 2, 3))));
+}
+
+SIMD_TARGET("avx512f")
+inline float dotProductWideAVX512(const float* signal, const float* kernel, int length) {
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	for (int i = 0; i < length; i += 16) {
+		a0 = _mm512_fmadd_pd(loadWideAVX512(signal + i), loadWideAVX512(kernel + i), a0);
+		a1 = _mm512_fmadd_pd(loadWideAVX512(signal + i + 8), loadWideAVX512(kernel + i + 8), a1);
+	}
+	return static_cast<float>(sum8doubles(_mm512_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProduct4WideAVX512(const float* kernel, const float* const* signals, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	__m512d a2 = _mm512_setzero_pd();
+	__m512d a3 = _mm512_setzero_pd();
+	for (int i = 0; i < length; i += 8) {
+		__m512d k = loadWideAVX512(kernel + i);
+		a0 = _mm512_fmadd_pd(loadWideAVX512(s0 + i), k, a0);
+		a1 = _mm512_fmadd_pd(loadWideAVX512(s1 + i), k, a1);
+		a2 = _mm512_fmadd_pd(loadWideAVX512(s2 + i), k, a2);
+		a3 = _mm512_fmadd_pd(loadWideAVX512(s3 + i), k, a3);
+	}
+	out[0] = static_cast<float>(sum8doubles(a0));
+	out[1] = static_cast<float>(sum8doubles(a1));
+	out[2] = static_cast<float>(sum8doubles(a2));
+	out[3] = static_cast<float>(sum8doubles(a3));
+}
+
+SIMD_TARGET("avx512f")
+inline float dotProductSymmetricWideAVX512(const float* signal, const float* halfKernel, int halfLength, int length) {
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	const float* mirror = signal + length - 8;
+	for (int i = 0; i < halfLength; i += 16) {
+		a0 = _mm512_fmadd_pd(foldWideAVX512(signal + i, mirror - i), loadWideAVX512(halfKernel + i), a0);
+		a1 = _mm512_fmadd_pd(foldWideAVX512(signal + i + 8, mirror - i - 8), loadWideAVX512(halfKernel + i + 8), a1);
+	}
+	return static_cast<float>(sum8doubles(_mm512_add_pd(a0, a1)));
+}
+
+SIMD_TARGET("avx512f")
+inline void dotProductSymmetric4WideAVX512(const float* halfKernel, const float* const* signals, int halfLength, int length, float* out) {
+	const float* s0 = signals[0];
+	const float* s1 = signals[1];
+	const float* s2 = signals[2];
+	const float* s3 = signals[3];
+	const int m = length - 8; // offset of the mirrored load
+	__m512d a0 = _mm512_setzero_pd();
+	__m512d a1 = _mm512_setzero_pd();
+	__m512d a2 = _mm512_setzero_pd();
+	__m512d a3 = _mm512_setzero_pd();
+	for (int i = 0; i < halfLength; i += 8) {
+		__m512d k = loadWideAVX512(halfKernel + i);
+		a0 = _mm512_fmadd_pd(foldWideAVX512(s0 + i, s0 + m - i), k, a0);
+		a1 = _mm512_fmadd_pd(foldWideAVX512(s1 + i, s1 + m - i), k, a1);
+		a2 = _mm512_fmadd_pd(foldWideAVX512(s2 + i, s2 + m - i), k, a2);
+		a3 = _mm512_fmadd_pd(foldWideAVX512(s3 + i, s3 + m - i), k, a3);
+	}
+	out[0] = static_cast<float>(sum8doubles(a0));
+	out[1] = static_cast<float>(sum8doubles(a1));
+	out[2] = static_cast<float>(sum8doubles(a2));
+	out[3] = static_cast<float>(sum8doubles(a3));
+}
+
+#endif // defined(SIMD_X86)
+
+// getDotProductFunction() : returns the dot-product kernel for the given SIMD level
+template<typename FloatType>
+DotProductFunction<FloatType> getDotProductFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductSSE2);
+	case SimdAVX:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductAVX);
+	case SimdAVX2:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductAVX2);
+	case SimdAVX512:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductAVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductScalar<FloatType>;
+}
+
+// getDotProductUnalignedFunction() : returns the unaligned-signal dot-product kernel for the given SIMD level
+template<typename FloatType>
+DotProductFunction<FloatType> getDotProductUnalignedFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductUnalignedSSE2);
+	case SimdAVX:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductUnalignedAVX);
+	case SimdAVX2:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductUnalignedAVX2);
+	case SimdAVX512:
+		return static_cast<DotProductFunction<FloatType>>(&dotProductUnalignedAVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductUnalignedScalar<FloatType>;
+}
+
+// getDotProduct4Function() : returns the multi-output dot-product kernel for the given SIMD level
+template<typename FloatType>
+DotProduct4Function<FloatType> getDotProduct4Function(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<DotProduct4Function<FloatType>>(&dotProduct4SSE2);
+	case SimdAVX:
+		return static_cast<DotProduct4Function<FloatType>>(&dotProduct4AVX);
+	case SimdAVX2:
+		return static_cast<DotProduct4Function<FloatType>>(&dotProduct4AVX2);
+	case SimdAVX512:
+		return static_cast<DotProduct4Function<FloatType>>(&dotProduct4AVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProduct4Scalar<FloatType>;
+}
+
+// getDotProductSymmetricFunction() : returns the symmetric dot-product kernel for the given SIMD level
+template<typename FloatType>
+DotProductSymmetricFunction<FloatType> getDotProductSymmetricFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<DotProductSymmetricFunction<FloatType>>(&dotProductSymmetricSSE2);
+	case SimdAVX:
+		return static_cast<DotProductSymmetricFunction<FloatType>>(&dotProductSymmetricAVX);
+	case SimdAVX2:
+		return static_cast<DotProductSymmetricFunction<FloatType>>(&dotProductSymmetricAVX2);
+	case SimdAVX512:
+		return static_cast<DotProductSymmetricFunction<FloatType>>(&dotProductSymmetricAVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductSymmetricScalar<FloatType>;
+}
+
+// getDotProductSymmetric4Function() : returns the multi-output symmetric dot-product kernel for the given SIMD level
+template<typename FloatType>
+DotProductSymmetric4Function<FloatType> getDotProductSymmetric4Function(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<DotProductSymmetric4Function<FloatType>>(&dotProductSymmetric4SSE2);
+	case SimdAVX:
+		return static_cast<DotProductSymmetric4Function<FloatType>>(&dotProductSymmetric4AVX);
+	case SimdAVX2:
+		return static_cast<DotProductSymmetric4Function<FloatType>>(&dotProductSymmetric4AVX2);
+	case SimdAVX512:
+		return static_cast<DotProductSymmetric4Function<FloatType>>(&dotProductSymmetric4AVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductSymmetric4Scalar<FloatType>;
+}
+
+// getChannelLaneFunction() : returns the channel-lane kernel for the given SIMD level
+template<typename FloatType>
+ChannelLaneFunction<FloatType> getChannelLaneFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<ChannelLaneFunction<FloatType>>(&channelLanesSSE2);
+	case SimdAVX:
+		return static_cast<ChannelLaneFunction<FloatType>>(&channelLanesAVX);
+	case SimdAVX2:
+		return static_cast<ChannelLaneFunction<FloatType>>(&channelLanesAVX2);
+	case SimdAVX512:
+		return static_cast<ChannelLaneFunction<FloatType>>(&channelLanesAVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &channelLanesScalar<FloatType>;
+}
+
+// getSymmetricLaneFunction() : returns the symmetric output-lane kernel for the given SIMD level
+template<typename FloatType>
+SymmetricLaneFunction<FloatType> getSymmetricLaneFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return static_cast<SymmetricLaneFunction<FloatType>>(&symmetricLanesSSE2);
+	case SimdAVX:
+		return static_cast<SymmetricLaneFunction<FloatType>>(&symmetricLanesAVX);
+	case SimdAVX2:
+		return static_cast<SymmetricLaneFunction<FloatType>>(&symmetricLanesAVX2);
+	case SimdAVX512:
+		return static_cast<SymmetricLaneFunction<FloatType>>(&symmetricLanesAVX512);
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &symmetricLanesScalar<FloatType>;
+}
+
+// getWideDotProductFunction() : returns the wide-accumulation dot-product kernel (which also serves as the unaligned kernel) for the given SIMD level
+inline DotProductFunction<float> getWideDotProductFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return &dotProductWideSSE2;
+	case SimdAVX:
+	case SimdAVX2:
+		return &dotProductWideAVX;
+	case SimdAVX512:
+		return &dotProductWideAVX512;
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductWideScalar;
+}
+
+// getWideDotProduct4Function() : returns the multi-output wide-accumulation dot-product kernel for the given SIMD level
+inline DotProduct4Function<float> getWideDotProduct4Function(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return &dotProduct4WideSSE2;
+	case SimdAVX:
+	case SimdAVX2:
+		return &dotProduct4WideAVX;
+	case SimdAVX512:
+		return &dotProduct4WideAVX512;
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProduct4WideScalar;
+}
+
+// getWideDotProductSymmetricFunction() : returns the symmetric wide-accumulation dot-product kernel for the given SIMD level
+inline DotProductSymmetricFunction<float> getWideDotProductSymmetricFunction(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return &dotProductSymmetricWideSSE2;
+	case SimdAVX:
+	case SimdAVX2:
+		return &dotProductSymmetricWideAVX;
+	case SimdAVX512:
+		return &dotProductSymmetricWideAVX512;
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductSymmetricWideScalar;
+}
+
+// getWideDotProductSymmetric4Function() : returns the multi-output symmetric wide-accumulation dot-product kernel for the given SIMD level
+inline DotProductSymmetric4Function<float> getWideDotProductSymmetric4Function(SimdLevel level) {
+#if defined(SIMD_X86)
+	switch (level) {
+	case SimdSSE2:
+		return &dotProductSymmetric4WideSSE2;
+	case SimdAVX:
+	case SimdAVX2:
+		return &dotProductSymmetric4WideAVX;
+	case SimdAVX512:
+		return &dotProductSymmetric4WideAVX512;
+	default:
+		break;
+	}
+#else
+	(void)level; // unused
+#endif
+	return &dotProductSymmetric4WideScalar;
+}
+
+} // namespace ReSampler
+
+#endif // SIMD_H
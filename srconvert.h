@@ -12,37 +12,182 @@
 #ifndef SRCONVERT_H
 #define SRCONVERT_H 1
 
+#define USE_POLYPHASE_ON_INTERPOLATE
+#define USE_POLYPHASE_ON_INTERPOLATE_DECIMATE
 //#define USE_LAZYGET_ON_INTERPOLATE
-#define USE_LAZYGET_ON_INTERPOLATE_DECIMATE
+#define USE_LAZYGET_ON_INTERPOLATE_DECIMATE // (only relevant when USE_POLYPHASE_ON_INTERPOLATE_DECIMATE is not defined)
+#define USE_FFTFILTER // use overlap-save (FFT) filtering for stages in which it is estimated to be cheaper than direct-form
+#define USE_FIXED_RATIO_KERNELS // use conversion functions compiled for the common stage ratios (see ResamplingStage::fixedRatioConvert())
+#if defined(USE_POLYPHASE_ON_INTERPOLATE) && defined(USE_POLYPHASE_ON_INTERPOLATE_DECIMATE)
+#define USE_MULTICHANNEL_FIR // convert all channels with one (interleaved) Converter, with the channels in SIMD lanes (see MultichannelFIRFilter.h)
+#endif
 
 #include "FIRFilter.h"
+#include "equiripple.h"
+#include "FFTFilter.h"
+#include "PartitionedFFTFilter.h"
+#include "FarrowFilter.h"
+#include "HalfBandFilter.h"
+#include "IIRHalfBandFilter.h"
+#include "WholeSignalResampler.h"
+#include "MultichannelFIRFilter.h"
 #include "conversioninfo.h"
 #include "fraction.h"
 #include "ReSampler.h"
+#include "tuning.h"
+
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
 
 namespace ReSampler {
 
 static_assert(std::is_copy_constructible<ConversionInfo>::value, "ConversionInfo needs to be copy Constructible");
 static_assert(std::is_copy_assignable<ConversionInfo>::value, "ConversionInfo needs to be copy Assignable");
 
+// getSidelobeAttenuation() : stopband attenuation (in dB) of the lowpass filters for the given quality tier.
+// The archival tier has 195 dB for integer ratios, and 160 dB otherwise. The other tiers are a comfortable margin
+// below the noise floor of the output format (eg 16-bit dithered output has a noise floor of about -96 dBFS)
+inline int getSidelobeAttenuation(QualityTier tier, bool integerRatio) {
+	switch (tier) {
+	case quality24Bit:
+		return 150;
+	case quality16Bit:
+		return 110;
+	case qualityDraft:
+		return 80;
+	default:
+		return integerRatio ? 195 : 160;
+	}
+}
+
+// getFilterSizeScale() : length of the filters for the given quality tier, relative to the archival tier.
+// (For a Kaiser-windowed filter of a given transition width, the length is proportional to (attenuation - 7.95))
+inline double getFilterSizeScale(QualityTier tier, bool integerRatio) {
+	return (getSidelobeAttenuation(tier, integerRatio) - 7.95) / (getSidelobeAttenuation(qualityArchival, integerRatio) - 7.95);
+}
+
+// getFilterSize() : determine filtersize from steepness (transition width), conversion ratio and quality tier
+inline int getFilterSize(const ConversionInfo& ci, Fraction fraction) {
+	double steepness = 0.090909091 / (ci.lpfTransitionWidth / 100.0);
+	double scale = getFilterSizeScale(ci.qualityTier, (fraction.numerator == 1) || (fraction.denominator == 1));
+	return static_cast<int>(
+		std::min<int>(FILTERSIZE_BASE * ci.overSamplingFactor * std::max(fraction.denominator, fraction.numerator) * steepness * scale, FILTERSIZE_LIMIT)
+		| 1 // ensure that filter length is always odd
+	);
+}
+
+// FilterDesignReport : tap counts and measured responses (over the transition band of the Kaiser design) of the
+// Kaiser-windowed and equiripple designs of a filter, when an equiripple design has been attempted (see makeFilterCoefficients())
+struct FilterDesignReport {
+	bool requested{false};
+	bool attempted{false};
+	int kaiserSize{0};
+	LPFResponse kaiserResponse{0.0, 0.0};
+	int equirippleSize{0}; // (0 if no design met the specification, in which case the Kaiser design is used)
+	LPFResponse equirippleResponse{0.0, 0.0};
+
+	void print(std::ostream& os) const {
+		if (!requested) {
+			return;
+		}
+		if (!attempted) {
+			os << "Equiripple design: not attempted (Kaiser design has " << kaiserSize << " taps; limit is " << EQUIRIPPLE_MAX_TAPS << ")\n";
+			return;
+		}
+		auto describe = [](int size, const LPFResponse& response) -> std::string {
+			std::ostringstream ss;
+			ss << size << " taps, passband ripple " << std::scientific << std::setprecision(2) << response.passbandRippleDB() << " dB, "
+			   << "stopband attenuation " << std::fixed << std::setprecision(1) << response.stopbandAttenuationDB() << " dB";
+			return ss.str();
+		};
+		os << "Kaiser design: " << describe(kaiserSize, kaiserResponse) << "\n";
+		if (equirippleSize == 0) {
+			os << "Equiripple design: none shorter than the Kaiser design meets its specification (using Kaiser design)\n";
+		}
+		else {
+			os << "Equiripple design: " << describe(equirippleSize, equirippleResponse) << "\n";
+		}
+	}
+};
+
+// makeEquirippleCoefficients() : shortest equiripple filter (see makeEquirippleLPF()) which is no worse than the given (Kaiser) filter,
+// over the transition band of the Kaiser design. If passbandRippleDB is non-zero, it replaces the passband ripple of the Kaiser design in the specification.
+// Returns false (leaving filterTaps unchanged) if there is no such filter shorter than the Kaiser design.
+template<typename FloatType>
+bool makeEquirippleCoefficients(std::vector<FloatType>& filterTaps, double ft, double sampFreq, int sidelobeAtten, double passbandRippleDB, FilterDesignReport& report) {
+	const auto kaiserSize = static_cast<int>(filterTaps.size());
+	const double transitionWidth = getKaiserTransitionWidth(kaiserSize, sidelobeAtten);
+	const double fp = ft / sampFreq - transitionWidth / 2.0;
+	const double fs = ft / sampFreq + transitionWidth / 2.0;
+
+	report.attempted = true;
+	report.kaiserSize = kaiserSize;
+	report.kaiserResponse = measureLPFResponse(filterTaps.data(), kaiserSize, fp, fs);
+	if (fp <= 0.0 || fs >= 0.5) {
+		return false;
+	}
+
+	// specification:
+	const double passbandRipple = (passbandRippleDB > 0.0) ? std::pow(10.0, passbandRippleDB / 20.0) - 1.0 : report.kaiserResponse.passbandRipple;
+	const double stopbandPeak = report.kaiserResponse.stopbandPeak;
+
+	// (the design is done in double precision, but the response is measured with the coefficients in the precision in which they will be used)
+	std::vector<FloatType> h;
+	LPFResponse response{0.0, 0.0};
+	auto meetsSpecification = [&](int length) -> bool {
+		h.assign(length, 0.0);
+		return makeEquirippleLPF<FloatType>(h.data(), length, fp * sampFreq, fs * sampFreq, sampFreq, stopbandPeak / passbandRipple) &&
+				(response = measureLPFResponse(h.data(), length, fp, fs)).passbandRipple <= passbandRipple * 1.01 &&
+				response.stopbandPeak <= stopbandPeak * 1.01;
+	};
+
+	// binary search (over odd lengths) between the estimated length (which is usually a little short) and the Kaiser design:
+	int lo = std::min(estimateEquirippleLength(passbandRipple, stopbandPeak, fs - fp), kaiserSize - 2); // (fails, or is found to succeed)
+	int hi = kaiserSize - 2; // (succeeds, once tested)
+	std::vector<FloatType> best;
+	if (!meetsSpecification(hi)) {
+		return false;
+	}
+	best = h;
+	report.equirippleResponse = response;
+	if (lo < hi && meetsSpecification(lo)) {
+		hi = lo;
+		best = h;
+		report.equirippleResponse = response;
+	}
+	while (hi - lo > 2) {
+		int mid = lo + (hi - lo) / 4 * 2; // (odd)
+		if (meetsSpecification(mid)) {
+			hi = mid;
+			best = h;
+			report.equirippleResponse = response;
+		}
+		else {
+			lo = mid;
+		}
+	}
+
+	report.equirippleSize = hi;
+	filterTaps = best;
+	return true;
+}
+
+// makeFilterCoefficients() : Kaiser-windowed sinc filter for the given conversion (or, if ci.bEquiripple is set and one is found,
+// the shortest equiripple filter with the same (measured) response - see makeEquirippleCoefficients()).
+// If report is supplied, it is filled with the tap counts and measured responses of both designs.
 template<typename FloatType>
-std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction fraction) {
+std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction fraction, FilterDesignReport* report = nullptr) {
 
-	// determine cutoff frequency and steepness
+	// determine cutoff frequency
 	double targetNyquist = std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
 	double ft = (ci.lpfCutoff / 100.0) * targetNyquist;
-	double steepness = 0.090909091 / (ci.lpfTransitionWidth / 100.0);
 
 	// determine filtersize
-	int filterSize = static_cast<int>(
-		std::min<int>(FILTERSIZE_BASE * ci.overSamplingFactor * std::max(fraction.denominator, fraction.numerator) * steepness, FILTERSIZE_LIMIT)
-		| 1 // ensure that filter length is always odd
-	);
+	int filterSize = getFilterSize(ci, fraction);
 
 	// determine sidelobe attenuation
-	int sidelobeAtten = ((fraction.numerator == 1) || (fraction.denominator == 1)) ?
-		195 :
-		160;
+	int sidelobeAtten = getSidelobeAttenuation(ci.qualityTier, (fraction.numerator == 1) || (fraction.denominator == 1));
 
 	// Make some filter coefficients:
 	int sampFreq = ci.overSamplingFactor * ci.inputSampleRate * fraction.numerator;
@@ -51,6 +196,21 @@ std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction
 	makeLPF<FloatType>(pFilterTaps, filterSize, ft, sampFreq);
 	applyKaiserWindow<FloatType>(pFilterTaps, filterSize, calcKaiserBeta(sidelobeAtten));
 
+	// conditionally replace with an equiripple design:
+	// (not for bypass mode, which doesn't use the filter)
+	if (ci.bEquiripple && fraction.numerator != fraction.denominator) {
+		FilterDesignReport r;
+		r.requested = true;
+		r.kaiserSize = filterSize;
+		if (filterSize <= EQUIRIPPLE_MAX_TAPS && makeEquirippleCoefficients(filterTaps, ft, sampFreq, sidelobeAtten, ci.equiripplePassbandRipple, r)) {
+			filterSize = static_cast<int>(filterTaps.size());
+			pFilterTaps = &filterTaps[0];
+		}
+		if (report != nullptr) {
+			*report = r;
+		}
+	}
+
 	// conditionally convert filter coefficients to minimum-phase:
 	if (ci.bMinPhase) {
 		makeMinPhase<FloatType>(pFilterTaps, filterSize);
@@ -60,16 +220,165 @@ std::vector<FloatType> makeFilterCoefficients(const ConversionInfo& ci, Fraction
 	return filterTaps;
 }
 
+// getHalfBandFilterSize() : filtersize (of the form 4k + 3) of a half-band filter for a 2:1 (or 1:2) stage, where highRate is the
+// higher of the two sample rates, and transitionWidth (in Hz) is the width of the transition band on either side of the cutoff (highRate / 4).
+// The steepness is determined in the same way as for makeFilterCoefficients().
+inline int getHalfBandFilterSize(double highRate, double transitionWidth, QualityTier tier = qualityArchival) {
+	double nyquist = highRate / 4.0; // (of the lower rate)
+	double steepness = 0.090909091 / (transitionWidth / nyquist);
+	return static_cast<int>(
+		std::min<int>(FILTERSIZE_BASE * 2 * steepness * getFilterSizeScale(tier, true), FILTERSIZE_LIMIT)
+		| 3 // half-band filters have a length of the form 4k + 3
+	);
+}
+
+// makeHalfBandCoefficients() : half-band filter coefficients (see getHalfBandFilterSize() and makeHalfBandLPF())
+template<typename FloatType>
+std::vector<FloatType> makeHalfBandCoefficients(double highRate, double transitionWidth, QualityTier tier = qualityArchival) {
+	int filterSize = getHalfBandFilterSize(highRate, transitionWidth, tier);
+	std::vector<FloatType> filterTaps(filterSize, 0);
+	FloatType* pFilterTaps = &filterTaps[0];
+	makeHalfBandLPF<FloatType>(pFilterTaps, filterSize);
+	applyKaiserWindow<FloatType>(pFilterTaps, filterSize, calcKaiserBeta(getSidelobeAttenuation(tier, true))); // (integer ratio)
+	return filterTaps;
+}
+
+// getArbitraryRatioOutputRate() : the lowest output sample rate of the FarrowFilter, which its prototype filter is designed for.
+// In variable-ratio mode, a ratio factor below 1 lowers the output rate (see ConversionInfo::minRatioFactor)
+inline double getArbitraryRatioOutputRate(const ConversionInfo& ci) {
+	return ci.outputSampleRate * (ci.bVariableRatio ? std::min(1.0, ci.minRatioFactor) : 1.0);
+}
+
+// getArbitraryRatioTapsPerPhase() : number of taps (ie input samples) in each phase of the prototype filter for the FarrowFilter.
+// The steepness is determined in the same way as for makeFilterCoefficients(); when decimating, the filter spans more input samples.
+inline int getArbitraryRatioTapsPerPhase(const ConversionInfo& ci, int numPhases) {
+	double steepness = 0.090909091 / (ci.lpfTransitionWidth / 100.0);
+	double decimation = std::max(1.0, ci.inputSampleRate / getArbitraryRatioOutputRate(ci));
+	double scale = getFilterSizeScale(ci.qualityTier, false);
+	return std::max(2, std::min(static_cast<int>(std::ceil(FILTERSIZE_BASE * steepness * decimation * scale)), FILTERSIZE_LIMIT / numPhases));
+}
+
+// makeArbitraryRatioCoefficients() : prototype filter for the FarrowFilter, at numPhases times the input sample rate
+// (with a gain of numPhases, so that each phase has unity gain)
+template<typename FloatType>
+std::vector<FloatType> makeArbitraryRatioCoefficients(const ConversionInfo& ci, int numPhases) {
+	double targetNyquist = std::min(static_cast<double>(ci.inputSampleRate), getArbitraryRatioOutputRate(ci)) / 2.0;
+	double ft = (ci.lpfCutoff / 100.0) * targetNyquist;
+	int filterSize = getArbitraryRatioTapsPerPhase(ci, numPhases) * numPhases - 1; // (odd)
+
+	std::vector<FloatType> filterTaps(filterSize, 0);
+	FloatType* pFilterTaps = &filterTaps[0];
+	makeLPF<FloatType>(pFilterTaps, filterSize, ft, static_cast<FloatType>(numPhases) * ci.inputSampleRate);
+	applyKaiserWindow<FloatType>(pFilterTaps, filterSize, calcKaiserBeta(getSidelobeAttenuation(ci.qualityTier, false)));
+
+	if (ci.bMinPhase) {
+		makeMinPhase<FloatType>(pFilterTaps, filterSize);
+	}
+
+	for (auto& t : filterTaps) {
+		t *= numPhases;
+	}
+	return filterTaps;
+}
+
+// shouldUseWholeSignal() : whether a file of inputFrames frames should be converted all at once by the WholeSignalResampler, instead of by a Converter.
+// The input and output must each fit within WHOLESIGNAL_MAX_FRAMES, and the conversion must be one which the WholeSignalResampler does in the same way
+// (a fixed ratio, with a linear-phase filter and the delay trimmed, and no particular filter design requested).
+inline bool shouldUseWholeSignal(const ConversionInfo& ci, int64_t inputFrames) {
+	if (!ci.bWholeSignal || ci.bLowLatency || ci.inputSampleRate == ci.outputSampleRate || ci.bVariableRatio || ci.bMinPhase || !ci.bDelayTrim || ci.bIIR || ci.bEquiripple) {
+		return false;
+	}
+	if (ci.lpfCutoff <= 0.0 || ci.lpfCutoff >= 100.0 || ci.lpfTransitionWidth <= 0.0) {
+		return false;
+	}
+	const int64_t outputFrames = inputFrames * ci.outputSampleRate / ci.inputSampleRate + 1;
+	return inputFrames > 0 && std::max(inputFrames, outputFrames) <= WHOLESIGNAL_MAX_FRAMES;
+}
+
+// makeWholeSignalResampler() : WholeSignalResampler with its passband extending to the LPF transition frequency (as for makeFilterCoefficients()),
+// its stopband starting at (cutoff + transition width), but no higher than the lower Nyquist frequency, and the usual stopband attenuation
+template<typename FloatType>
+WholeSignalResampler<FloatType> makeWholeSignalResampler(const ConversionInfo& ci) {
+	Fraction f = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
+	double targetNyquist = std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
+	double ft = (ci.lpfCutoff / 100.0) * targetNyquist;
+	double stopFreq = std::min(ci.lpfCutoff + ci.lpfTransitionWidth, 100.0) / 100.0 * targetNyquist;
+	return WholeSignalResampler<FloatType>(f.numerator, f.denominator, ft / ci.inputSampleRate, stopFreq / ci.inputSampleRate,
+										   getSidelobeAttenuation(ci.qualityTier, (f.numerator == 1) || (f.denominator == 1)));
+}
+
 template<typename FloatType>
 class ResamplingStage
 {
 public:
-	ResamplingStage(int L, int M, const FIRFilter<FloatType>& filter, bool bypassMode = false)
-		: L(L), M(M),  m(0), filter(filter), bypassMode(bypassMode)
+	// linearPhase: the filter taps are symmetric (allowing FIRFilter to use its symmetric mode when there are no subfilters)
+	// numChannels: number of interleaved channels in the input and output buffers (sizes are then in frames)
+	// blockSize: (low-latency mode) number of input frames per call of convert(), or 0 if the blocks are large (see chooseEngine())
+	// If the stage is 2:1 or 1:2, and the taps are a half-band filter (see makeHalfBandCoefficients()), the HalfBandFilter engine is used.
+	ResamplingStage(int L, int M, const std::vector<FloatType>& filterTaps, bool bypassMode = false, bool linearPhase = false, int numChannels = 1, int blockSize = 0)
+		: L(L), M(M),  m(0), numChannels(numChannels), useHalfBand(shouldUseHalfBand(L, M, filterTaps)),
+		  useFFT(!useHalfBand && chooseEngine(L, M, static_cast<int>(filterTaps.size()), blockSize) == fftEngine),
+		  usePartitioned(!useHalfBand && chooseEngine(L, M, static_cast<int>(filterTaps.size()), blockSize) == partitionedEngine),
+		  useFarrow(false), useIIR(false),
+		  filter(filterTaps.data(), (useFFT || usePartitioned || useHalfBand || numChannels != 1) ? 0 : static_cast<int>(filterTaps.size()), getNumSubfilters(L, M), linearPhase && L == 1),
+		  bypassMode(bypassMode)
+	{
+		if (useHalfBand) {
+			hbFilter = HalfBandFilter<FloatType>(filterTaps.data(), static_cast<int>(filterTaps.size()), L == 2);
+
+			// for multichannel stages, each channel is filtered separately (see convertChannels()), with its own copy of the HalfBandFilter
+			for (int ch = 1; ch < numChannels; ch++) {
+				channelHBFilters.push_back(hbFilter);
+			}
+		}
+		else if (useFFT) {
+			fftFilter = FFTFilter<FloatType>(filterTaps.data(), static_cast<int>(filterTaps.size()), getNumSubfilters(L, M), gcd(L, M));
+
+			// for multichannel stages, each channel is filtered separately (see convertChannels()), with its own copy of the FFTFilter
+			for (int ch = 1; ch < numChannels; ch++) {
+				channelFFTFilters.push_back(fftFilter);
+			}
+		}
+		else if (usePartitioned) {
+			partitionedFilter = PartitionedFFTFilter<FloatType>(filterTaps.data(), static_cast<int>(filterTaps.size()),
+																PartitionedFFTFilter<FloatType>::calcPartitionSize(blockSize), getNumSubfilters(L, M), gcd(L, M));
+
+			// for multichannel stages, each channel is filtered separately (see convertChannels()), with its own copy of the PartitionedFFTFilter
+			for (int ch = 1; ch < numChannels; ch++) {
+				channelPartitionedFilters.push_back(partitionedFilter);
+			}
+		}
+		else if (numChannels != 1) {
+			mcFilter = MultichannelFIRFilter<FloatType>(filterTaps.data(), static_cast<int>(filterTaps.size()), getNumSubfilters(L, M), numChannels);
+		}
+
+		// allocate room for listing the outputs of one block:
+		int engineBlockSize = useHalfBand ? hbFilter.getBlockSize() : useFFT ? fftFilter.getBlockSize() : usePartitioned ? partitionedFilter.getBlockSize() :
+			(numChannels != 1) ? mcFilter.getBlockSize() : filter.getBlockSize();
+		auto maxOutputsPerBlock = static_cast<size_t>(2 + static_cast<int64_t>(engineBlockSize) * L / M);
+		outputAges.resize(maxOutputsPerBlock);
+		outputSubfilters.resize(maxOutputsPerBlock);
+
+		SetConvertFunction();
+	}
+
+	// arbitrary-ratio stage: converts by L / M with the given FarrowFilter (which handles all the channels itself)
+	ResamplingStage(int L, int M, const FarrowFilter<FloatType>& farrowFilter, int numChannels = 1)
+		: L(L), M(M), m(0), numChannels(numChannels), useHalfBand(false), useFFT(false), usePartitioned(false), useFarrow(true), useIIR(false),
+		  filter(nullptr, 0, 1), farrowFilter(farrowFilter), bypassMode(false)
 	{
 		SetConvertFunction();
 	}
 
+	// IIR half-band stage: converts by 2:1 or 1:2 with the given IIRHalfBandFilter (which handles all the channels itself)
+	ResamplingStage(int L, int M, const IIRHalfBandFilter<FloatType>& iirFilter, int numChannels = 1)
+		: L(L), M(M), m(0), numChannels(numChannels), useHalfBand(false), useFFT(false), usePartitioned(false), useFarrow(false), useIIR(true),
+		  filter(nullptr, 0, 1), iirFilter(iirFilter), bypassMode(false)
+	{
+		assert((L == 2 && M == 1) || (L == 1 && M == 2));
+		SetConvertFunction();
+	}
+
 	void convert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
 		(this->*convertFn)(outBuffer, outBufferSize, inBuffer, inBufferSize);
 	}
@@ -79,42 +388,384 @@ public:
 		SetConvertFunction();
 	}
 
+	// setFixedRatioKernelsEnabled() : whether a fixed-ratio conversion function (see fixedRatioConvert()) may be used, if there is one
+	// for the ratio of this stage (otherwise, the general conversion functions are used)
+	void setFixedRatioKernelsEnabled(bool enabled) {
+		fixedRatioKernelsEnabled = enabled;
+		SetConvertFunction();
+	}
+
+	bool isUsingFixedRatioKernel() const {
+		return usingFixedRatioKernel;
+	}
+
 	void reset() {
 		filter.reset();
+		fftFilter.reset();
+		partitionedFilter.reset();
+		mcFilter.reset();
+		hbFilter.reset();
+		farrowFilter.reset();
+		iirFilter.reset();
+		for (auto& f : channelFFTFilters) {
+			f.reset();
+		}
+		for (auto& f : channelPartitionedFilters) {
+			f.reset();
+		}
+		for (auto& f : channelHBFilters) {
+			f.reset();
+		}
 		m = 0;
 	}
 
+	bool isUsingFFT() const {
+		return useFFT;
+	}
+
+	// estimateCost() : estimated cost, in multiply-accumulates per input sample (or the equivalent, for the FFT methods), of an ordinary stage
+	// converting by L / M with a filter of numTaps taps, using the engine which would be chosen for it (see chooseEngine())
+	static double estimateCost(int L, int M, int numTaps, int blockSize = 0) {
+		double costs[3];
+		getEngineCosts(L, M, numTaps, blockSize, costs);
+		return costs[chooseEngine(L, M, numTaps, blockSize)];
+	}
+
+	bool isUsingPartitionedFFT() const {
+		return usePartitioned;
+	}
+
+	bool isUsingHalfBand() const {
+		return useHalfBand;
+	}
+
+	bool isUsingFarrow() const {
+		return useFarrow;
+	}
+
+	bool isUsingIIR() const {
+		return useIIR;
+	}
+
+	// setRatio() : (arbitrary-ratio stage only) sets the ratio factor of the FarrowFilter (see FarrowFilter::setRatio())
+	void setRatio(double factor, bool ramp = true) {
+		assert(useFarrow);
+		farrowFilter.setRatio(factor, ramp);
+	}
+
+	bool isUsingSymmetricKernel() const {
+		return filter.isSymmetric();
+	}
+
+	// getKernelBytes() : memory used by the filter kernel(s) of this stage (which copies of the stage share)
+	size_t getKernelBytes() const {
+		return filter.getKernelBytes() + fftFilter.getKernelBytes() + partitionedFilter.getKernelBytes() + mcFilter.getKernelBytes() + hbFilter.getKernelBytes() + farrowFilter.getKernelBytes() + iirFilter.getKernelBytes();
+	}
+
+	// getStateBytes() : memory used by the filter histories and buffers of this stage
+	size_t getStateBytes() const {
+		size_t bytes = filter.getStateBytes() + fftFilter.getStateBytes() + partitionedFilter.getStateBytes() + mcFilter.getStateBytes() + hbFilter.getStateBytes() + farrowFilter.getStateBytes() + iirFilter.getStateBytes();
+		for (const auto& f : channelFFTFilters) {
+			bytes += f.getStateBytes();
+		}
+		for (const auto& f : channelPartitionedFilters) {
+			bytes += f.getStateBytes();
+		}
+		for (const auto& f : channelHBFilters) {
+			bytes += f.getStateBytes();
+		}
+		return bytes;
+	}
+
+	// getFilteringMethod() : description of the filtering engine used by this stage
+	std::string getFilteringMethod() const {
+		if (usingFixedRatioKernel) {
+			return getEngineName() + ", fixed " + std::to_string(L) + ":" + std::to_string(M) + " kernel";
+		}
+		return getEngineName();
+	}
+
 private:
+	// getEngineName() : description of the filtering engine alone
+	std::string getEngineName() const {
+		if (useFarrow) {
+			return "arbitrary-ratio (Farrow, " + std::to_string(farrowFilter.getNumPhases()) + " phases of " +
+					std::to_string(farrowFilter.getTapsPerPhase()) + " taps)";
+		}
+		if (useIIR) {
+			return "IIR half-band (" + std::to_string(iirFilter.getNumCoefficients()) + " all-pass coefficients)";
+		}
+		if (useHalfBand) {
+			return "half-band";
+		}
+		if (useFFT) {
+			return "FFT (overlap-save)";
+		}
+		if (usePartitioned) {
+			return "FFT (uniformly-partitioned, " + std::to_string(partitionedFilter.getNumPartitions()) + " partitions of " +
+					std::to_string(partitionedFilter.getPartitionSize()) + " taps)";
+		}
+		if (numChannels != 1) {
+			return "direct-form (channel lanes)";
+		}
+		std::string name = isUsingSymmetricKernel() ? "direct-form (symmetric kernel)" : "direct-form";
+		return filter.hasWideAccumulation() ? name + ", double-precision accumulation" : name;
+	}
+
 	int L;	// interpoLation factor
 	int M;	// deciMation factor
-	int m;	// decimation index
-	FIRFilter<FloatType> filter;
+	int m;	// decimation index (or, in polyphase mode, the phase of the next output relative to the most recent input)
+	int numChannels;
+	bool useHalfBand;
+	bool useFFT;
+	bool usePartitioned;
+	bool useFarrow;
+	bool useIIR;
+	FIRFilter<FloatType> filter;		// direct-form filter (empty when useFFT, usePartitioned or useHalfBand is true, or when there is more than one channel)
+	FFTFilter<FloatType> fftFilter;		// overlap-save filter (empty when useFFT is false)
+	PartitionedFFTFilter<FloatType> partitionedFilter;	// uniformly-partitioned overlap-save filter (empty when usePartitioned is false)
+	HalfBandFilter<FloatType> hbFilter;	// half-band filter (empty when useHalfBand is false)
+	FarrowFilter<FloatType> farrowFilter;	// arbitrary-ratio filter, for all channels (empty when useFarrow is false)
+	IIRHalfBandFilter<FloatType> iirFilter;	// IIR half-band filter, for all channels (empty when useIIR is false)
+	MultichannelFIRFilter<FloatType> mcFilter;	// direct-form filter for interleaved channels (empty when useFFT, usePartitioned or useHalfBand is true, or when there is one channel)
+	std::vector<FFTFilter<FloatType>> channelFFTFilters;	// (multichannel with useFFT) FFTFilters for channels 1 ... numChannels - 1
+	std::vector<PartitionedFFTFilter<FloatType>> channelPartitionedFilters;	// (multichannel with usePartitioned) PartitionedFFTFilters for channels 1 ... numChannels - 1
+	std::vector<HalfBandFilter<FloatType>> channelHBFilters;	// (multichannel with useHalfBand) HalfBandFilters for channels 1 ... numChannels - 1
+	std::vector<FloatType> channelInput;	// (multichannel with useFFT, usePartitioned or useHalfBand) de-interleaved input of one channel
+	std::vector<FloatType> channelOutput;	// (multichannel with useFFT, usePartitioned or useHalfBand) output of one channel
 	bool bypassMode;
+	bool fixedRatioKernelsEnabled = true;
+	bool usingFixedRatioKernel = false;	// convertFn (or channelConvertFn) is a fixedRatioConvert() function
+	std::vector<int> outputAges;		// for each output of the current block: age of the corresponding input ...
+	std::vector<int> outputSubfilters;	// ... and the subfilter which produces it
 
 	// The following typedef defines the type 'ConvertFunction' which is a pointer to any of the member functions which
 	// take the arguments (FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) ...
 	typedef void (ResamplingStage::*ConvertFunction) (FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize); // see https://isocpp.org/wiki/faq/pointers-to-members
 	ConvertFunction convertFn;
+	ConvertFunction channelConvertFn;	// (multichannel with useFFT, usePartitioned or useHalfBand) conversion function for each individual channel
 
 	// passThrough() - just copies input straight to output (used in bypassMode mode)
 	void passThrough(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
-		memcpy(outBuffer, inBuffer, inBufferSize * sizeof(FloatType));
+		memcpy(outBuffer, inBuffer, inBufferSize * numChannels * sizeof(FloatType));
 		outBufferSize = inBufferSize;
 	}
 
+	// convertChannels() - converts interleaved multichannel input with a single-channel engine (FFTFilter, PartitionedFFTFilter or HalfBandFilter), by de-interleaving
+	// each channel, and swapping that channel's filter into place. (Every channel starts from the same phase.)
+	void convertChannels(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		const int startPhase = m;
+		size_t o = 0;
+		channelInput.resize(std::max(channelInput.size(), inBufferSize));
+		channelOutput.resize(std::max(channelOutput.size(), static_cast<size_t>(2 + inBufferSize * L / M)));
+		for (int ch = 0; ch < numChannels; ch++) {
+			for (size_t i = 0; i < inBufferSize; i++) {
+				channelInput[i] = inBuffer[i * numChannels + ch];
+			}
+			if (ch != 0) {
+				swapChannelFilters(ch);
+			}
+			m = startPhase;
+			(this->*channelConvertFn)(channelOutput.data(), o, channelInput.data(), inBufferSize);
+			if (ch != 0) {
+				swapChannelFilters(ch);
+			}
+			for (size_t i = 0; i < o; i++) {
+				outBuffer[i * numChannels + ch] = channelOutput[i];
+			}
+		}
+		outBufferSize = o;
+	}
+
+	// swapChannelFilters() - swaps the filter of the given channel (1 ... numChannels - 1) with the one in use
+	void swapChannelFilters(int ch) {
+		if (useHalfBand) {
+			std::swap(hbFilter, channelHBFilters[ch - 1]);
+		}
+		else if (usePartitioned) {
+			std::swap(partitionedFilter, channelPartitionedFilters[ch - 1]);
+		}
+		else {
+			std::swap(fftFilter, channelFFTFilters[ch - 1]);
+		}
+	}
+
+	// Note: the block-based conversion functions below are instantiated for each filtering engine (FIRFilter, FFTFilter, PartitionedFFTFilter or MultichannelFIRFilter);
+	// the template parameter 'engine' is a pointer to the member which does the filtering.
+	// Positions and sizes are in frames, where a frame is one sample of each channel handled by the engine.
+
+	// frameSize() - number of (interleaved) channels handled by the filtering engine
+	template<typename Filter>
+	static int frameSize(const Filter&) {
+		return 1;
+	}
+
+	static int frameSize(const MultichannelFIRFilter<FloatType>& f) {
+		return f.getNumChannels();
+	}
+
+	// getOutput() - writes the output (frame) of the filtering engine for the given age and subfilter to out
+	template<typename Filter>
+	static void getOutput(Filter& f, int age, int subfilter, FloatType* out) {
+		*out = f.getAt(age, subfilter);
+	}
+
+	static void getOutput(MultichannelFIRFilter<FloatType>& f, int age, int subfilter, FloatType* out) {
+		f.getAt(age, subfilter, out);
+	}
+
+	// putBlock() - puts the next block of input (starting at frame i of inBuffer) into the filter, and returns the size of the block
+	template<typename Filter>
+	static int putBlock(Filter& f, const FloatType* inBuffer, size_t i, size_t inBufferSize) {
+		auto n = static_cast<int>(std::min(static_cast<size_t>(f.getBlockSize()), inBufferSize - i));
+		f.put(inBuffer + i * frameSize(f), n);
+		return n;
+	}
+
+	// getOutputs() - calculates the count outputs listed in outputAges / outputSubfilters, and writes them to out (starting at output frame o).
+	// Outputs which are numPhases apart use the same subfilter, so they are calculated four at a time with getAt4().
+	template<typename Filter>
+	void getOutputs(Filter& f, FloatType* out, size_t o, int count, int numPhases) {
+		const int* ages = outputAges.data();
+		const int* subfilters = outputSubfilters.data();
+		const int fs = frameSize(f);
+		out += o * fs;
+		for (int r = 0; r < std::min(numPhases, count); r++) {
+			int k = r;
+			for (; k + 3 * numPhases < count; k += 4 * numPhases) {
+				int a[4] = {ages[k], ages[k + numPhases], ages[k + 2 * numPhases], ages[k + 3 * numPhases]};
+				f.getAt4(a, subfilters[k], out + k * fs, numPhases);
+			}
+			for (; k < count; k += numPhases) {
+				getOutput(f, ages[k], subfilters[k], out + k * fs);
+			}
+		}
+	}
+
 	// filterOnly() - keeps 1:1 conversion ratio, but applies filter
+	template<typename Filter, Filter ResamplingStage::*engine>
 	void filterOnly(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		Filter& f = this->*engine;
 		size_t o = 0;
-		for(size_t i = 0; i < inBufferSize; ++i) {
-			filter.put(inBuffer[i]);
-			outBuffer[o++] = filter.get();
+		for (size_t i = 0; i < inBufferSize; ) {
+			int n = putBlock(f, inBuffer, i, inBufferSize);
+			for (int k = 0; k < n; k++) {
+				outputAges[k] = n - 1 - k;
+				outputSubfilters[k] = 0;
+			}
+			getOutputs(f, outBuffer, o, n, 1);
+			o += n;
+			i += n;
 		}
 		outBufferSize = inBufferSize;
 	}
 
-	// interpolate() - interpolate (zero-stuffing) and apply filter:
+	// isPolyphase() - whether the block-based polyphase method is used for the given conversion ratio
+	static bool isPolyphase(int L, int M) {
+#ifdef USE_POLYPHASE_ON_INTERPOLATE
+		if (L != 1 && M == 1) {
+			return true;
+		}
+#endif
+#ifdef USE_POLYPHASE_ON_INTERPOLATE_DECIMATE
+		if (L != 1 && M != 1) {
+			return true;
+		}
+#endif
+		(void)L; (void)M; // unused
+		return false;
+	}
+
+	// isLazy() - whether the zero-stuffing method uses lazyGet() (rather than get()) for the given conversion ratio
+	static bool isLazy(int L, int M) {
+#ifdef USE_LAZYGET_ON_INTERPOLATE
+		if (L != 1 && M == 1) {
+			return true;
+		}
+#endif
+#ifdef USE_LAZYGET_ON_INTERPOLATE_DECIMATE
+		if (L != 1 && M != 1) {
+			return true;
+		}
+#endif
+		(void)L; (void)M; // unused
+		return false;
+	}
+
+	// getNumSubfilters() - number of polyphase components required for the given conversion ratio.
+	// (lazyGet() also uses the polyphase decomposition, as it makes the taps for each phase contiguous)
+	static int getNumSubfilters(int L, int M) {
+		return (isPolyphase(L, M) || isLazy(L, M)) ? L : 1;
+	}
+
+	enum Engine {
+		directEngine,		// FIRFilter or MultichannelFIRFilter
+		fftEngine,			// FFTFilter
+		partitionedEngine	// PartitionedFFTFilter
+	};
+
+	// chooseEngine() - estimate which of direct-form, overlap-save and (in low-latency mode, ie with blockSize != 0) uniformly-partitioned
+	// filtering is cheapest for the given conversion ratio.
+	// Direct-form costs one multiply-accumulate per subfilter tap per output; the cost of the FFT methods is scaled
+	// so that overlap-save and direct-form break even at FFTFILTER_BREAKEVEN_TAPS for a 1:1 ratio.
+	// (Overlap-save does a whole FFT, of several times the length of the filter, for every block, no matter how short)
+	static Engine chooseEngine(int L, int M, int numTaps, int blockSize) {
+#ifdef USE_FFTFILTER
+		if (L != 1 && !isPolyphase(L, M)) {
+			return directEngine; // FFTFilter and PartitionedFFTFilter only support polyphase interpolation
+		}
+		double costs[3];
+		getEngineCosts(L, M, numTaps, blockSize, costs);
+		if (costs[partitionedEngine] < std::min(costs[directEngine], costs[fftEngine])) {
+			return partitionedEngine;
+		}
+		return (costs[fftEngine] < costs[directEngine]) ? fftEngine : directEngine;
+#else
+		(void)L; (void)M; (void)numTaps; (void)blockSize; // unused
+		return directEngine;
+#endif
+	}
+
+	// getEngineCosts() - estimated cost of each engine (indexed by Engine) per input sample, for the given conversion ratio (see chooseEngine())
+	static void getEngineCosts(int L, int M, int numTaps, int blockSize, double* costs) {
+		int numSubfilters = getNumSubfilters(L, M);
+		int length = (numTaps + numSubfilters - 1) / numSubfilters;
+		int numComputedSubfilters = numSubfilters / gcd(L, M);
+		const double scale = FFTFILTER_BREAKEVEN_TAPS / FFTFilter<FloatType>::estimateCost(FFTFILTER_BREAKEVEN_TAPS, 1);
+		costs[directEngine] = static_cast<double>(L) / M * length;
+		costs[fftEngine] = scale * FFTFilter<FloatType>::estimateCost(length, numComputedSubfilters, blockSize);
+		costs[partitionedEngine] = (blockSize > 0) ? scale * PartitionedFFTFilter<FloatType>::estimateCost(length, numComputedSubfilters, blockSize) : costs[fftEngine];
+	}
+
+	// shouldUseHalfBand() - whether the stage can use the HalfBandFilter engine (2:1 decimation, or polyphase 1:2 interpolation, with half-band taps)
+	static bool shouldUseHalfBand(int L, int M, const std::vector<FloatType>& filterTaps) {
+		return ((L == 1 && M == 2) || (L == 2 && M == 1 && isPolyphase(L, M))) &&
+				isHalfBand(filterTaps.data(), static_cast<int>(filterTaps.size()));
+	}
+
+	// interpolate() - interpolate and apply filter:
+	template<typename Filter, Filter ResamplingStage::*engine>
 	void interpolate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
 		size_t o = 0;
+
+#ifdef USE_POLYPHASE_ON_INTERPOLATE
+		// polyphase: each output is computed by its own subfilter against the (non-zero-stuffed) input history
+		Filter& f = this->*engine;
+		for (size_t i = 0; i < inBufferSize; ) {
+			int n = putBlock(f, inBuffer, i, inBufferSize);
+			int count = 0;
+			for (int age = n - 1; age >= 0; --age) {
+				for(int l = 0; l < L; ++l) {
+					outputAges[count] = age;
+					outputSubfilters[count++] = l;
+				}
+			}
+			getOutputs(f, outBuffer, o, count, L);
+			o += count;
+			i += n;
+		}
+#else
+		// zero-stuffing
 		for (size_t i = 0; i < inBufferSize; ++i) {
 			for(int l = 0; l < L; ++l) {
 
@@ -127,29 +778,88 @@ private:
 #endif
 			}
 		}
+#endif
+
 		outBufferSize = o;
 	}
 
 	// decimate() - decimate and apply filter
+	template<typename Filter, Filter ResamplingStage::*engine>
 	void decimate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		Filter& f = this->*engine;
 		size_t o = 0;
 		int localm = m;
-		for (size_t i = 0; i < inBufferSize; ++i) {
-			filter.put(inBuffer[i]);
-			if (localm == 0) {
-				outBuffer[o++] = filter.get();
-			}
-			if(++localm == M) {
-				localm = 0;
+		for (size_t i = 0; i < inBufferSize; ) {
+			int n = putBlock(f, inBuffer, i, inBufferSize);
+			int count = 0;
+			for (int j = (M - localm) % M; j < n; j += M) { // only visit the inputs which produce an output
+				outputAges[count] = n - 1 - j;
+				outputSubfilters[count++] = 0;
 			}
+			getOutputs(f, outBuffer, o, count, 1);
+			o += count;
+			localm = (localm + n) % M;
+			i += n;
 		}
 		outBufferSize = o;
 		m = localm;
 	}
 
+	// halfBandInterpolate() - 1:2 interpolation with the HalfBandFilter
+	void halfBandInterpolate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		outBufferSize = static_cast<size_t>(hbFilter.interpolate(inBuffer, static_cast<int>(inBufferSize), outBuffer));
+	}
+
+	// halfBandDecimate() - 2:1 decimation with the HalfBandFilter
+	void halfBandDecimate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		outBufferSize = static_cast<size_t>(hbFilter.decimate(inBuffer, static_cast<int>(inBufferSize), m, outBuffer));
+		m = (m + static_cast<int>(inBufferSize % 2)) % 2;
+	}
+
+	// farrowConvert() - arbitrary-ratio conversion with the FarrowFilter
+	void farrowConvert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		outBufferSize = static_cast<size_t>(farrowFilter.convert(inBuffer, static_cast<int>(inBufferSize), outBuffer));
+	}
+
+	// iirInterpolate() - 1:2 interpolation with the IIRHalfBandFilter
+	void iirInterpolate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		outBufferSize = static_cast<size_t>(iirFilter.interpolate(inBuffer, static_cast<int>(inBufferSize), outBuffer));
+	}
+
+	// iirDecimate() - 2:1 decimation with the IIRHalfBandFilter
+	void iirDecimate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		outBufferSize = static_cast<size_t>(iirFilter.decimate(inBuffer, static_cast<int>(inBufferSize), outBuffer));
+	}
+
 	// interpolateAndDecimate()
+	template<typename Filter, Filter ResamplingStage::*engine>
 	void interpolateAndDecimate(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
 		size_t o = 0;
+
+#ifdef USE_POLYPHASE_ON_INTERPOLATE_DECIMATE
+		// polyphase: only the outputs which are kept get calculated.
+		// Each output advances the phase by M; each input consumes L of it.
+		// The phase repeats every L / gcd(L, M) outputs.
+		Filter& f = this->*engine;
+		const int numPhases = L / gcd(L, M);
+		int phase = m;
+		for (size_t i = 0; i < inBufferSize; ) {
+			int n = putBlock(f, inBuffer, i, inBufferSize);
+			int count = 0;
+			for (int age = n - 1; age >= 0; --age) {
+				while (phase < L) {
+					outputAges[count] = age;
+					outputSubfilters[count++] = phase;
+					phase += M;
+				}
+				phase -= L;
+			}
+			getOutputs(f, outBuffer, o, count, numPhases);
+			o += count;
+			i += n;
+		}
+		m = phase;
+#else
 		int localm = m;
 		for (size_t i = 0; i < inBufferSize; ++i) {
 			for(int l = 0; l < L; ++l) {
@@ -170,46 +880,184 @@ private:
 				}
 			}
 		}
-		outBufferSize = o;
 		m = localm;
+#endif
+
+		outBufferSize = o;
+	}
+
+	// fixedRatioConvert() - polyphase conversion by FixedL / FixedM (in lowest terms), compiled for that ratio.
+	// The outputs come in cycles of FixedL outputs for every FixedM inputs: output j of a cycle which starts at the input of age a
+	// is produced by subfilter (j * FixedM) % FixedL from the input of age a - (j * FixedM) / FixedL. So there are no lists of outputs
+	// to build (as in interpolateAndDecimate()), the subfilters and ages of each cycle are constants, and the outputs of four cycles
+	// are calculated at once with getAt4(). Inputs before the first cycle of a block, and after the last whole cycle, are stepped through one at a time.
+	// The phase is that of interpolateAndDecimate() (for decimation, m is converted to and from it, as decimate() counts inputs instead).
+	template<int FixedL, int FixedM, typename Filter, Filter ResamplingStage::*engine>
+	void fixedRatioConvert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
+		Filter& f = this->*engine;
+		const int fs = frameSize(f);
+		int phase = (FixedL == 1) ? (FixedM - m) % FixedM : m;
+		size_t o = 0;
+
+		// step() - produces the outputs of the input of the given age
+		auto step = [&](int age) {
+			for (; phase < FixedL; phase += FixedM) {
+				getOutput(f, age, phase, outBuffer + o++ * fs);
+			}
+			phase -= FixedL;
+		};
+
+		for (size_t i = 0; i < inBufferSize; ) {
+			int n = putBlock(f, inBuffer, i, inBufferSize);
+			int age = n - 1;
+
+			// (every phase gets back to 0 within FixedM inputs, since FixedL and FixedM are coprime)
+			while (phase != 0 && age >= 0) {
+				step(age--);
+			}
+
+			const int numCycles = (age + 1) / FixedM;
+			FloatType* out = outBuffer + o * fs;
+			int c = 0;
+			for (; c + 4 <= numCycles; c += 4, age -= 4 * FixedM, out += 4 * FixedL * fs) {
+				for (int j = 0; j < FixedL; j++) {
+					const int a = age - (j * FixedM) / FixedL;
+					int ages[4] = {a, a - FixedM, a - 2 * FixedM, a - 3 * FixedM};
+					f.getAt4(ages, (j * FixedM) % FixedL, out + j * fs, FixedL);
+				}
+			}
+			for (; c < numCycles; c++, age -= FixedM, out += FixedL * fs) {
+				for (int j = 0; j < FixedL; j++) {
+					getOutput(f, age - (j * FixedM) / FixedL, (j * FixedM) % FixedL, out + j * fs);
+				}
+			}
+			o += static_cast<size_t>(numCycles) * FixedL;
+
+			while (age >= 0) {
+				step(age--);
+			}
+			i += n;
+		}
+
+		m = (FixedL == 1) ? (FixedM - phase) % FixedM : phase;
+		outBufferSize = o;
+	}
+
+	// setFixedRatioConvertFunction() - if the ratio of the stage is FixedL / FixedM, sets convertFn to the fixedRatioConvert() function for it
+	template<int FixedL, int FixedM, typename Filter, Filter ResamplingStage::*engine>
+	bool setFixedRatioConvertFunction() {
+		if (L != FixedL || M != FixedM) {
+			return false;
+		}
+		convertFn = &ResamplingStage::fixedRatioConvert<FixedL, FixedM, Filter, engine>;
+		return true;
+	}
+
+	// setFixedRatioConvertFunction() - sets convertFn to a fixedRatioConvert() function, if there is one for the ratio of the stage.
+	// The ratios are those of the common single-stage conversions (eg 44.1kHz <-> 48kHz, 48kHz <-> 96kHz, 48kHz -> 32kHz),
+	// and the factors of the preset multi-stage conversions (see getConversionStages()).
+	// (Stages whose ratio is not in lowest terms, such as those of minimum-phase conversions, use the general functions)
+	template<typename Filter, Filter ResamplingStage::*engine>
+	bool setFixedRatioConvertFunction() {
+#ifdef USE_FIXED_RATIO_KERNELS
+		if (!fixedRatioKernelsEnabled || (L != 1 && !isPolyphase(L, M))) {
+			return false;
+		}
+		return setFixedRatioConvertFunction<2, 1, Filter, engine>() ||
+				setFixedRatioConvertFunction<1, 2, Filter, engine>() ||
+				setFixedRatioConvertFunction<4, 1, Filter, engine>() ||
+				setFixedRatioConvertFunction<1, 4, Filter, engine>() ||
+				setFixedRatioConvertFunction<1, 3, Filter, engine>() ||
+				setFixedRatioConvertFunction<3, 2, Filter, engine>() ||
+				setFixedRatioConvertFunction<2, 3, Filter, engine>() ||
+				setFixedRatioConvertFunction<160, 147, Filter, engine>() ||
+				setFixedRatioConvertFunction<147, 160, Filter, engine>() ||
+				setFixedRatioConvertFunction<1, 7, Filter, engine>() ||
+				setFixedRatioConvertFunction<5, 7, Filter, engine>() ||
+				setFixedRatioConvertFunction<7, 2, Filter, engine>() ||
+				setFixedRatioConvertFunction<7, 4, Filter, engine>() ||
+				setFixedRatioConvertFunction<7, 8, Filter, engine>() ||
+				setFixedRatioConvertFunction<7, 10, Filter, engine>() ||
+				setFixedRatioConvertFunction<7, 16, Filter, engine>() ||
+				setFixedRatioConvertFunction<3, 5, Filter, engine>();
+#else
+		return false;
+#endif
+	}
+
+	void SetConvertFunction() {
+		usingFixedRatioKernel = false;
+		if (useFarrow) {
+			convertFn = bypassMode ? &ResamplingStage::passThrough : &ResamplingStage::farrowConvert;
+		}
+		else if (useIIR) {
+			convertFn = bypassMode ? &ResamplingStage::passThrough :
+					(L == 2) ? &ResamplingStage::iirInterpolate : &ResamplingStage::iirDecimate;
+		}
+		else if (useHalfBand || useFFT || usePartitioned) {
+			if (useHalfBand) {
+				convertFn = bypassMode ? &ResamplingStage::passThrough :
+						(L == 2) ? &ResamplingStage::halfBandInterpolate : &ResamplingStage::halfBandDecimate;
+			}
+			else if (usePartitioned) {
+				SetConvertFunction<PartitionedFFTFilter<FloatType>, &ResamplingStage::partitionedFilter>();
+			}
+			else {
+				SetConvertFunction<FFTFilter<FloatType>, &ResamplingStage::fftFilter>();
+			}
+			if (numChannels != 1 && !bypassMode) {
+				channelConvertFn = convertFn;
+				convertFn = &ResamplingStage::convertChannels;
+			}
+		}
+		else if (numChannels != 1) {
+			SetConvertFunction<MultichannelFIRFilter<FloatType>, &ResamplingStage::mcFilter>();
+		}
+		else {
+			SetConvertFunction<FIRFilter<FloatType>, &ResamplingStage::filter>();
+		}
 	}
 
+	template<typename Filter, Filter ResamplingStage::*engine>
 	void SetConvertFunction() {
 		if (bypassMode) {
 			convertFn = &ResamplingStage::passThrough;
 		}
+		else if (setFixedRatioConvertFunction<Filter, engine>()) {
+			usingFixedRatioKernel = true;
+		}
 		else if (L == 1 && M == 1) {
-			convertFn = &ResamplingStage::filterOnly;
+			convertFn = &ResamplingStage::filterOnly<Filter, engine>;
 		}
 		else if (L != 1 && M == 1) {
-			convertFn = &ResamplingStage::interpolate;
+			convertFn = &ResamplingStage::interpolate<Filter, engine>;
 		}
 		else if (L == 1 && M != 1) {
-			convertFn = &ResamplingStage::decimate;
+			convertFn = &ResamplingStage::decimate<Filter, engine>;
 		}
 		else {
-			convertFn = &ResamplingStage::interpolateAndDecimate;
+			convertFn = &ResamplingStage::interpolateAndDecimate<Filter, engine>;
 		}
 	}
 };
 
+// Converter : converts one channel (or a set of interleaved channels) through one or more ResamplingStages.
+// A copy of a Converter shares the filter kernels of the original (which are designed only once), but has its own filter state.
 template <typename FloatType>
 class Converter
 {
 public:
-	explicit Converter(const ConversionInfo& ci) : ci(ci), groupDelay(0.0), isBypassMode(false), gain(1.0) {
-		if (ci.outputSampleRate == ci.inputSampleRate) {
-			isBypassMode = true;
-			Converter::ci.bSingleStage = true;
-		}
+	// numChannels: number of interleaved channels to be converted together (sizes passed to convert() are then in frames)
+	// With ci.bVariableRatio, the conversion is done by the FarrowFilter (even at 1:1), and the ratio can be varied with setRatio().
+	explicit Converter(const ConversionInfo& ci, int numChannels = 1) : ci(ci), groupDelay(0.0), numChannels(numChannels), isBypassMode(false), gain(1.0) {
+		init();
+	}
 
-		if (Converter::ci.bSingleStage) {
-			isMultistage = false;
-			initSinglestage();
-		} else {
-			isMultistage = true;
-			initMultistage();
-		}
+	// stages: the conversion ratio of each stage of a multi-stage conversion, instead of those chosen by getConversionStages()
+	// (their product must be the overall conversion ratio)
+	Converter(const ConversionInfo& ci, int numChannels, const std::vector<Fraction>& stages) :
+		ci(ci), groupDelay(0.0), numChannels(numChannels), requestedStages(stages), isBypassMode(false), gain(1.0) {
+		init();
 	}
 
 	void convert(FloatType* outBuffer, size_t& outBufferSize, const FloatType* inBuffer, const size_t& inBufferSize) {
@@ -217,9 +1065,26 @@ public:
 			const FloatType* in = inBuffer; // first stage reads directly from inBuffer. Subsequent stages read from output of previous stage
 			size_t inSize = inBufferSize;
 			size_t outSize = 0;
-			for (int i = 0; i < numStages; i++) {
+			int i = 0;
+			if (numFloatStages > 0) {
+				// (mixed precision) the stages before the shaping stage convert in single precision,
+				// and the output of the last of them is widened into its (FloatType) intermediate buffer
+				assert(inBufferSize <= BUFFERSIZE);
+				std::copy(inBuffer, inBuffer + inBufferSize * numChannels, floatInputBuffer.begin());
+				const float* floatIn = floatInputBuffer.data();
+				for (; i < numFloatStages; i++) {
+					float* floatOut = floatIntermediateOutputBuffers[i].data();
+					floatStages[i].convert(floatOut, outSize, floatIn, inSize);
+					floatIn = floatOut;
+					inSize = outSize;
+				}
+				FloatType* out = intermediateOutputBuffers[numFloatStages - 1].data();
+				std::copy(floatIn, floatIn + inSize * numChannels, out);
+				in = out;
+			}
+			for (; i < numStages; i++) {
 				FloatType* out = (i == indexOfLastStage) ? outBuffer : intermediateOutputBuffers[i].data(); // last stage writes straight to outBuffer;
-				convertStages[i].convert(out, outSize, in, inSize);
+				convertStages[i - numFloatStages].convert(out, outSize, in, inSize);
 				in = out; // input of next stage is the output of this stage
 				inSize = outSize;
 			}
@@ -230,6 +1095,13 @@ public:
 		}
 	}
 
+	// setRatio() : (variable-ratio mode only) multiplies the nominal conversion ratio by factor.
+	// With ramp == true, the ratio moves smoothly to the new value over the course of the next call of convert()
+	void setRatio(double factor, bool ramp = true) {
+		assert(ci.bVariableRatio);
+		convertStages[0].setRatio(factor, ramp);
+	}
+
 	double getGroupDelay() {
 		return groupDelay;
 	}
@@ -238,15 +1110,90 @@ public:
 		return gain;
 	}
 
+	int getNumChannels() const {
+		return numChannels;
+	}
+
+	// getKernelBytes() : memory used by the filter kernels of all stages (shared by copies of this Converter)
+	size_t getKernelBytes() const {
+		size_t bytes = 0;
+		for (const auto& stage : floatStages) {
+			bytes += stage.getKernelBytes();
+		}
+		for (const auto& stage : convertStages) {
+			bytes += stage.getKernelBytes();
+		}
+		return bytes;
+	}
+
+	// getStateBytes() : memory used by the filter histories and intermediate buffers of this Converter
+	size_t getStateBytes() const {
+		size_t bytes = 0;
+		for (const auto& stage : floatStages) {
+			bytes += stage.getStateBytes();
+		}
+		for (const auto& stage : convertStages) {
+			bytes += stage.getStateBytes();
+		}
+		for (const auto& buffer : intermediateOutputBuffers) {
+			bytes += buffer.size() * sizeof(FloatType);
+		}
+		for (const auto& buffer : floatIntermediateOutputBuffers) {
+			bytes += buffer.size() * sizeof(float);
+		}
+		return bytes + floatInputBuffer.size() * sizeof(float);
+	}
+
+	// setFixedRatioKernelsEnabled() : whether the stages may use fixed-ratio conversion functions (see ResamplingStage::fixedRatioConvert())
+	void setFixedRatioKernelsEnabled(bool enabled) {
+		for (auto& stage : floatStages) {
+			stage.setFixedRatioKernelsEnabled(enabled);
+		}
+		for (auto& stage : convertStages) {
+			stage.setFixedRatioKernelsEnabled(enabled);
+		}
+	}
+
+	bool isUsingFixedRatioKernel() const {
+		return std::any_of(floatStages.begin(), floatStages.end(), [](const ResamplingStage<float>& stage) { return stage.isUsingFixedRatioKernel(); }) ||
+				std::any_of(convertStages.begin(), convertStages.end(), [](const ResamplingStage<FloatType>& stage) { return stage.isUsingFixedRatioKernel(); });
+	}
+
+	// getNumFloatStages() : (mixed precision) the number of stages converting in single precision
+	int getNumFloatStages() const {
+		return numFloatStages;
+	}
+
+	// isMultistageConversion() : whether the conversion is done by the stages of initMultistage() (and can be tuned by --autotune),
+	// rather than by a single stage, the FarrowFilter, or not at all
+	static bool isMultistageConversion(const ConversionInfo& ci) {
+		return ci.outputSampleRate != ci.inputSampleRate && !ci.bVariableRatio && !ci.bSingleStage &&
+				!shouldUseArbitraryRatio(getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate));
+	}
+
 	void reset() {
 		for (int i = 0; i < numStages; i++) {
-			convertStages[i].reset();
+			if (i < numFloatStages) {
+				floatStages[i].reset();
+				std::fill(floatIntermediateOutputBuffers[i].begin(), floatIntermediateOutputBuffers[i].end(), 0.0f);
+			} else {
+				convertStages[i - numFloatStages].reset();
+			}
 			if (i != indexOfLastStage) {
 				std::fill(intermediateOutputBuffers[i].begin(), intermediateOutputBuffers[i].end(), 0.0);
 			}
 		}
 	}
 
+	// makeStageCostFunction() : the cost function for planning the stages of a multi-stage conversion (see planConversionStages()):
+	// the estimated cost of each stage, in multiply-accumulates per output sample, with the final stage as the shaping stage
+	static StageCostFunction makeStageCostFunction(const ConversionInfo& ci) {
+		return [ci](const std::vector<Fraction>& stages, int shapingStage) {
+			std::vector<StageDesign> designs = designStages(ci, stages, shapingStage);
+			return designs.empty() ? -1.0 : estimateStageCost(ci, designs.back(), stages.back());
+		};
+	}
+
 private:
 	void initSinglestage() {
 		numStages = 1;
@@ -256,71 +1203,136 @@ private:
 		if (ci.overSamplingFactor != 1)
 			gain *= ci.overSamplingFactor;
 
-		std::vector<FloatType> filterTaps = makeFilterCoefficients<FloatType>(ci, f);
+		FilterDesignReport designReport;
+		std::vector<FloatType> filterTaps = makeFilterCoefficients<FloatType>(ci, f, &designReport);
 		f.numerator *= ci.overSamplingFactor;
 		f.denominator *= ci.overSamplingFactor;
 
-		FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()));
-		convertStages.emplace_back(f.numerator, f.denominator, firFilter, isBypassMode);
+		convertStages.emplace_back(f.numerator, f.denominator, filterTaps, isBypassMode, !ci.bMinPhase, numChannels, ci.bLowLatency ? ci.lowLatencyBlockSize : 0);
 		groupDelay = (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2 / f.denominator;
 		if (isBypassMode)
 			groupDelay = 0;
+
+		if (ci.bShowStages) {
+			designReport.print(std::cout);
+		}
+	}
+
+	// shouldUseArbitraryRatio() : whether L or M is so large that the conversion should be done by the FarrowFilter.
+	// (The size of an ordinary filter is proportional to the larger of L and M, until it is limited by FILTERSIZE_LIMIT)
+	static bool shouldUseArbitraryRatio(Fraction f) {
+		return std::max(f.numerator, f.denominator) >= FARROW_MIN_FACTOR;
+	}
+
+	void initArbitraryRatio() {
+		numStages = 1;
+		indexOfLastStage = 0;
+		Fraction f = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
+		std::vector<FloatType> filterTaps = makeArbitraryRatioCoefficients<FloatType>(ci, FARROW_NUM_PHASES);
+		FarrowFilter<FloatType> farrowFilter(filterTaps.data(), static_cast<int>(filterTaps.size()), FARROW_NUM_PHASES, f.numerator, f.denominator, numChannels);
+		convertStages.emplace_back(f.numerator, f.denominator, farrowFilter, numChannels);
+
+		// the outputs have unity gain (whereas the gain of the other engines is compensated by the caller, which applies a gain of L)
+		gain /= f.numerator;
+		groupDelay = (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2.0 / FARROW_NUM_PHASES * f.numerator / f.denominator;
+
+		if (ci.bShowStages) {
+			std::cout << "Stage: 1\n";
+			std::cout << "inputRate: " << ci.inputSampleRate << "\n";
+			std::cout << "outputRate: " << ci.outputSampleRate << "\n";
+			std::cout << "Generated Filter Size: " << filterTaps.size() << "\n";
+			std::cout << "Filtering method: " << convertStages.back().getFilteringMethod() << "\n";
+			std::cout << "Kernel memory: " << convertStages.back().getKernelBytes() / 1024 << " KB\n\n" << std::endl;
+		}
+	}
+
+	void init() {
+		if (ci.outputSampleRate == ci.inputSampleRate && !ci.bVariableRatio) {
+			isBypassMode = true;
+			ci.bSingleStage = true;
+		}
+
+		if (ci.bVariableRatio || (!isBypassMode && shouldUseArbitraryRatio(getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate)))) {
+			isMultistage = false;
+			initArbitraryRatio();
+		} else if (ci.bSingleStage) {
+			isMultistage = false;
+			initSinglestage();
+		} else {
+			isMultistage = true;
+			initMultistage();
+		}
 	}
 
 	void initMultistage() {
 		Fraction masterConversionRatio = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
-		auto fractions = getConversionStages(masterConversionRatio, ci.maxStages);
+		const bool useHalfBandStages = !ci.bMinPhase || ci.bIIR; // (FIR half-band filters are linear-phase, but IIR ones may be used with minimum phase)
+
+		// unless the stages are given, use the fastest stages (and conversion functions) found by --autotune on this machine, if any:
+		std::vector<Fraction> fractions = requestedStages;
+		bool fixedRatioKernels = true;
+		TuningEntry tuning;
+		if (fractions.empty() && lookupTuning(ci, tuning)) {
+			fractions = tuning.stages;
+			fixedRatioKernels = tuning.fixedRatioKernels;
+			if (ci.bShowStages) {
+				std::cout << "Using the stages found by --autotune (" << ci.tuningDatabase << ")\n";
+			}
+		}
+		if (fractions.empty()) {
+			fractions = getConversionStages(masterConversionRatio, ci.maxStages, useHalfBandStages, makeStageCostFunction(ci));
+		}
 		numStages = static_cast<int>(fractions.size());
 		indexOfLastStage = numStages - 1;
-		unsigned int inputRate = ci.inputSampleRate;
-		double stretch = (ci.lpfCutoff + ci.lpfTransitionWidth) / 100.0;
-		double lastStopFreq = stretch * inputRate / 2.0;
+
+		// the stage which must have the characteristics of the requested parameters is normally the last stage.
+		// However, when interpolating with 2/1 stages after the first (see getHalfBandConversionStages()),
+		// it is the first stage, so that the later stages are free to use half-band filters.
+		const int shapingStage = getShapingStage(fractions, useHalfBandStages);
+
+		// (mixed precision) the stages before the shaping stage have wider transition bands and shorter filters,
+		// and their rounding errors are well below those of the shaping stage, so they convert in single precision:
+		numFloatStages = (ci.bMixedPrecision && !std::is_same<FloatType, float>::value) ? shapingStage : 0;
+		if (numFloatStages > 0) {
+			floatInputBuffer.resize(static_cast<size_t>(BUFFERSIZE) * numChannels);
+		}
+
+		std::vector<StageDesign> designs = designStages(ci, fractions, shapingStage);
+		assert(designs.size() == fractions.size());
+
+		if (ci.bShowStages) {
+			showStagePlans(masterConversionRatio, fractions, designs);
+		}
+
 		std::string stageInputName(ci.inputFilename);
 		double ft = ci.lpfCutoff / 100 * std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
+		double stageBlockSize = ci.lowLatencyBlockSize; // (low-latency mode) input frames per block of this stage
 
 		for (int i = 0; i < numStages; i++) {
+			ConversionInfo stageCi = designs[i].stageCi;
+			const double stopFreq = designs[i].stopFreq;
+			const bool iir = designs[i].iir;
+			const double iirTransitionWidth = designs[i].iirTransitionWidth;
+			const bool halfBand = designs[i].halfBand;
+			const double halfBandTransitionWidth = designs[i].halfBandTransitionWidth;
 
-			// copy ConversionInfo for this stage from master:
-			ConversionInfo stageCi = ci;
-
-			// set input & output rates of this stage:
-			stageCi.inputSampleRate = inputRate;
-			stageCi.outputSampleRate = inputRate * fractions[i].numerator / fractions[i].denominator;
-
-			// decide whether to oversample this stage:
-			stageCi.overSamplingFactor = stageCi.bMinPhase ? 2 : 1;
 			if (stageCi.overSamplingFactor != 1) {
 				gain *= stageCi.overSamplingFactor;
 			}
 
-			// set minSampleRate and minNyquist for this stage:
-			decltype(stageCi.inputSampleRate) minSampleRate = std::min(stageCi.inputSampleRate, stageCi.outputSampleRate);
-			decltype(stageCi.inputSampleRate) minNyquist = static_cast<unsigned int>(minSampleRate / 2.0);
-
-			// determine transition frequency (cutoff) and stop frequency for this stage:
-			double stopFreq = std::max(stretch * minNyquist, minSampleRate - lastStopFreq);
-			assert(stopFreq > ft); // should always be the case for a LPF
-
-			// set transition frequency (cutoff) and transition width for this stage (they are stored as percentage values)
-			if (i == indexOfLastStage) { // last stage must have the characteristics of the requested parameters:
-				stageCi.lpfTransitionWidth = ci.lpfTransitionWidth;
-				stageCi.lpfCutoff = ci.lpfCutoff;
+			// make the filter coefficients
+			FilterDesignReport designReport;
+			std::vector<double> iirCoefficients;
+			std::vector<FloatType> filterTaps;
+			if (iir) {
+				iirCoefficients = makeIIRHalfBandCoefficients(getSidelobeAttenuation(stageCi.qualityTier, true), iirTransitionWidth);
 			}
 			else {
-				const double widthReduction = 2.0;
-				stageCi.lpfTransitionWidth = 100.0 * (stopFreq - ft) / (stageCi.outputSampleRate * 0.5) / widthReduction;
-				stageCi.lpfCutoff = 100 - stageCi.lpfTransitionWidth;
+				filterTaps = halfBand ?
+					makeHalfBandCoefficients<FloatType>(std::max(stageCi.inputSampleRate, stageCi.outputSampleRate), halfBandTransitionWidth, stageCi.qualityTier) :
+					makeFilterCoefficients<FloatType>(stageCi, fractions[i], &designReport);
 			}
 
-			assert(stageCi.lpfTransitionWidth > 0.0);
-			lastStopFreq = stopFreq; // keep this value for calculation of next stage's stopFreq
-
-			// make the filter coefficients
-			std::vector<FloatType> filterTaps = makeFilterCoefficients<FloatType>(stageCi, fractions[i]);
-
-			// make the filter
-			FIRFilter<FloatType> firFilter(filterTaps.data(), static_cast<int>(filterTaps.size()));
-
 			if (ci.bShowStages) { // dump stage parameters:
 				std::cout << "Stage: " << 1 + i << "\n";
 				std::cout << "inputRate: " << stageCi.inputSampleRate << "\n";
@@ -328,8 +1340,22 @@ private:
 				std::cout << "ft: " << ft << "\n";
 				std::cout << "stopFreq: " << stopFreq << "\n";
 				std::cout << "transition width: " << stageCi.lpfTransitionWidth << " %\n";
-				std::cout << "guarantee: " << lastStopFreq << "\n";
-				std::cout << "Generated Filter Size: " << filterTaps.size() << "\n";
+				std::cout << "guarantee: " << stopFreq << "\n";
+				if (halfBand) {
+					std::cout << "half-band transition width: " << halfBandTransitionWidth << " Hz (either side of " <<
+								 std::max(stageCi.inputSampleRate, stageCi.outputSampleRate) / 4 << ")\n";
+				}
+				if (iir) {
+					std::cout << "IIR half-band transition width: " << iirTransitionWidth * std::max(stageCi.inputSampleRate, stageCi.outputSampleRate) <<
+								 " Hz (centred on " << std::max(stageCi.inputSampleRate, stageCi.outputSampleRate) / 4 << ")\n";
+					std::ostringstream ss;
+					ss << std::fixed << std::setprecision(1) << getIIRHalfBandAttenuation(static_cast<int>(iirCoefficients.size()), iirTransitionWidth);
+					std::cout << "All-pass coefficients: " << iirCoefficients.size() << " (stopband attenuation " << ss.str() << " dB)\n";
+				}
+				else {
+					std::cout << "Generated Filter Size: " << filterTaps.size() << "\n";
+					designReport.print(std::cout);
+				}
 
 				stageCi.maxStages = 1;
 				// stageCi.bSingleStage = true; // to-do: use single-stage engine vs. multi w/ maxStages= 1 ??
@@ -355,11 +1381,24 @@ private:
 			Fraction f = fractions[i];
 			f.numerator *= stageCi.overSamplingFactor;
 			f.denominator *= stageCi.overSamplingFactor;
-			convertStages.emplace_back(f.numerator, f.denominator, firFilter, false);
+			const int stageLowLatencyBlockSize = ci.bLowLatency ? static_cast<int>(std::ceil(stageBlockSize)) : 0;
+			if (i < numFloatStages) {
+				addStage(floatStages, f, iir, iirCoefficients, std::vector<float>(filterTaps.begin(), filterTaps.end()), stageLowLatencyBlockSize, fixedRatioKernels);
+			} else {
+				addStage(convertStages, f, iir, iirCoefficients, filterTaps, stageLowLatencyBlockSize, fixedRatioKernels);
+			}
+			stageBlockSize *= static_cast<double>(fractions[i].numerator) / fractions[i].denominator;
 
 			// add Group Delay:
 			groupDelay *= (static_cast<double>(f.numerator) / f.denominator); // scale previous delay according to conversion ratio
-			groupDelay += (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2 / f.denominator; // add delay introduced by this stage
+			if (iir) {
+				// (the IIR filter's group delay varies with frequency: trim only its delay at DC)
+				IIRHalfBandFilter<FloatType> iirFilter(iirCoefficients, f.numerator == 2);
+				groupDelay += (ci.bMinPhase || !ci.bDelayTrim) ? 0 : iirFilter.getGroupDelay() / f.denominator;
+			}
+			else {
+				groupDelay += (ci.bMinPhase || !ci.bDelayTrim) ? 0 : (filterTaps.size() - 1) / 2 / f.denominator; // add delay introduced by this stage
+			}
 
 			// calculate size of output buffer for this stage:
 			double cumulativeNumerator = 1.0;
@@ -373,17 +1412,24 @@ private:
 			// conditionally show output buffer size
 			if (ci.bShowStages) {
 				//std::cout << cumulativeNumerator << " / " << cumulativeDenominator << "\n";
+				const bool floatStage = (i < numFloatStages);
+				std::cout << "Filtering method: " << (floatStage ? floatStages.back().getFilteringMethod() : convertStages.back().getFilteringMethod()) << "\n";
+				if (ci.bMixedPrecision) {
+					std::cout << "Precision: " << (floatStage || std::is_same<FloatType, float>::value ? "single" : "double") << "\n";
+				}
+				std::cout << "Kernel memory: " << (floatStage ? floatStages.back().getKernelBytes() : convertStages.back().getKernelBytes()) / 1024 << " KB\n";
 				std::cout << "Output Buffer Size: " << outBufferSize << "\n\n" << std::endl;
 			}
 
-			// make output buffer for this stage (last stage doesn't need one)
+			// make output buffer for this stage (last stage doesn't need one).
+			// (mixed precision) the single-precision stages write to their own buffers, and only the last of them also needs a FloatType buffer
+			if (i < numFloatStages) {
+				floatIntermediateOutputBuffers.emplace_back(std::vector<float>(outBufferSize * numChannels, 0.0f));
+			}
 			if (i != indexOfLastStage) {
-				intermediateOutputBuffers.emplace_back(std::vector<FloatType>(outBufferSize, 0.0));
+				intermediateOutputBuffers.emplace_back(std::vector<FloatType>(i < numFloatStages - 1 ? 0 : outBufferSize * numChannels, 0.0));
 			}
 
-			// set input rate of next stage
-			inputRate = stageCi.outputSampleRate;
-
 		} // ends loop over i
 
 		if (ci.bShowStages) {
@@ -395,10 +1441,224 @@ private:
 		}
 	} // initMultistage()
 
+	// addStage() : adds a ResamplingStage (of the given precision) to stages, with the IIR half-band filter of iirCoefficients, or with filterTaps
+	template<typename StageFloatType>
+	void addStage(std::vector<ResamplingStage<StageFloatType>>& stages, Fraction f, bool iir, const std::vector<double>& iirCoefficients,
+				  const std::vector<StageFloatType>& filterTaps, int lowLatencyBlockSize, bool fixedRatioKernels) {
+		if (iir) {
+			stages.emplace_back(f.numerator, f.denominator, IIRHalfBandFilter<StageFloatType>(iirCoefficients, f.numerator == 2, numChannels), numChannels);
+		}
+		else {
+			stages.emplace_back(f.numerator, f.denominator, filterTaps, false, !ci.bMinPhase, numChannels, lowLatencyBlockSize);
+			if (!fixedRatioKernels) {
+				stages.back().setFixedRatioKernelsEnabled(false);
+			}
+		}
+	}
+
+	// StageDesign : the filter specification of one stage of a multi-stage conversion (see designStages())
+	struct StageDesign {
+		ConversionInfo stageCi;		// the ConversionInfo for the stage (rates, cutoff and transition width, oversampling factor)
+		double stopFreq;
+		bool iir;					// whether the stage uses an IIR half-band filter ...
+		double iirTransitionWidth;	// ... with this transition width (see isIIRHalfBandStage())
+		bool halfBand;				// whether the stage uses a half-band filter ...
+		double halfBandTransitionWidth; // ... with this transition width (see isHalfBandStage())
+	};
+
+	// designStages() : the filter specifications of the stages of a multi-stage conversion (in which shapingStage is the stage which must
+	// have the characteristics of the requested parameters), or an empty result if a stage can't meet the specification.
+	// Each intermediate stage has its stop frequency as high as the previous stages allow (so that nothing they let through aliases
+	// below it), and half of the room between that and the cutoff frequency ft as its transition band.
+	static std::vector<StageDesign> designStages(const ConversionInfo& ci, const std::vector<Fraction>& fractions, int shapingStage) {
+		std::vector<StageDesign> designs;
+		unsigned int inputRate = ci.inputSampleRate;
+		double stretch = (ci.lpfCutoff + ci.lpfTransitionWidth) / 100.0;
+		double lastStopFreq = stretch * inputRate / 2.0;
+		double ft = ci.lpfCutoff / 100 * std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
+		double finalStopFreq = stretch * std::min(ci.inputSampleRate, ci.outputSampleRate) / 2.0;
+		double shapedStopFreq = 0.0; // stop frequency of the shaping stage
+
+		for (int i = 0; i < static_cast<int>(fractions.size()); i++) {
+
+			// copy ConversionInfo for this stage from master:
+			StageDesign design;
+			design.stageCi = ci;
+			ConversionInfo& stageCi = design.stageCi;
+
+			// set input & output rates of this stage:
+			stageCi.inputSampleRate = inputRate;
+			stageCi.outputSampleRate = inputRate * fractions[i].numerator / fractions[i].denominator;
+
+			// set minSampleRate and minNyquist for this stage:
+			decltype(stageCi.inputSampleRate) minSampleRate = std::min(stageCi.inputSampleRate, stageCi.outputSampleRate);
+			decltype(stageCi.inputSampleRate) minNyquist = static_cast<unsigned int>(minSampleRate / 2.0);
+
+			// determine transition frequency (cutoff) and stop frequency for this stage:
+			double stopFreq = std::max(stretch * minNyquist, minSampleRate - lastStopFreq);
+			if (!(stopFreq > ft)) { // (always the case for the stages of getConversionStages())
+				return std::vector<StageDesign>();
+			}
+
+			// set transition frequency (cutoff) and transition width for this stage (they are stored as percentage values)
+			if (i == shapingStage) { // this stage must have the characteristics of the requested parameters:
+				stageCi.lpfTransitionWidth = ci.lpfTransitionWidth;
+				stageCi.lpfCutoff = ci.lpfCutoff;
+			}
+			else {
+				const double widthReduction = 2.0;
+				stageCi.lpfTransitionWidth = 100.0 * (stopFreq - ft) / (stageCi.outputSampleRate * 0.5) / widthReduction;
+				stageCi.lpfCutoff = 100 - stageCi.lpfTransitionWidth;
+			}
+
+			if (!(stageCi.lpfTransitionWidth > 0.0)) {
+				return std::vector<StageDesign>();
+			}
+
+			// decide whether to use a half-band filter for this stage.
+			// (Its passband must extend to ft, or after the shaping stage, to everything which that stage has let through)
+			if (i == shapingStage) {
+				shapedStopFreq = stopFreq;
+			}
+			double passFreq = (i > shapingStage) ? shapedStopFreq : ft;
+
+			// with --iir, every 2:1 or 1:2 stage (including the shaping stage) uses an IIR half-band filter, provided that its passband reaches passFreq.
+			// (Its transition band is centred on a quarter of the higher rate, so that any aliasing lands between passFreq and the lower Nyquist frequency.)
+			design.iirTransitionWidth = 0.0;
+			design.iir = ci.bIIR && isIIRHalfBandStage(fractions[i], stageCi, passFreq, design.iirTransitionWidth);
+
+			design.halfBandTransitionWidth = 0.0;
+			design.halfBand = !design.iir && !ci.bMinPhase && (i != shapingStage) &&
+					isHalfBandStage(fractions[i], stageCi, stopFreq, passFreq, finalStopFreq, design.halfBandTransitionWidth);
+
+			// decide whether to oversample this stage:
+			stageCi.overSamplingFactor = (stageCi.bMinPhase && !design.iir) ? 2 : 1;
+
+			design.stopFreq = stopFreq;
+			lastStopFreq = stopFreq; // keep this value for calculation of next stage's stopFreq
+			inputRate = stageCi.outputSampleRate;
+			designs.push_back(design);
+		}
+		return designs;
+	}
+
+	// estimateStageCost() : estimated cost of a stage, in multiply-accumulates (or the equivalent) per sample of the final output of the conversion
+	// (ie the cost per input sample of the stage, scaled by its input rate relative to the final output rate).
+	// The cost per input sample is that of the engine which the stage would use (see ResamplingStage::estimateCost(), and for half-band stages, isHalfBandStage()).
+	static double estimateStageCost(const ConversionInfo& ci, const StageDesign& design, Fraction fraction) {
+		const ConversionInfo& stageCi = design.stageCi;
+		const bool decimating = (fraction.denominator == 2);
+		double costPerInput;
+		if (design.iir) {
+			// each all-pass section takes one multiply per sample at the lower rate
+			const auto numCoefficients = static_cast<double>(makeIIRHalfBandCoefficients(getSidelobeAttenuation(stageCi.qualityTier, true), design.iirTransitionWidth).size());
+			costPerInput = decimating ? numCoefficients / 2.0 : numCoefficients;
+		}
+		else if (design.halfBand) {
+			const double halfBandTaps = getHalfBandFilterSize(std::max(stageCi.inputSampleRate, stageCi.outputSampleRate), design.halfBandTransitionWidth, stageCi.qualityTier);
+			costPerInput = decimating ? (halfBandTaps + 5) / 8.0 : (halfBandTaps + 5) / 4.0;
+		}
+		else {
+			const int os = stageCi.overSamplingFactor;
+			const int blockSize = ci.bLowLatency ?
+						static_cast<int>(std::ceil(static_cast<double>(ci.lowLatencyBlockSize) * stageCi.inputSampleRate / ci.inputSampleRate)) : 0;
+			costPerInput = ResamplingStage<FloatType>::estimateCost(fraction.numerator * os, fraction.denominator * os, getFilterSize(stageCi, fraction), blockSize);
+		}
+		return costPerInput * stageCi.inputSampleRate / ci.outputSampleRate;
+	}
+
+	// showStagePlans() : (--showStages) shows the estimated cost of the chosen stages, and of the cheapest alternatives found by the planner
+	void showStagePlans(Fraction masterConversionRatio, const std::vector<Fraction>& fractions, const std::vector<StageDesign>& designs) const {
+		const int numAlternatives = 3;
+		double cost = 0.0;
+		std::ostringstream stageCosts;
+		stageCosts << std::fixed << std::setprecision(1);
+		for (size_t i = 0; i < fractions.size(); i++) {
+			double stageCost = estimateStageCost(ci, designs[i], fractions[i]);
+			cost += stageCost;
+			stageCosts << (i == 0 ? "" : " + ") << stageCost;
+		}
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Stage plan: ";
+		dumpFractionList(fractions);
+		std::cout << " (estimated cost: " << cost << " multiply-accumulates per output sample = " << stageCosts.str() << ")\n";
+
+		auto plans = planConversionStages(masterConversionRatio, ci.maxStages, makeStageCostFunction(ci), numAlternatives + 1);
+		int numShown = 0;
+		for (const auto& plan : plans) {
+			bool isChosen = plan.stages.size() == fractions.size() &&
+					std::equal(fractions.begin(), fractions.end(), plan.stages.begin(), [](const Fraction& a, const Fraction& b) {
+						return a.numerator == b.numerator && a.denominator == b.denominator;
+					});
+			if (!isChosen && numShown < numAlternatives) {
+				std::cout << "Alternative plan: ";
+				dumpFractionList(plan.stages);
+				std::cout << " (estimated cost: " << plan.cost << ")\n";
+				numShown++;
+			}
+		}
+		std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+	}
+
+	// isHalfBandStage() : whether a 2:1 (or 1:2) stage (other than the shaping stage) should use a half-band filter, and if so,
+	// its transition width (see getHalfBandFilterSize()).
+	// A half-band filter has its cutoff at a quarter of the higher rate (highRate), and is symmetric about it,
+	// so it is only possible if the stage may let through frequencies beyond the Nyquist frequency of the lower rate:
+	// - when interpolating, images of the (already filtered) input can't appear below highRate / 2 - lastStopFreq (which is stopFreq)
+	// - when decimating (ahead of the shaping stage), anything aliased to above finalStopFreq doesn't survive the later stages
+	// The transition bands (either side of the cutoff) must also stay clear of passFreq; as with the other intermediate stages,
+	// the transition width is half of the room available. Finally, the half-band filter must be cheaper (in multiplies per
+	// input sample) than the ordinary filter for the stage.
+	static bool isHalfBandStage(Fraction fraction, const ConversionInfo& stageCi, double stopFreq, double passFreq, double finalStopFreq, double& transitionWidth) {
+		if (!((fraction.numerator == 1 && fraction.denominator == 2) || (fraction.numerator == 2 && fraction.denominator == 1))) {
+			return false;
+		}
+
+		const bool decimating = (fraction.denominator == 2);
+		const double highRate = std::max(stageCi.inputSampleRate, stageCi.outputSampleRate);
+		const double cutoff = highRate / 4.0;
+		double halfBandStopFreq = stopFreq;
+		if (decimating && stageCi.outputSampleRate > finalStopFreq) {
+			halfBandStopFreq = std::max(stopFreq, stageCi.outputSampleRate - finalStopFreq);
+		}
+
+		const double widthReduction = 2.0;
+		transitionWidth = std::min(cutoff - passFreq, halfBandStopFreq - cutoff) / widthReduction;
+		if (transitionWidth <= 0.0) {
+			return false;
+		}
+
+		// multiplies per input sample (both engines exploit the symmetry of the taps when decimating, and the half-band filter also when interpolating)
+		double directTaps = getFilterSize(stageCi, fraction);
+		double halfBandTaps = getHalfBandFilterSize(highRate, transitionWidth, stageCi.qualityTier);
+		double directCost = decimating ? directTaps / 4.0 : directTaps;
+		double halfBandCost = decimating ? (halfBandTaps + 5) / 8.0 : (halfBandTaps + 5) / 4.0;
+		return halfBandCost < directCost;
+	}
+
+	// isIIRHalfBandStage() : whether a 2:1 (or 1:2) stage can use an IIR half-band filter (see IIRHalfBandFilter.h) with its passband extending to passFreq,
+	// and if so, its transition width (as a fraction of the higher rate).
+	static bool isIIRHalfBandStage(Fraction fraction, const ConversionInfo& stageCi, double passFreq, double& transitionWidth) {
+		if (!((fraction.numerator == 1 && fraction.denominator == 2) || (fraction.numerator == 2 && fraction.denominator == 1))) {
+			return false;
+		}
+
+		const double highRate = std::max(stageCi.inputSampleRate, stageCi.outputSampleRate);
+		transitionWidth = 0.5 - 2.0 * passFreq / highRate;
+		return transitionWidth > 0.0;
+	}
+
 private:
 	ConversionInfo ci;
 	double groupDelay;
-	std::vector<ResamplingStage<FloatType>> convertStages;
+	int numChannels;
+	std::vector<Fraction> requestedStages;	// (if not empty) the stages of the multi-stage conversion
+	std::vector<ResamplingStage<FloatType>> convertStages;	// (mixed precision: after the first numFloatStages stages)
+	int numFloatStages{};	// (mixed precision) number of stages converting in single precision (see initMultistage())
+	std::vector<ResamplingStage<float>> floatStages;
+	std::vector<float> floatInputBuffer;	// (mixed precision) the input, narrowed to single precision
+	std::vector<std::vector<float>> floatIntermediateOutputBuffers;
 	int numStages{};
 	int indexOfLastStage{};
 	std::vector<std::vector<FloatType>> intermediateOutputBuffers;	// intermediate output buffer for each ConvertStage;
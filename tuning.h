@@ -0,0 +1,169 @@
+/*
+* Copyright (C) 2016 - 2020 Judd Niemann - All Rights Reserved.
+* You may use, distribute and modify this code under the
+* terms of the GNU Lesser General Public License, version 2.1
+*
+* You should have received a copy of GNU Lesser General Public License v2.1
+* with this file. If not, please refer to: https://github.com/jniemann66/ReSampler
+*/
+
+// tuning.h : the tuning database, which holds the fastest way (found by --autotune) of doing each conversion on this machine
+
+#ifndef RESAMPLER_TUNING_H
+#define RESAMPLER_TUNING_H 1
+
+#include "conversioninfo.h"
+#include "fraction.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ReSampler {
+
+// TuningEntry : the fastest configuration of a multi-stage conversion, as measured by --autotune
+struct TuningEntry {
+	std::vector<Fraction> stages;	// conversion ratio of each stage
+	int blockSize;					// input frames per call of Converter::convert()
+	bool fixedRatioKernels;			// whether the fixed-ratio conversion functions are used (see ResamplingStage::fixedRatioConvert())
+	double nsPerOutput;				// measured time per output sample (for information)
+};
+
+// getDefaultTuningDatabasePath() : $RESAMPLER_TUNING if set, otherwise .resampler-tuning in the home directory (empty if there is none)
+inline std::string getDefaultTuningDatabasePath() {
+	if (const char* path = std::getenv("RESAMPLER_TUNING")) {
+		return path;
+	}
+#if defined (_WIN32) || defined (_WIN64)
+	const char* home = std::getenv("USERPROFILE");
+	const char separator = '\\';
+#else
+	const char* home = std::getenv("HOME");
+	const char separator = '/';
+#endif
+	return (home == nullptr) ? std::string{} : std::string(home) + separator + ".resampler-tuning";
+}
+
+// getTuningKey() : the key of a conversion in the tuning database: the rates, the precision, and every parameter which affects the choice of stages
+// (eg "44100>48000,float,archival,lpf=95.4545/4.54545,maxStages=3")
+inline std::string getTuningKey(const ConversionInfo& ci) {
+	std::ostringstream ss;
+	ss << ci.inputSampleRate << ">" << ci.outputSampleRate
+	   << "," << (ci.bMixedPrecision ? "mixed" : (ci.bUseDoublePrecision ? "double" : "float"))
+	   << "," << getQualityTierName(ci.qualityTier)
+	   << ",lpf=" << ci.lpfCutoff << "/" << ci.lpfTransitionWidth
+	   << ",maxStages=" << ci.maxStages;
+	if (ci.bWideAccumulation) {
+		ss << ",wideAccumulation";
+	}
+	if (ci.bMinPhase) {
+		ss << ",minphase";
+	}
+	if (ci.bEquiripple) {
+		ss << ",equiripple=" << ci.equiripplePassbandRipple;
+	}
+	if (ci.bIIR) {
+		ss << ",iir";
+	}
+	if (ci.bLowLatency) {
+		ss << ",lowLatency=" << ci.lowLatencyBlockSize;
+	}
+	return ss.str();
+}
+
+// formatTuningEntry() : one line of the tuning database: <key> <stages> <block size> <fixed-ratio kernels (0/1)> <ns per output sample>
+// (eg "48000>44100,float,archival,lpf=95.4545/4.54545,maxStages=3 147/160 8192 1 7.21")
+inline std::string formatTuningEntry(const std::string& key, const TuningEntry& entry) {
+	std::ostringstream ss;
+	ss << key << " ";
+	for (size_t i = 0; i < entry.stages.size(); i++) {
+		ss << (i == 0 ? "" : ",") << entry.stages[i].numerator << "/" << entry.stages[i].denominator;
+	}
+	ss << " " << entry.blockSize << " " << (entry.fixedRatioKernels ? 1 : 0) << " " << entry.nsPerOutput;
+	return ss.str();
+}
+
+// parseTuningEntry() : reads a line of the tuning database. Returns false if the line is not an entry
+inline bool parseTuningEntry(const std::string& line, std::string& key, TuningEntry& entry) {
+	std::istringstream ss(line);
+	std::string stages;
+	int fixedRatioKernels;
+	if (!(ss >> key >> stages >> entry.blockSize >> fixedRatioKernels >> entry.nsPerOutput) || key[0] == '#') {
+		return false;
+	}
+	entry.fixedRatioKernels = (fixedRatioKernels != 0);
+	entry.stages.clear();
+	std::istringstream stagesStream(stages);
+	std::string stage;
+	while (std::getline(stagesStream, stage, ',')) {
+		Fraction f;
+		char slash;
+		std::istringstream fs(stage);
+		if (!(fs >> f.numerator >> slash >> f.denominator) || slash != '/' || f.numerator <= 0 || f.denominator <= 0) {
+			return false;
+		}
+		entry.stages.push_back(f);
+	}
+	return !entry.stages.empty() && entry.blockSize > 0;
+}
+
+// lookupTuning() : finds the entry for the conversion in the tuning database ci.tuningDatabase (if any).
+// Returns false if there is no usable entry (including one whose stages don't multiply to the conversion ratio, eg after the file was edited)
+inline bool lookupTuning(const ConversionInfo& ci, TuningEntry& entry) {
+	if (ci.tuningDatabase.empty()) {
+		return false;
+	}
+	std::ifstream f(ci.tuningDatabase);
+	const std::string key = getTuningKey(ci);
+	std::string line;
+	while (std::getline(f, line)) {
+		std::string lineKey;
+		if (parseTuningEntry(line, lineKey, entry) && lineKey == key) {
+			long long numerator = 1;
+			long long denominator = 1;
+			for (const Fraction& stage : entry.stages) {
+				numerator *= stage.numerator;
+				denominator *= stage.denominator;
+			}
+			Fraction f = getFractionFromSamplerates(ci.inputSampleRate, ci.outputSampleRate);
+			return numerator * f.denominator == denominator * f.numerator;
+		}
+	}
+	return false;
+}
+
+// storeTuning() : adds the entry for the conversion to the tuning database ci.tuningDatabase (replacing any previous entry for it).
+// Returns false if the file couldn't be written
+inline bool storeTuning(const ConversionInfo& ci, const TuningEntry& entry) {
+	if (ci.tuningDatabase.empty()) {
+		return false;
+	}
+	const std::string key = getTuningKey(ci);
+	std::vector<std::string> lines;
+	std::ifstream in(ci.tuningDatabase);
+	std::string line;
+	while (std::getline(in, line)) {
+		std::string lineKey;
+		TuningEntry lineEntry;
+		if (!parseTuningEntry(line, lineKey, lineEntry) || lineKey != key) {
+			lines.push_back(line);
+		}
+	}
+	in.close();
+	if (lines.empty()) {
+		lines.emplace_back("# ReSampler tuning database (written by --autotune): <conversion> <stages> <block size> <fixed-ratio kernels> <ns per output sample>");
+	}
+	lines.push_back(formatTuningEntry(key, entry));
+
+	std::ofstream out(ci.tuningDatabase, std::ios::trunc);
+	for (const auto& l : lines) {
+		out << l << "\n";
+	}
+	return static_cast<bool>(out);
+}
+
+} // namespace ReSampler
+
+#endif // RESAMPLER_TUNING_H